@@ -24,6 +24,7 @@ class EcalSupervisorTBDataFormatter;
 class CamacTBDataFormatter;
 class TableDataFormatter;
 class MatacqTBDataFormatter;
+class EcalDCCEventSummary;
 
   class EcalDCCTB07UnpackingModule: public edm::EDProducer {
   public:
@@ -53,6 +54,16 @@ class MatacqTBDataFormatter;
     bool ProduceEEDigis_;
     bool ProduceEBDigis_;
     edm::InputTag fedRawDataCollectionTag_;
+
+    // largest size of each DCC output collection over the events so far:
+    // the collections of the next event are reserved to it
+    enum dccCollections{ EBDIGIS, EEDIGIS, PNDIGIS, DCCHEADERS, TRIGGERPRIMITIVES,
+			 DCCSIZE, TTID, BLOCKSIZE, CHID, GAIN, GAINSWITCH,
+			 MEMTTID, MEMBLOCKSIZE, MEMGAIN, MEMCHID, NCOLLECTIONS };
+    size_t collectionSizes_[NCOLLECTIONS];
+
+    // optional per DCC event summary file (0: not written)
+    EcalDCCEventSummary* summary_;
   };
 
 #endif
@@ -16,13 +16,18 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 
+class FEDRawDataCollection;
 class EcalTBDaqFormatter;
+struct EcalDCCTBFedProducts;
+class EcalDCCTBUnpackingPool;
 class EcalSupervisorTBDataFormatter;
 class CamacTBDataFormatter;
 class TableDataFormatter;
 class MatacqTBDataFormatter;
+class EcalDCCEventSummary;
 
   class EcalDCCTBUnpackingModule: public edm::EDProducer {
   public:
@@ -43,12 +48,33 @@ class MatacqTBDataFormatter;
 
   private:
 
+    /// Decodes the DCC FEDs of the event into fedProducts_ on numbThreads_ threads
+    void decodeDCCFeds(const FEDRawDataCollection & rawdata);
+
     EcalTBDaqFormatter* formatter_;
     EcalSupervisorTBDataFormatter* ecalSupervisorFormatter_;
     CamacTBDataFormatter* camacTBformatter_;
     TableDataFormatter* tableFormatter_;
     MatacqTBDataFormatter* matacqFormatter_;
     edm::InputTag fedRawDataCollectionTag_;
+
+    // largest size of each DCC output collection over the events so far:
+    // the collections of the next event are reserved to it
+    enum dccCollections{ EBDIGIS, PNDIGIS, DCCHEADERS, TRIGGERPRIMITIVES,
+			 DCCSIZE, TTID, BLOCKSIZE, CHID, GAIN, GAINSWITCH,
+			 MEMTTID, MEMBLOCKSIZE, MEMGAIN, MEMCHID, NCOLLECTIONS };
+    size_t collectionSizes_[NCOLLECTIONS];
+
+    // optional per DCC event summary file (0: not written)
+    EcalDCCEventSummary* summary_;
+
+    // parallel DCC unpacking: one formatter per thread (threadFormatters_[0] is formatter_)
+    // and the products of each DCC FED, merged in FED order
+    unsigned numbThreads_;
+    std::vector<EcalTBDaqFormatter*> threadFormatters_;
+    std::vector<EcalDCCTBFedProducts*> fedProducts_;
+    // threads kept for the whole job, woken for each event (0: serial unpacking)
+    EcalDCCTBUnpackingPool* pool_;
   };
 
 #endif
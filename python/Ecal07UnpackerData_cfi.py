@@ -52,6 +52,21 @@ ecalEBunpacker = cms.EDProducer("EcalDCCTB07UnpackingModule",
         5, 5, 5, 5, 5, 
         6, 6, 6, 6, 6),
     produceEBdigi = cms.untracked.bool(False),
+    # decode the DCC events into flat arrays (no block objects)
+    soaDecoding = cms.untracked.bool(False),
+    # file of one row of header fields and error counts per DCC event (empty: not written)
+    summaryFile = cms.untracked.string(''),
+    # warnings emitted in full per category, the others are counted and summarized
+    maxWarnings = cms.untracked.uint32(10),
+    warningSummaryInterval = cms.untracked.uint32(1000),
+    # DCC data format: samples per crystal, trigger samples, TTs, SR flags and block ids
+    numbXtalSamples = cms.untracked.uint32(10),
+    numbTriggerSamples = cms.untracked.uint32(1),
+    numbTTs = cms.untracked.uint32(68),
+    numbSRF = cms.untracked.uint32(68),
+    dccId = cms.untracked.uint32(1),
+    srpId = cms.untracked.uint32(1),
+    tccIds = cms.untracked.vuint32(1, 2, 3, 4),
     ics = cms.untracked.vint32(1, 2, 3, 4, 5, 
         6, 7, 8, 9, 10, 
         21, 22, 23, 24, 25, 
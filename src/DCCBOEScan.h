@@ -0,0 +1,67 @@
+#ifndef DCCTBBOESCAN_HH
+#define DCCTBBOESCAN_HH
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/*----------------------------------------------------------*/
+/* DCC BOE SCAN                                             */
+/* looks for the begin of event nibble (bits 28-31 of the   */
+/* 2nd 32 bit word of a 64 bit word, as in the first word   */
+/* of the DAQ header) over a buffer of 64 bit words, 8 of   */
+/* them per step with SSE2 when the compiler targets it,    */
+/* with scalar code otherwise                               */
+/* Note: this class is defined inline                       */
+/*----------------------------------------------------------*/
+class DCCTBBOEScan{
+public :
+
+  enum boeFields{
+    BOEBEGIN = 28,
+    BOEMASK  = 0xF,
+    BOE      = 0x5
+  };
+
+  /**
+     Index of the first of numbDWords 64 bit words from from with the BOE nibble
+     (numbDWords if none)
+  */
+  static uint32_t findBOE(const uint32_t * from, uint32_t numbDWords){
+
+    uint32_t dw = 0;
+
+#ifdef __SSE2__
+    const __m128i boe = _mm_set1_epi32(BOE);
+
+    for( ; dw + LANES <= numbDWords; dw += LANES){
+      const __m128i * p = (const __m128i *)(from + dw*2);
+
+      // one 0xFFFFFFFF lane per 32 bit word with the BOE nibble, packed to 16 bytes
+      __m128i w0 = _mm_cmpeq_epi32( _mm_srli_epi32(_mm_loadu_si128(p),   BOEBEGIN), boe );
+      __m128i w1 = _mm_cmpeq_epi32( _mm_srli_epi32(_mm_loadu_si128(p+1), BOEBEGIN), boe );
+      __m128i w2 = _mm_cmpeq_epi32( _mm_srli_epi32(_mm_loadu_si128(p+2), BOEBEGIN), boe );
+      __m128i w3 = _mm_cmpeq_epi32( _mm_srli_epi32(_mm_loadu_si128(p+3), BOEBEGIN), boe );
+      __m128i packed = _mm_packs_epi16( _mm_packs_epi32(w0,w1), _mm_packs_epi32(w2,w3) );
+
+      // odd 32 bit words only (2nd word of each 64 bit word)
+      uint32_t found = _mm_movemask_epi8(packed) & 0xAAAA;
+      if( found ){ return dw + (__builtin_ctz(found) >> 1); }
+    }
+#endif
+
+    for( ; dw < numbDWords; dw++){
+      if( ( (from[dw*2+1] >> BOEBEGIN) & BOEMASK ) == BOE ){ return dw; }
+    }
+    return numbDWords;
+  }
+
+protected :
+
+  enum sse2Sizes{ LANES = 8 };
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef DCCTBBLOCKPOOL_HH
+#define DCCTBBLOCKPOOL_HH
+
+#include <vector>
+#include <stdint.h>
+
+
+/*----------------------------------------------------------*/
+/* DCC BLOCK POOL                                           */
+/* recycles the block objects of one type between buffers:  */
+/* get() returns the next free block (allocated only when   */
+/* the pool is exhausted), releaseAll() makes all the       */
+/* blocks free again without deleting them                  */
+/* Note: this class is defined inline                       */
+/*----------------------------------------------------------*/
+template <class T> class DCCTBBlockPool{
+public :
+
+  DCCTBBlockPool() : used_(0), allocations_(0) { }
+
+  /**
+     Class destructor (deletes all the blocks ever allocated)
+  */
+  ~DCCTBBlockPool(){
+    typename std::vector<T *>::iterator it;
+    for(it = blocks_.begin(); it != blocks_.end(); it++){ delete (*it); }
+  }
+
+  /**
+     Returns a free block, to be set up with its initialize method
+  */
+  T * get(){
+    if( used_ == blocks_.size() ){ blocks_.push_back( new T() ); allocations_++; }
+    return blocks_[used_++];
+  }
+
+  /**
+     Makes all the blocks free again (blocks given by get() must not be used anymore)
+  */
+  void releaseAll(){ used_ = 0; }
+
+  uint32_t used()        { return used_;          }
+  uint32_t capacity()    { return blocks_.size(); }
+
+  /**
+     Number of blocks allocated since the last call to resetAllocations
+  */
+  uint32_t allocations() { return allocations_;   }
+  void resetAllocations(){ allocations_ = 0;      }
+
+protected :
+  std::vector<T *> blocks_;
+  uint32_t used_;
+  uint32_t allocations_;
+};
+
+#endif
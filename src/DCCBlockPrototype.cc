@@ -8,6 +8,20 @@
 
 
 DCCTBBlockPrototype::DCCTBBlockPrototype(DCCTBDataParser * parser, std::string name, uint32_t * buffer, uint32_t numbBytes, uint32_t wordsToEndOfEvent,  uint32_t wordEventOffset ){
+	
+	initialize(parser, name, buffer, numbBytes, wordsToEndOfEvent, wordEventOffset);
+}
+
+
+
+DCCTBBlockPrototype::DCCTBBlockPrototype(){
+	
+	initialize(0, "", 0, 0, 0, 0);
+}
+
+
+
+void DCCTBBlockPrototype::initialize(DCCTBDataParser * parser, std::string name, uint32_t * buffer, uint32_t numbBytes, uint32_t wordsToEndOfEvent,  uint32_t wordEventOffset ){
 			
 	blockError_        = false;
 	parser_            = parser;
@@ -17,9 +31,21 @@ DCCTBBlockPrototype::DCCTBBlockPrototype(DCCTBDataParser * parser, std::string n
 	blockSize_         = numbBytes ;
 	wordEventOffset_   = wordEventOffset;
 	wordsToEndOfEvent_ = wordsToEndOfEvent;
+	fieldTable_        = 0;
+	lazy_              = false;
+	mapperFields_      = 0;
 	
 	wordCounter_ = 0;
 	
+	errorString_.clear();
+	blockErrors_.clear();
+	renderedErrors_ = 0;
+	blockString_.clear();
+	processingString_.clear();
+	
+	// a recycled block keeps its error counters, reset them
+	for(uint32_t c = 0; c < DCCTBErrorCounters::NUMBCATEGORIES; c++){ errors_[c] = 0; }
+	
 	/*
 	std::cout<<std::endl;
 	std::cout<<" DEBUG::DCCTBBlockPrototype:: Block Name                  :   "<<name_<<std::endl;
@@ -33,64 +59,57 @@ DCCTBBlockPrototype::DCCTBBlockPrototype(DCCTBDataParser * parser, std::string n
 }
 
 
-void DCCTBBlockPrototype::parseData(){
-  std::set<DCCTBDataField *,DCCTBDataFieldComparator>::iterator it;          //iterator for data fields
+bool DCCTBBlockPrototype::parseData(){
+	
+  //compiled view of the mapper fields: values are stored by slot
+  fieldTable_ = parser_->mapper()->fieldTable(mapperFields_);
+  uint32_t numbSlots = fieldTable_->size();
+  fieldValues_.assign(numbSlots,0);
+  fieldDecoded_.assign(numbSlots,0);
+	
+  //lazy mode: if the whole block is in scope just move to its last field word, 
+  //fields are extracted on first access (see decodedSlot). Otherwise decode it 
+  //field by field to report the same error as the eager mode
+  //projection: same, with the projected fields of the table decoded right away
+  lazy_ = false;
+  if( parser_->lazyDecoding() || fieldTable_->projected() ){
+    uint32_t lastWord = fieldTable_->lastWordPosition();
+    uint32_t numb     = lastWord > wordCounter_ ? lastWord - wordCounter_ : 0;
+    if( numb == 0 || seeIfIsPossibleToIncrement(numb) ){
+      uint32_t numbWords = fieldTable_->numbProjectedWords();
+      for(uint32_t w = 0; w < numbWords; w++){
+        const DCCTBWordPlan & word = fieldTable_->projectedWordPlan(w);
+        decodeFields( &fieldTable_->projectedPlan(word.first), word.numbFields, beginOfBuffer_[word.word] );
+      }
+      dataP_ += numb; wordCounter_ += numb;
+      lazy_ = true;
+      return true;
+    }
+  }
 	
   //for debug purposes
   //std::cout << "Starting to parse data in block named : " << std::endl;
   //std::cout << " Fields: " << std::dec << (mapperFields_->size()) << std::endl;	
   //std::cout << "\n begin of buffer : "<<hex<<(*beginOfBuffer_)<<std::endl;
   
-  //cycle through mapper fields
-  for(it = mapperFields_->begin(); it!= mapperFields_->end(); it++){
-	
-	/*	
-    //for debug purposes
-    std::cout << "\n Field name        : " << (*it)->name();
-    std::cout << "\n Word position     : " <<std::dec<< (*it)->wordPosition();
-    std::cout << "\n Bit position      : " << (*it)->bitPosition();
-    std::cout << "\n Size              : " << hex << (*it)->mask() << std::endl;
-    std::cout << "\n data pointer      : " <<hex<<(*dataP_)<<std::endl;
-    std::cout << "\n wordsToEndOfEvent : " <<std::dec<<wordsToEndOfEvent_<<std::endl;
-	*/	
-		
-    try{
-      uint32_t data = getDataWord( (*it)->wordPosition() , (*it)->bitPosition(),(*it)->mask());
-      dataFields_[(*it)->name()]= data;
-      	
-    }catch( ECALTBParserBlockException & e){
-			
-      std::string localString;
-      
-      localString +="\n ======================================================================\n"; 		
-      localString += std::string(" ") + name_ + std::string(" :: out of scope Error :: Unable to get data field : ") + (*it)->name();
-      localString += "\n Word position inside block   : " + parser_->getDecString( (*it)->wordPosition() );
-      localString += "\n Word position inside event   : " + parser_->getDecString( (*it)->wordPosition() + wordEventOffset_);
-      localString += "\n Block Size [bytes]           : " + parser_->getDecString(blockSize_);
-      localString += "\n Action -> Stop parsing this block !";
-      localString += "\n ======================================================================";
-			
-      std::string error("\n Last decoded fields until error : ");
-			
-      std::ostringstream a;
-      
-      try{ displayData(a);}
-      catch(ECALTBParserBlockException &e){}
-     
-      std::string outputErrorString(a.str());
-      error += outputErrorString;
-			
-      errorString_ +=  localString + error;
-       
-      blockError_ = true;
-      
-      throw( ECALTBParserBlockException(errorString_) );
-      
-    }		
+  //cycle through the words of the block: each word is loaded once and all its fields
+  //are extracted from it, following the extraction plan of the field table
+  uint32_t numbWords = fieldTable_->numbWords();
+  for(uint32_t w = 0; w < numbWords; w++){
+    const DCCTBWordPlan & word = fieldTable_->wordPlan(w);
+	
+    //out of scope: the error is recorded (on the first field of the word), its text is only built by errorString()
+    if( word.word > wordCounter_ && !increment(word.word - wordCounter_) ){
+      addError(DCCTBBlockError::OUTOFSCOPE, this, fieldTable_->field(word.first)->id(), word.word + wordEventOffset_, blockSize_);
+      return false;
+    }
+    
+    decodeFields( &fieldTable_->plan(word.first), word.numbFields, *dataP_ );
   }
   
   //debugg
   //displayData(std::cout);
+  return true;
 }
 
 
@@ -103,7 +122,11 @@ uint32_t DCCTBBlockPrototype::getDataWord(uint32_t wordPosition, uint32_t bitPos
 	    <<"\n DEBUG::DCCTBBlockPrototype wordCounter        = "<<wordCounter_
 	    <<"\n DEBUG::DCCTBBlockPrototype going to increment = "<<(wordPosition-wordCounter_)<<std::endl;
 	*/
-	if( wordPosition > wordCounter_ ){ increment(wordPosition - wordCounter_);	}
+	if( wordPosition > wordCounter_ && !increment(wordPosition - wordCounter_) ){
+		std::string error=std::string("\n Unable to get next block position (parser stoped!)");
+		error += "\n Decoded fields untill error : " + displayText();
+		throw ECALTBParserBlockException(error);
+	}
 
 	return ((*dataP_)>>bitPosition)&mask;
 	
@@ -111,41 +134,28 @@ uint32_t DCCTBBlockPrototype::getDataWord(uint32_t wordPosition, uint32_t bitPos
 
 
 
-void DCCTBBlockPrototype::increment(uint32_t numb,std::string msg){
+bool DCCTBBlockPrototype::increment(uint32_t numb){
 	
-	seeIfIsPossibleToIncrement(numb,msg);
+	if( !seeIfIsPossibleToIncrement(numb) ){ return false; }
 	dataP_ += numb; wordCounter_ += numb;
+	return true;
 }
 
 
 
-void DCCTBBlockPrototype::seeIfIsPossibleToIncrement(uint32_t numb, std::string msg){
+bool DCCTBBlockPrototype::seeIfIsPossibleToIncrement(uint32_t numb){
 	
 	/*
-	std::cout<<"\n See if is possible to increment numb ="<<std::dec<<numb<<" msg "<<msg<<std::endl;
+	std::cout<<"\n See if is possible to increment numb ="<<std::dec<<numb<<std::endl;
 	std::cout<<" wordCounter_       "<<wordCounter_<<std::endl;
 	std::cout<<" blockSize          "<<blockSize_<<std::endl;
 	std::cout<<" wordsToEndOfEvent_ "<<wordsToEndOfEvent_<<std::endl;
 	*/
 	
-	if (( ((wordCounter_+numb +1) > blockSize_/4)) ||( wordCounter_ + numb > wordsToEndOfEvent_ )){ 
-			
-		std::string error=std::string("\n Unable to get next block position (parser stoped!)") +msg;
-		error += "\n Decoded fields untill error : ";
-		//ostream dataUntilError ;
-		std::ostringstream a;
-		std::string outputErrorString;
-		
-		
-		try{ displayData(a);}
-		catch(ECALTBParserBlockException &e){}
-		outputErrorString = a.str();
-		error += outputErrorString;
-		
-		throw ECALTBParserBlockException(error); 
-		blockError_=true;
-	}
-	
+	// written not to wrap around when numb is huge (e.g. tower length 0 -> numb = 2*0-1)
+	uint32_t blockWords = blockSize_/4;
+	return wordCounter_ < blockWords && numb < blockWords - wordCounter_
+		&& wordCounter_ <= wordsToEndOfEvent_ && numb <= wordsToEndOfEvent_ - wordCounter_;
 }
 
 
@@ -169,7 +179,7 @@ void DCCTBBlockPrototype::displayData(  std::ostream & os  ){
 			  os << "\n W["<<std::setw(5)<<std::setfill('0')<<currentPosition<<"]" ;
 				position = currentPosition; 
 			}
-			os<<" "<<formatString(dataFieldName,14)<<" = "<<std::dec<<std::setw(5)<<getDataField(dataFieldName); 			
+			os<<" "<<formatString(dataFieldName,14)<<" = "<<std::dec<<std::setw(5)<<getDataField((*it)->id()); 			
 		} catch (ECALTBParserBlockException & e){ process = false; os<<" not able to get data field..."<<dataFieldName<<std::endl;}
 	}
 	os<<"\n ======================================================================\n"; 
@@ -180,6 +190,168 @@ void DCCTBBlockPrototype::displayData(  std::ostream & os  ){
 
 
 
+bool DCCTBBlockPrototype::checkField(DCCTBFieldId id, uint32_t expected){
+	
+	uint32_t parsedData = getDataField(id);
+	if( parsedData == expected ){ return true; }
+	
+	addError(DCCTBBlockError::FIELD, this, id, 0, expected, parsedData);
+	return false;
+}
+
+
+
+void DCCTBBlockPrototype::endChecks(uint32_t firstError, DCCTBBlockError::errorType type, uint32_t id){
+	
+	uint32_t numbFields = blockErrors_.size() - firstError;
+	if( numbFields ){ addError(type, this, 0, 0, id, numbFields); }
+}
+
+
+
+void DCCTBBlockPrototype::countError(DCCTBErrorCounters::errorCategory c){
+	
+	errors_[c]++;
+	parser_->runErrorCounters().add(c);
+}
+
+
+
+void DCCTBBlockPrototype::addError(DCCTBBlockError::errorType type, DCCTBBlockPrototype * block, DCCTBFieldId fieldId, uint32_t wordOffset, uint32_t expected, uint32_t found, uint32_t channel){
+	
+	blockErrors_.resize( blockErrors_.size() + 1 );
+	DCCTBBlockError & error = blockErrors_.back();
+	error.type       = type;
+	error.block      = block;
+	error.fieldId    = fieldId;
+	error.wordOffset = wordOffset;
+	error.expected   = expected;
+	error.found      = found;
+	error.channel    = channel;
+	error.text.clear();
+	
+	blockError_ = true;
+	
+	if( type == DCCTBBlockError::OUTOFSCOPE ) { countError(DCCTBErrorCounters::BLOCK_OUTOFSCOPE); }
+	if( type == DCCTBBlockError::TRIGGERTYPE ){ countError(DCCTBErrorCounters::DCC_TRIGGERTYPE);  }
+	if( type >= DCCTBBlockError::NEXTBLOCK && type <= DCCTBBlockError::NEXTTRAILER ){ countError(DCCTBErrorCounters::DCC_NEXTBLOCK); }
+}
+
+
+
+void DCCTBBlockPrototype::addError(std::string text){
+	
+	addError(DCCTBBlockError::TEXT, this);
+	blockErrors_.back().text = text;
+}
+
+
+
+std::string & DCCTBBlockPrototype::errorString(){
+	
+	//render the errors recorded since the last call, FIELD errors are 
+	//rendered by the CHECKS error of their dataCheck
+	for( ; renderedErrors_ < blockErrors_.size(); renderedErrors_++){
+		if( blockErrors_[renderedErrors_].type != DCCTBBlockError::FIELD ){ errorString_ += errorText(renderedErrors_); }
+	}
+	return errorString_;
+}
+
+
+
+std::string DCCTBBlockPrototype::errorText(uint32_t i){
+	
+	const DCCTBBlockError & error = blockErrors_[i];
+	DCCTBBlockPrototype * block   = error.block;
+	DCCTBDataMapper * mapper      = parser_->mapper();
+	
+	std::string line("\n ======================================================================");
+	std::string ret;
+	
+	switch( error.type ){
+		
+	case DCCTBBlockError::OUTOFSCOPE :
+		ret += line + "\n";
+		ret += std::string(" ") + block->name() + std::string(" :: out of scope Error :: Unable to get data field : ") + mapper->fieldName(error.fieldId);
+		ret += "\n Word position inside block   : " + parser_->getDecString( error.wordOffset - block->wOffset() );
+		ret += "\n Word position inside event   : " + parser_->getDecString( error.wordOffset );
+		ret += "\n Block Size [bytes]           : " + parser_->getDecString( error.expected );
+		ret += "\n Action -> Stop parsing this block !";
+		ret += line;
+		ret += "\n Last decoded fields until error : " + block->displayText();
+		break;
+		
+	case DCCTBBlockError::NEXTBLOCK :
+	case DCCTBBlockError::NEXTSRP :
+	case DCCTBBlockError::NEXTTCC :
+	case DCCTBBlockError::NEXTTOWER :
+	case DCCTBBlockError::NEXTTRAILER :
+		ret += "\n Unable to get next block position (parser stoped!)";
+		if( error.type == DCCTBBlockError::NEXTSRP )    { ret += " (while trying to create a SR Block !)"; }
+		if( error.type == DCCTBBlockError::NEXTTCC )    { ret += " (while trying to create aTCC_CHSTATUS#" + parser_->getDecString(error.channel) + " Block !)"; }
+		if( error.type == DCCTBBlockError::NEXTTOWER )  { ret += " (while trying to create a TOWERHEADER Block for channel " + parser_->getDecString(error.channel) + " !)"; }
+		if( error.type == DCCTBBlockError::NEXTTRAILER ){ ret += " (while trying to create a DCC TRAILER Block !)"; }
+		ret += "\n Decoded fields untill error : " + block->displayText();
+		break;
+		
+	case DCCTBBlockError::FIELD :
+		ret += std::string("\n Field : ") + mapper->fieldName(error.fieldId) + " has value " + parser_->getDecString(error.found);
+		ret += std::string(", while ") + parser_->getDecString(error.expected) + std::string(" is expected");
+		break;
+		
+	case DCCTBBlockError::CHECKS :
+	case DCCTBBlockError::IDCHECKS :
+		ret += line + "\n";
+		if( error.type == DCCTBBlockError::CHECKS ){ ret += std::string(" ") + name_ + std::string(" data fields checks errors : "); }
+		else{ ret += std::string(" ") + name_ + std::string("( ID = ") + parser_->getDecString(error.expected) + std::string(" ) errors : "); }
+		for(uint32_t field = i - error.found; field < i; field++){ ret += errorText(field); }
+		ret += line;
+		break;
+		
+	case DCCTBBlockError::SUBBLOCK :
+		ret += block->errorString();
+		break;
+		
+	case DCCTBBlockError::TRIGGERTYPE :
+		ret += std::string("\n DCC::HEADER TRIGGER TYPE = ") + parser_->getDecString(error.found) + std::string(" is not a valid type !");
+		break;
+		
+	case DCCTBBlockError::TOWERLENGTH :
+		ret += line + "\n";
+		ret += std::string(" ") + name_ + std::string(" ZS is not active, error in the Tower Length !");
+		ret += "\n Tower Length is : " + parser_->getDecString(error.found) + std::string(" , while it should be : ");
+		ret += "\n It was only possible to build : " + parser_->getDecString(error.expected) + std::string(" XTAL blocks");
+		ret += line;
+		break;
+		
+	case DCCTBBlockError::TOWERTOOLONG :
+		ret += line + "\n";
+		ret += std::string(" ") + name_ + std::string(" Tower Length is larger then expected...!");
+		ret += "\n Tower Length is : " + parser_->getDecString(error.found) + std::string(" , while it should be at maximum : ");
+		ret += "\n Action -> data after the xtal 25 is ignored... ";
+		ret += line;
+		break;
+		
+	case DCCTBBlockError::TEXT :
+		ret += error.text;
+		break;
+	}
+	
+	return ret;
+}
+
+
+
+std::string DCCTBBlockPrototype::displayText(){
+	
+	std::ostringstream a;
+	try{ displayData(a); }
+	catch(ECALTBParserBlockException &e){}
+	return a.str();
+}
+
+
+
 std::pair<bool,std::string> DCCTBBlockPrototype::checkDataField(std::string name, uint32_t data){
 
 	std::string output("");
@@ -205,14 +377,57 @@ std::pair<bool,std::string> DCCTBBlockPrototype::checkDataField(std::string name
 
 uint32_t DCCTBBlockPrototype::getDataField(std::string name){
 	
-	std::map<std::string,uint32_t>::iterator it = dataFields_.find(name);
-	if(it == dataFields_.end()){		
+	uint32_t slot = decodedSlot( parser_->mapper()->fieldId(name) );
+	if(slot == DCCTBDataFieldTable::NOSLOT){		
 		throw ECALTBParserBlockException( std::string("\n field named : ")+name+std::string(" was not found in block ")+name_ );
 		blockError_=true;
 	}
 
-	return (*it).second;
+	return fieldValues_[slot];
+
+}
+
+
+
+uint32_t DCCTBBlockPrototype::getDataField(DCCTBFieldId id){
+	
+	uint32_t slot = decodedSlot(id);
+	if(slot == DCCTBDataFieldTable::NOSLOT){		
+		throw ECALTBParserBlockException( std::string("\n field named : ")+parser_->mapper()->fieldName(id)+std::string(" was not found in block ")+name_ );
+		blockError_=true;
+	}
+
+	return fieldValues_[slot];
+
+}
+
+
+
+void DCCTBBlockPrototype::decodeFields(const DCCTBFieldPlan * plan, uint32_t numbFields, uint32_t data){
+	
+	for(uint32_t f = 0; f < numbFields; f++, plan++){
+		fieldValues_[plan->slot]  = ( data >> plan->shift ) & plan->mask;
+		fieldDecoded_[plan->slot] = 1;
+	}
+}
+
+
 
+uint32_t DCCTBBlockPrototype::decodedSlot(DCCTBFieldId id){
+	
+	if( !fieldTable_ ){ return DCCTBDataFieldTable::NOSLOT; }
+	
+	uint32_t slot = fieldTable_->slot(id);
+	if( slot == DCCTBDataFieldTable::NOSLOT ){ return slot; }
+	
+	if( !fieldDecoded_[slot] ){
+		if( !lazy_ ){ return DCCTBDataFieldTable::NOSLOT; }
+		const DCCTBFieldPlan & plan = fieldTable_->plan(slot);
+		fieldValues_[slot]  = ( beginOfBuffer_[plan.word] >> plan.shift ) & plan.mask;
+		fieldDecoded_[slot] = 1;
+	}
+	
+	return slot;
 }
 
 
@@ -233,13 +448,18 @@ std::string DCCTBBlockPrototype::formatString(std::string myString,uint32_t minP
 
 
 void DCCTBBlockPrototype::setDataField(std::string name, uint32_t data){
-  std::set<DCCTBDataField *,DCCTBDataFieldComparator>::iterator it;          //iterator for data fields
-  bool fieldFound(false);
-  for(it = mapperFields_->begin(); it!= mapperFields_->end(); it++){
-  	if( ! ((*it)->name()).compare(name) ){ fieldFound = true; }
-  }
   
-  if(fieldFound){ dataFields_[name]= data;}
+  if( !fieldTable_ ){ fieldTable_ = parser_->mapper()->fieldTable(mapperFields_); }
+  uint32_t slot = fieldTable_->slot( parser_->mapper()->fieldId(name) );
+  
+  if(slot != DCCTBDataFieldTable::NOSLOT){ 
+    if( fieldValues_.size() != fieldTable_->size() ){
+      fieldValues_.resize(fieldTable_->size(),0);
+      fieldDecoded_.resize(fieldTable_->size(),0);
+    }
+    fieldValues_[slot]  = data;
+    fieldDecoded_[slot] = 1;
+  }
   else{ 
   	throw  ECALTBParserBlockException( std::string("\n field named : ")+name+std::string(" was not found in block ")+name_ );
   }
@@ -299,7 +519,7 @@ std::pair<bool,std::string> DCCTBBlockPrototype::compare(DCCTBBlockPrototype * b
 		uint32_t aValue, bValue;
 			
 		//Access original block data fields /////////////////////////////////////////////////////
-		try{ aValue = getDataField(dataFieldName); }
+		try{ aValue = getDataField((*it)->id()); }
 		
 		catch(ECALTBParserBlockException &e ){
 			ret.first   = false;
@@ -311,7 +531,7 @@ std::pair<bool,std::string> DCCTBBlockPrototype::compare(DCCTBBlockPrototype * b
 		/////////////////////////////////////////////////////////////////////////////////////////
 			
 		//Access comparision block data fields ///////////////////////////////////////////////////////
-		try{ bValue = block->getDataField(dataFieldName); }
+		try{ bValue = block->getDataField((*it)->id()); }
 		catch(ECALTBParserBlockException &e ){
 			ret.first  = false;
 			out<<"\n ERROR ON COMPARISION BLOCK unable to get data field :"<<dataFieldName
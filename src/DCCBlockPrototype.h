@@ -15,9 +15,50 @@
 #include <iomanip>
 #include <stdint.h>
 
+#include "DCCErrorCounters.h"
+
 class DCCTBDataParser;
 class DCCTBDataField;
 class DCCTBDataFieldComparator;
+class DCCTBDataFieldTable;
+struct DCCTBFieldPlan;
+
+// dense data field identifier, assigned by the DCCTBDataMapper
+typedef uint32_t DCCTBFieldId;
+
+class DCCTBBlockPrototype;
+
+
+// Error found while decoding a block: only the values are stored,
+// the text is built by DCCTBBlockPrototype::errorString when asked for
+struct DCCTBBlockError{
+
+	enum errorType{
+		OUTOFSCOPE,        // field beyond the end of the block/event (expected = block size [bytes])
+		NEXTBLOCK,         // unable to move to the next block (expected = words to move)
+		NEXTSRP,           // ... while trying to create the SR block
+		NEXTTCC,           // ... the TCC block of channel
+		NEXTTOWER,         // ... the tower block of channel
+		NEXTTRAILER,       // ... the DCC trailer block
+		FIELD,             // field found with an unexpected value
+		CHECKS,            // groups the FIELD errors of a dataCheck (found = number of them)
+		IDCHECKS,          // same, for a block with an expected id (expected)
+		SUBBLOCK,          // block not built, see block->errorString()
+		TRIGGERTYPE,       // trigger type (found) not supported
+		TOWERLENGTH,       // tower length (found) wrong without ZS, expected xtal blocks built
+		TOWERTOOLONG,      // tower length (found) longer than 25 xtal blocks
+		TEXT               // other errors (text)
+	};
+
+	errorType             type;
+	DCCTBBlockPrototype * block;       // block the error refers to
+	DCCTBFieldId          fieldId;
+	uint32_t              wordOffset;  // word position inside the event
+	uint32_t              expected;
+	uint32_t              found;
+	uint32_t              channel;
+	std::string           text;
+};
 
 
 class DCCTBBlockPrototype{
@@ -33,20 +74,38 @@ class DCCTBBlockPrototype{
 			uint32_t wordEventOffset = 0 
 		);
 
+		
+		// Empty block, set up later with initialize (used by the block pools)
+		DCCTBBlockPrototype();
+
 		virtual ~ DCCTBBlockPrototype(){}
+		
+		// (Re)sets the block on a new buffer, keeping the allocated field storage
+		void initialize(
+			DCCTBDataParser * parser, 
+			std::string name, 
+			uint32_t* buffer,
+			uint32_t numbBytes, 
+			uint32_t wordsToEndOfEvent, 
+			uint32_t wordEventOffset = 0 
+		);
 
-		virtual void   parseData();		
-		virtual void   increment(uint32_t numb, std::string msg="");
-		virtual void   seeIfIsPossibleToIncrement(uint32_t numb, std::string msg="");		
+		// The bounds failures are returned (false) and recorded as block errors,
+		// getDataWord still throws ECALTBParserBlockException for other users
+		virtual bool   parseData();		
+		bool           increment(uint32_t numb);
+		bool           seeIfIsPossibleToIncrement(uint32_t numb);		
 		virtual uint32_t  getDataWord(uint32_t wordPosition, uint32_t bitPosition, uint32_t mask);
 		virtual uint32_t  getDataField(std::string name);
+		virtual uint32_t  getDataField(DCCTBFieldId id);
 		virtual void   setDataField(std::string name, uint32_t data);
 		
 		virtual std::pair<bool,std::string> checkDataField(std::string name, uint32_t data);
 		virtual void displayData(std::ostream & os=std::cout);
 		virtual std::pair<bool,std::string> compare(DCCTBBlockPrototype * block);
 	
-		std::map<std::string,uint32_t> & errorCounters(){ return errors_; }
+		// Errors of a category found in this block (also counted in the parser run counters)
+		uint32_t errorCount(DCCTBErrorCounters::errorCategory c){ return errors_[c]; }
 		
 		// Block Name
 		std::string name(){ return name_;}
@@ -54,13 +113,31 @@ class DCCTBBlockPrototype{
 		// Block Size in Bytes
 		uint32_t size(){ return blockSize_;  }
 		
-		std::string & errorString(){ return errorString_;}	
+		// Text of the block errors, rendered on first call
+		std::string & errorString();
+		
+		// Error records of the block, in the order they were found
+		const std::vector<DCCTBBlockError> & blockErrors(){ return blockErrors_; }
+		
+		void addError(
+			DCCTBBlockError::errorType type,
+			DCCTBBlockPrototype * block,
+			DCCTBFieldId fieldId = 0,
+			uint32_t wordOffset = 0,
+			uint32_t expected = 0,
+			uint32_t found = 0,
+			uint32_t channel = 0
+		);
+		void addError(std::string text);
 		
 		//Word Block Offest inside event
 		uint32_t wOffset(){ return wordEventOffset_;}
 	
 		bool blockError(){return blockError_;}
 
+		// Fields are extracted on first access (see DCCTBDataParser lazyDecoding flag and projection)
+		bool lazy(){ return lazy_; }
+
                 /**
                  * Returns data parser
                  */
@@ -70,6 +147,24 @@ class DCCTBBlockPrototype{
 		
 		std::string formatString(std::string myString,uint32_t minPositions);
 		
+		// Compares a decoded field with its expected value, a FIELD error is recorded if they differ
+		bool checkField(DCCTBFieldId id, uint32_t expected);
+		
+		void countError(DCCTBErrorCounters::errorCategory c);
+		
+		// Groups the FIELD errors recorded since firstError by a dataCheck (if any)
+		void endChecks(uint32_t firstError, DCCTBBlockError::errorType type = DCCTBBlockError::CHECKS, uint32_t id = 0);
+		
+		std::string errorText(uint32_t error);
+		std::string displayText();
+		
+		// slot of a decoded field in fieldValues_ (NOSLOT if not decoded)
+		// in lazy mode the field is extracted from the buffer on first access
+		uint32_t decodedSlot(DCCTBFieldId id);
+		
+		// extracts numbFields fields of a plan from the same 32 bit word
+		void decodeFields(const DCCTBFieldPlan * plan, uint32_t numbFields, uint32_t data);
+		
 		uint32_t * dataP_;
 		uint32_t * beginOfBuffer_;
 		
@@ -87,11 +182,20 @@ class DCCTBBlockPrototype{
 		
 		DCCTBDataParser * parser_;
 		
-		std::map<std::string,uint32_t> dataFields_;
-		std::map<std::string,uint32_t> errors_;
+		uint32_t errors_[DCCTBErrorCounters::NUMBCATEGORIES];
+		
+		std::vector<DCCTBBlockError> blockErrors_;
+		uint32_t renderedErrors_;
 		
 		std::set<DCCTBDataField *,DCCTBDataFieldComparator> * mapperFields_;
 		
+		// decoded values, indexed by the slots of the compiled mapper fields
+		// fieldDecoded_ flags the fields already extracted (touched fields in lazy mode)
+		DCCTBDataFieldTable * fieldTable_;
+		std::vector<uint32_t> fieldValues_;
+		std::vector<unsigned char> fieldDecoded_;
+		bool lazy_;
+		
 	
 };
 
@@ -28,6 +28,8 @@ DCCTBDataMapper::DCCTBDataMapper( DCCTBDataParser * myParser)
   buildTowerFields();
   buildXtalFields();
   buildTrailerFields();	
+
+  compileFields();
 }
 
 /*---------------------------------------------*/
@@ -67,6 +69,195 @@ DCCTBDataMapper::~DCCTBDataMapper(){
   delete towerFields_;
   delete xtalFields_;
   delete trailerFields_;
+
+  std::map<std::set<DCCTBDataField *, DCCTBDataFieldComparator> *, DCCTBDataFieldTable *>::iterator itTable;
+  for(itTable = fieldTables_.begin(); itTable != fieldTables_.end(); itTable++){ delete itTable->second;}
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBDataMapper::compileFields                    */
+/* assigns a dense id to every field name and      */
+/* builds the field tables used by the blocks      */
+/*-------------------------------------------------*/
+void DCCTBDataMapper::compileFields(){
+
+  //named fields, in the order of the FIELDIDS enum
+  static const char * namedFields[NAMEDFIELDS] = {
+    "H", "FOV", "FED/DCC ID", "BX", "LV1", "TRIGGER TYPE", "BOE", "EVENT LENGTH", "DCC ERRORS",
+    "RUN NUMBER", "RUN TYPE", "DETAILED TRIGGER TYPE", "ORBIT COUNTER", "SR", "ZS", "TZS", "SR_CHSTATUS",
+    "TCC ID", "E0", "E1", "#TT", "#TIME SAMPLES", "LE0", "LE1",
+    "SRP ID", "#SR FLAGS",
+    "TT/SC ID", "BLOCK LENGTH",
+    "STRIP ID", "XTAL ID", "M", "SMF", "GMF", "GDECISION",
+    "T", "TTS", "EVENT STATUS", "CRC", "EOE"
+  };
+  
+  for(uint32_t i=0; i<NAMEDFIELDS; i++){
+    fieldIds_[namedFields[i]] = i;
+    fieldNames_.push_back(namedFields[i]);
+  }
+
+  std::vector<std::set<DCCTBDataField *, DCCTBDataFieldComparator> *> pVector;
+  pVector.push_back(dccFields_);
+  pVector.push_back(emptyEventFields_);
+  pVector.push_back(tcc68Fields_);
+  pVector.push_back(tcc32Fields_);
+  pVector.push_back(tcc16Fields_);
+  pVector.push_back(srp68Fields_);
+  pVector.push_back(srp32Fields_);
+  pVector.push_back(srp16Fields_);
+  pVector.push_back(towerFields_);
+  pVector.push_back(xtalFields_);
+  pVector.push_back(trailerFields_);
+
+  //numbered fields get the next ids
+  std::set<DCCTBDataField *,DCCTBDataFieldComparator>::iterator it;
+  for(uint32_t i=0; i<pVector.size(); i++){
+    for(it = pVector[i]->begin(); it != pVector[i]->end(); it++){
+      std::string name = (*it)->name();
+      std::map<std::string, DCCTBFieldId>::iterator itId = fieldIds_.find(name);
+      if( itId == fieldIds_.end() ){
+        itId = fieldIds_.insert(std::make_pair(name, (DCCTBFieldId) fieldNames_.size())).first;
+        fieldNames_.push_back(name);
+      }
+      (*it)->setId(itId->second);
+    }
+  }
+
+  for(uint32_t i=0; i<pVector.size(); i++){
+    fieldTables_[pVector[i]] = new DCCTBDataFieldTable(pVector[i], fieldNames_.size());
+  }
+
+  fillIds(headerIds_,      "H",              8);
+  fillIds(tccChStatusIds_, "TCC_CHSTATUS#",  4);
+  fillIds(feChStatusIds_,  "FE_CHSTATUS#",  70);
+  // SR flags of all the channels walked by an event (70 with the mem boxes): the ids above
+  // the flags of the SRP block stay NOFIELD, not found in the block as when looked up by name
+  fillIds(srIds_,          "SR#",           70);
+  fillIds(tpgIds_,         "TPG#",          68*parser_->numbTriggerSamples());
+  fillIds(ttfIds_,         "TTF#",          68*parser_->numbTriggerSamples());
+  fillIds(adcIds_,         "ADC#",          parser_->numbXtalSamples());
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBDataMapper::fillIds                          */
+/* ids of the numbered fields prefix#1..numb       */
+/* (entry 0 is not used)                           */
+/*-------------------------------------------------*/
+void DCCTBDataMapper::fillIds(std::vector<DCCTBFieldId> & ids, std::string prefix, uint32_t numb){
+  ids.assign(numb+1, (DCCTBFieldId) NOFIELD);
+  for(uint32_t i=1; i<=numb; i++){ ids[i] = fieldId(prefix + parser_->getDecString(i)); }
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBDataMapper::fieldId                          */
+/* returns the id of a field name                  */
+/*-------------------------------------------------*/
+DCCTBFieldId DCCTBDataMapper::fieldId(std::string name){
+  std::map<std::string, DCCTBFieldId>::iterator it = fieldIds_.find(name);
+  if( it == fieldIds_.end() ){ return NOFIELD; }
+  return it->second;
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBDataMapper::fieldTable                       */
+/* returns the compiled table of a field set       */
+/*-------------------------------------------------*/
+DCCTBDataFieldTable * DCCTBDataMapper::fieldTable(std::set<DCCTBDataField *, DCCTBDataFieldComparator> * fields){
+  std::map<std::set<DCCTBDataField *, DCCTBDataFieldComparator> *, DCCTBDataFieldTable *>::iterator it = fieldTables_.find(fields);
+  if( it == fieldTables_.end() ){ return 0; }
+  return it->second;
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBDataFieldTable::DCCTBDataFieldTable          */
+/* class constructor                               */
+/*-------------------------------------------------*/
+DCCTBDataFieldTable::DCCTBDataFieldTable(std::set<DCCTBDataField *, DCCTBDataFieldComparator> * fields, uint32_t numbIds){
+  
+  slots_.assign(numbIds, (uint32_t) NOSLOT);
+  lastWordPosition_ = 0;
+  projected_ = false;
+  
+  std::set<DCCTBDataField *,DCCTBDataFieldComparator>::iterator it;
+  for(it = fields->begin(); it != fields->end(); it++){
+    slots_[(*it)->id()] = fields_.size();
+
+    //fields are ordered by word: a new word starts a new group
+    DCCTBFieldPlan plan = { (*it)->wordPosition(), (*it)->bitPosition(), (*it)->mask(), (uint32_t) fields_.size() };
+    if( words_.empty() || words_.back().word != plan.word ){
+      DCCTBWordPlan word = { plan.word, plan.slot, 0 };
+      words_.push_back(word);
+    }
+    words_.back().numbFields++;
+    plans_.push_back(plan);
+
+    fields_.push_back(*it);
+    if( (*it)->wordPosition() > lastWordPosition_ ){ lastWordPosition_ = (*it)->wordPosition(); }
+  }
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBDataFieldTable::project                      */
+/* builds the plan of the selected fields          */
+/*-------------------------------------------------*/
+void DCCTBDataFieldTable::project(const std::vector<bool> & selected){
+
+  projectedPlans_.clear();
+  projectedWords_.clear();
+  projected_ = !selected.empty();
+  if( !projected_ ){ return; }
+
+  for(uint32_t slot = 0; slot < plans_.size(); slot++){
+    DCCTBFieldId id = fields_[slot]->id();
+    if( id >= selected.size() || !selected[id] ){ continue; }
+
+    const DCCTBFieldPlan & plan = plans_[slot];
+    if( projectedWords_.empty() || projectedWords_.back().word != plan.word ){
+      DCCTBWordPlan word = { plan.word, (uint32_t) projectedPlans_.size(), 0 };
+      projectedWords_.push_back(word);
+    }
+    projectedWords_.back().numbFields++;
+    projectedPlans_.push_back(plan);
+  }
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBDataMapper::setProjection                    */
+/* projects the field tables on the field groups   */
+/* and on the field ids selected by the parser     */
+/*-------------------------------------------------*/
+void DCCTBDataMapper::setProjection(uint32_t groups, const std::vector<DCCTBFieldId> & ids){
+
+  std::vector<bool> selected(fieldNames_.size(), false);
+  for(uint32_t i = 0; i < ids.size(); i++){
+    if( ids[i] < selected.size() ){ selected[ids[i]] = true; }
+  }
+
+  std::set<DCCTBDataField *, DCCTBDataFieldComparator> * sets[] = {
+    dccFields_, emptyEventFields_, tcc68Fields_, tcc32Fields_, tcc16Fields_,
+    srp68Fields_, srp32Fields_, srp16Fields_, towerFields_, xtalFields_, trailerFields_
+  };
+  uint32_t setGroups[] = {
+    DCCTBDataParser::DCCHEADER, DCCTBDataParser::DCCHEADER,
+    DCCTBDataParser::TCCPRIMITIVES, DCCTBDataParser::TCCPRIMITIVES, DCCTBDataParser::TCCPRIMITIVES,
+    DCCTBDataParser::SRPFLAGS, DCCTBDataParser::SRPFLAGS, DCCTBDataParser::SRPFLAGS,
+    DCCTBDataParser::TOWERHEADERS, DCCTBDataParser::XTALSAMPLES, DCCTBDataParser::TRAILER
+  };
+
+  for(uint32_t i = 0; i < sizeof(sets)/sizeof(sets[0]); i++){
+    DCCTBDataFieldTable * table = fieldTable(sets[i]);
+    if( !table ){ continue; }
+    if( groups & setGroups[i] ){ table->project(std::vector<bool>()); }
+    else                       { table->project(selected);            }
+  }
 }
 
 
@@ -293,18 +484,15 @@ void DCCTBDataMapper::buildXtalFields(){
   xtalFields_->insert(new DCCTBDataField("SMF",SMF_WPOSITION,SMF_BPOSITION,SMF_MASK));
   xtalFields_->insert(new DCCTBDataField("GMF",GMF_WPOSITION,GMF_BPOSITION,GMF_MASK));
 
-  //first ADC is still on 1st word
-  xtalFields_->insert(new DCCTBDataField("ADC#1",ADC_WPOSITION,ADCBOFFSET,ADC_MASK));
-	
-  //add the rest of the ADCs 
-  for(uint32_t i=2; i <= parser_->numbXtalSamples();i++){
+  //first ADC is still on 1st word, then 2 ADCs per word (positions of the parser geometry)
+  DCCTBGeometry & geometry = parser_->geometry();
+  for(uint32_t i=1; i <= geometry.numbXtalSamples();i++){
     std::string adc = std::string("ADC#") + parser_->getDecString(i);
-    if(i%2){ xtalFields_->insert(new DCCTBDataField(adc,ADC_WPOSITION + i/2, ADCBOFFSET,ADC_MASK)); }
-    else   { xtalFields_->insert(new DCCTBDataField(adc,ADC_WPOSITION + i/2, 0,ADC_MASK)); }
+    xtalFields_->insert(new DCCTBDataField(adc,geometry.sampleWord(i),geometry.sampleBit(i),ADC_MASK));
   }
 
   //the last word has written the test zero suppression flag and the gain decision bit
-  uint32_t tzsOffset_ = parser_->numbXtalSamples()/2;
+  uint32_t tzsOffset_ = geometry.tzsOffset();
   xtalFields_->insert(new DCCTBDataField("TZS",XTAL_TZS_WPOSITION+tzsOffset_,XTAL_TZS_BPOSITION,XTAL_TZS_MASK));
   xtalFields_->insert(new DCCTBDataField("GDECISION",XTAL_GDECISION_WPOSITION+tzsOffset_,XTAL_GDECISION_BPOSITION,XTAL_GDECISION_MASK));
 }
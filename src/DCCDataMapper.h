@@ -7,6 +7,8 @@
 
 #include <string>                //STL
 #include <set>
+#include <map>
+#include <vector>
 
 #include "DCCDataParser.h"
 
@@ -16,6 +18,8 @@
 /* define data fields from the ECAL raw data format         */
 /* a data field has a name, a word position, a bit position */
 /* and a mask (number of bits)                              */
+/* the mapper assigns it a dense id shared by all fields    */
+/* with the same name                                       */
 /* Note: this class is defined inline                       */
 /*----------------------------------------------------------*/
 class DCCTBDataField{
@@ -24,7 +28,7 @@ public :
      Class constructor (sets data field's characteristics)
   */
   DCCTBDataField(std::string name, uint32_t wordPosition, uint32_t bitPosition, uint32_t mask){
-    name_=name; wordPosition_ = wordPosition; bitPosition_= bitPosition; mask_= mask;
+    name_=name; wordPosition_ = wordPosition; bitPosition_= bitPosition; mask_= mask; id_ = 0;
   }
 		
   /**
@@ -38,6 +42,8 @@ public :
   uint32_t bitPosition()                 { return bitPosition_;            }
   void setMask(uint32_t maskvalue)       { mask_=maskvalue;                }
   uint32_t mask()                        { return mask_;                   }
+  void setId(DCCTBFieldId id)            { id_ = id;                       }
+  DCCTBFieldId id()                      { return id_;                     }
 
   /**
      Class destructor
@@ -49,6 +55,7 @@ protected :
   uint32_t wordPosition_;
   uint32_t bitPosition_;
   uint32_t mask_;
+  DCCTBFieldId id_;
 };
 
 
@@ -82,6 +89,85 @@ public :
 
 
 
+/*----------------------------------------------------------*/
+/* DCC FIELD PLAN                                           */
+/* extraction of one field of a compiled field set:        */
+/* value = ( block[word] >> shift ) & mask, stored in slot */
+/*----------------------------------------------------------*/
+struct DCCTBFieldPlan{
+  uint32_t word;
+  uint32_t shift;
+  uint32_t mask;
+  uint32_t slot;
+};
+
+
+/*----------------------------------------------------------*/
+/* DCC WORD PLAN                                            */
+/* the fields of a compiled field set that share one 32 bit */
+/* word: plans first to first+numbFields-1                  */
+/*----------------------------------------------------------*/
+struct DCCTBWordPlan{
+  uint32_t word;
+  uint32_t first;
+  uint32_t numbFields;
+};
+
+
+/*----------------------------------------------------------*/
+/* DCC DATA FIELD TABLE                                     */
+/* compiled view of a field set: the fields in block order  */
+/* (slots) and a look-up from field id to slot, used by the */
+/* blocks to store decoded values in a flat array. The      */
+/* extraction plan is a contiguous copy of the field        */
+/* positions grouped by word, so that a block is parsed     */
+/* with one load per word                                   */
+/*----------------------------------------------------------*/
+class DCCTBDataFieldTable{
+public :
+
+  enum { NOSLOT = 0xFFFFFFFF };
+
+  DCCTBDataFieldTable(std::set<DCCTBDataField *, DCCTBDataFieldComparator> * fields, uint32_t numbIds);
+
+  uint32_t size()                       { return fields_.size(); }
+  DCCTBDataField * field(uint32_t slot) { return fields_[slot];  }
+  uint32_t lastWordPosition()           { return lastWordPosition_; }
+
+  const DCCTBFieldPlan & plan(uint32_t slot)  { return plans_[slot];  }
+  uint32_t numbWords()                        { return words_.size(); }
+  const DCCTBWordPlan & wordPlan(uint32_t i)  { return words_[i];     }
+
+  /**
+     Restricts the plan decoded with the block to the fields with selected[id] set,
+     back to the whole table if selected is empty (see DCCTBDataParser::setProjection)
+  */
+  void project(const std::vector<bool> & selected);
+
+  bool projected()                                      { return projected_;                }
+  const DCCTBFieldPlan & projectedPlan(uint32_t i)      { return projectedPlans_[i];       }
+  uint32_t numbProjectedWords()                         { return projectedWords_.size();   }
+  const DCCTBWordPlan & projectedWordPlan(uint32_t i)   { return projectedWords_[i];       }
+
+  /**
+     Returns the slot of a field id in this table (NOSLOT if the field is not in the block)
+  */
+  uint32_t slot(DCCTBFieldId id){ return id < slots_.size() ? slots_[id] : (uint32_t) NOSLOT; }
+
+protected :
+  std::vector<DCCTBDataField *> fields_;
+  std::vector<uint32_t> slots_;
+  std::vector<DCCTBFieldPlan> plans_;
+  std::vector<DCCTBWordPlan> words_;
+  uint32_t lastWordPosition_;
+
+  bool projected_;
+  std::vector<DCCTBFieldPlan> projectedPlans_;
+  std::vector<DCCTBWordPlan> projectedWords_;
+};
+
+
+
 /*----------------------------------------------------------*/
 /* DCC DATA MAPPER                                          */
 /* maps the data according to ECAL raw data format specs.   */
@@ -116,8 +202,46 @@ public:
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> *towerFields()      { return towerFields_;      }
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> *xtalFields()       { return xtalFields_;       }
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> *trailerFields()    { return trailerFields_;    }
+
+  /**
+     Returns the compiled table of a field set returned by the methods above
+  */
+  DCCTBDataFieldTable * fieldTable(std::set<DCCTBDataField *, DCCTBDataFieldComparator> * fields);
+
+  /**
+     Projects the field tables on the field groups set in groups (DCCTBDataParser::fieldGroups)
+     and on the fields of ids: the tables of the other groups only decode the fields of ids
+  */
+  void setProjection(uint32_t groups, const std::vector<DCCTBFieldId> & ids);
+
+  /**
+     Field ids: fields with the same name share the same id in every block.
+     Named fields have the fixed ids of FIELDIDS, numbered fields (ADC#i, TPG#i, ...)
+     are returned by the methods below, with i starting at 1 as in the field name.
+     fieldId returns NOFIELD for an unknown name, the numbered ids for an index
+     outside 1..numb of fillIds.
+  */
+  DCCTBFieldId fieldId(std::string name);
+  std::string  fieldName(DCCTBFieldId id){ return id < fieldNames_.size() ? fieldNames_[id] : std::string(""); }
+  uint32_t     numbFields()              { return fieldNames_.size(); }
+
+  DCCTBFieldId adcId(uint32_t i)         { return numberedId(adcIds_,         i); }
+  DCCTBFieldId tpgId(uint32_t i)         { return numberedId(tpgIds_,         i); }
+  DCCTBFieldId ttfId(uint32_t i)         { return numberedId(ttfIds_,         i); }
+  DCCTBFieldId srId(uint32_t i)          { return numberedId(srIds_,          i); }
+  DCCTBFieldId feChStatusId(uint32_t i)  { return numberedId(feChStatusIds_,  i); }
+  DCCTBFieldId tccChStatusId(uint32_t i) { return numberedId(tccChStatusIds_, i); }
+  DCCTBFieldId headerId(uint32_t i)      { return numberedId(headerIds_,      i); }
   
 protected:
+
+  /**
+     Assigns the field ids and builds the field tables
+  */
+  void compileFields();
+  void fillIds(std::vector<DCCTBFieldId> & ids, std::string prefix, uint32_t numb);
+  static DCCTBFieldId numberedId(const std::vector<DCCTBFieldId> & ids, uint32_t i){ return i < ids.size() ? ids[i] : (DCCTBFieldId) NOFIELD; }
+
   DCCTBDataParser * parser_;
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> * dccFields_;
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> * emptyEventFields_;
@@ -132,9 +256,34 @@ protected:
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> * towerFields_;
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> * xtalFields_;
   std::set<DCCTBDataField *, DCCTBDataFieldComparator> * trailerFields_;
+
+  std::map<std::string, DCCTBFieldId> fieldIds_;
+  std::vector<std::string> fieldNames_;
+  std::map<std::set<DCCTBDataField *, DCCTBDataFieldComparator> *, DCCTBDataFieldTable *> fieldTables_;
+
+  std::vector<DCCTBFieldId> adcIds_;
+  std::vector<DCCTBFieldId> tpgIds_;
+  std::vector<DCCTBFieldId> ttfIds_;
+  std::vector<DCCTBFieldId> srIds_;
+  std::vector<DCCTBFieldId> feChStatusIds_;
+  std::vector<DCCTBFieldId> tccChStatusIds_;
+  std::vector<DCCTBFieldId> headerIds_;
   
 public: 
 
+  //Fixed ids of the named data fields (numbered fields get the ids that follow)
+  enum FIELDIDS{
+    H_ID = 0, FOV_ID, DCCID_ID, BX_ID, LV1_ID, TRIGGERTYPE_ID, BOE_ID, EVENTLENGTH_ID, DCCERRORS_ID,
+    RNUMB_ID, RUNTYPE_ID, DETAILEDTT_ID, ORBITCOUNTER_ID, SR_ID, ZS_ID, TZS_ID, SR_CHSTATUS_ID,
+    TCCID_ID, E0_ID, E1_ID, NTT_ID, TSAMP_ID, LE0_ID, LE1_ID,
+    SRPID_ID, NSRF_ID,
+    TOWERID_ID, TOWERLENGTH_ID,
+    STRIPID_ID, XTALID_ID, M_ID, SMF_ID, GMF_ID, GDECISION_ID,
+    T_ID, TTS_ID, ESTAT_ID, CRC_ID, EOE_ID,
+    NAMEDFIELDS,
+    NOFIELD = 0xFFFFFFFF
+  };
+
   //HEADER data fields (each 32 bits is separated by a space in the enum)
   enum DCCFIELDS{
     H_WPOSITION                = 0, H_BPOSITION              =  3,    H_MASK              = 0x1,
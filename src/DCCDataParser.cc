@@ -1,4 +1,13 @@
 #include "DCCDataParser.h"
+#include "DCCTowerBlock.h"
+#include "DCCXtalBlock.h"
+#include "DCCTCCBlock.h"
+#include "DCCSRPBlock.h"
+#include "DCCTrailerBlock.h"
+#include "DCCEventSoA.h"
+#include "DCCParseContext.h"
+#include "DCCRawFileReader.h"
+#include "DCCBOEScan.h"
 
 
 
@@ -6,12 +15,12 @@
 /* DCCTBDataParser::DCCTBDataParser                 */
 /* class constructor                            */
 /*----------------------------------------------*/
-DCCTBDataParser::DCCTBDataParser(const std::vector<uint32_t>& parserParameters, bool parseInternalData,bool debug):
-  buffer_(0),parseInternalData_(parseInternalData),debug_(debug), parameters(parserParameters){
+DCCTBDataParser::DCCTBDataParser(const std::vector<uint32_t>& parserParameters, bool parseInternalData,bool debug, bool lazyDecoding, bool resync):
+  parseInternalData_(parseInternalData),debug_(debug),lazyDecoding_(lazyDecoding),resync_(resync), parameters(parserParameters){
 	
+  geometry_.compute(parameters);           //calculate block sizes (used by the mapper)
   mapper_ = new DCCTBDataMapper(this);       //build a new data mapper
-  resetErrorCounters();                    //restart error counters
-  computeBlockSizes();                     //calculate block sizes
+  context_ = new DCCTBParseContext();        //own context (error counters restart)
   
 }
 
@@ -20,90 +29,59 @@ DCCTBDataParser::DCCTBDataParser(const std::vector<uint32_t>& parserParameters,
 /* DCCTBDataParser::resetErrorCounters            */
 /* resets error counters                        */
 /*----------------------------------------------*/
-void DCCTBDataParser::resetErrorCounters(){
-  //set error counters to 0
-  errors_["DCC::BOE"] = 0;               //begin of event (header B[60-63])
-  errors_["DCC::EOE"] = 0;               //end of event (trailer B[60-63])
-  errors_["DCC::EVENT LENGTH"] = 0;	 //event length (trailer B[32-55])
-}
+void DCCTBDataParser::resetErrorCounters(){ context_->resetErrorCounters(); }
 
 
 /*----------------------------------------------*/
-/* DCCTBDataParser::computeBlockSizes             */
-/* calculate the size of TCC and SR blocks      */
+/* DCCTBDataParser::setProjection                 */
+/* selects the fields decoded with the blocks   */
 /*----------------------------------------------*/
-void DCCTBDataParser::computeBlockSizes(){
-  uint32_t nTT = numbTTs();                                      //gets the number of the trigger towers (default:68)  
-  uint32_t tSamples = numbTriggerSamples();                      //gets the number of trigger time samples (default: 1)
-  uint32_t nSr = numbSRF();                                      //gests the number of SR flags (default:68)
+void DCCTBDataParser::setProjection(uint32_t fieldGroups, const std::vector<DCCTBFieldId> & ids){
+  if( (fieldGroups & ALLFIELDS) == ALLFIELDS ){ mapper_->setProjection(ALLFIELDS, std::vector<DCCTBFieldId>()); }
+  else                                        { mapper_->setProjection(fieldGroups, ids); }
+}
 
-  uint32_t tf(0), srf(0);
-	
-  if( (nTT*tSamples)<4 || (nTT*tSamples)%4 ) tf=1;            //test is there is no TTC primitives or if it's a multiple of 4?
-  else tf=0;
-  
 
-  if( srf<16 || srf%16 ) srf=1;                               //??? by default srf=0 why do we make this test ?????
-  else srf=0;
-  
-  //TTC block size: header (8 bytes) + 17 words with 4 trigger primitives (17*8bytes)
-  tccBlockSize_ = 8 + ((nTT*tSamples)/4)*8 + tf*8 ;          
-
-  //SR block size: header (8 bytes) + 4 words with 16 SR flags + 1 word with 4 SR flags (5*8bytes)
-  srpBlockSize_ = 8 + (nSr/16)*8 + srf*8;
+/*----------------------------------------------*/
+/* DCCTBDataParser::defaultParameters             */
+/* parameters of the test beam DCC              */
+/*----------------------------------------------*/
+std::vector<uint32_t> DCCTBDataParser::defaultParameters(){
+
+  std::vector<uint32_t> parameters;
+  parameters.push_back(10); // parameters[0] is the xtal samples 
+  parameters.push_back(1);  // parameters[1] is the number of trigger time samples for TPG's
+  parameters.push_back(68); // parameters[2] is the number of TT
+  parameters.push_back(68); // parameters[3] is the number of SR Flags
+  parameters.push_back(1);  // parameters[4] is the dcc id
+  parameters.push_back(1);  // parameters[5] is the sr id
+  parameters.push_back(1);  // parameters[6] is the tcc1 id
+  parameters.push_back(2);  // parameters[7] is the tcc2 id
+  parameters.push_back(3);  // parameters[8] is the tcc3 id
+  parameters.push_back(4);  // parameters[9] is the tcc4 id
+  return parameters;
 }
 
 
 /*------------------------------------------------*/
 /* DCCTBDataParser::parseFile                       */
 /* reada data from file and parse it              */
+/* (hexadecimal text or binary, see               */
+/* DCCTBRawFileReader to read one event at a time)  */
 /*------------------------------------------------*/
 void DCCTBDataParser::parseFile(std::string fileName, bool singleEvent){
 	
-  std::ifstream inputFile;                            //open file as input
-  inputFile.open(fileName.c_str());
-	
   resetErrorCounters();                          //reset error counters
 
-  //for debug purposes
-  //std::cout << "Now in DCCTBDataParser::parseFile " << std::endl;
+  //read the whole file to the buffer and parse it
+  //(throws if the file can not be opened)
+  DCCTBRawFileReader reader(fileName);
+  reader.readAll(fileBuffer_);
 
-	
-  //if file opened correctly read data to a buffer and parse it
-  //else throw an exception
-  if( !inputFile.fail() ){ 
-	
-    std::string myWord;                               //word read from line
-    std::vector<std::string> dataVector;                   //data vector
-    
-    //until the end of file read each line as a string and add it to the data vector
-    while( inputFile >> myWord ){ 
-      dataVector.push_back( myWord ); 
-    }
-    
-    bufferSize_ = (dataVector.size() ) * 4 ;      //buffer size in bytes (note:each char is an hex number)
-    if( buffer_ ){ delete [] buffer_; }           //delete current vector if any
-    buffer_ = new uint32_t[dataVector.size()];       //allocate memory for new data buffer
+  uint32_t bufferSize = fileBuffer_.size() * 4;          //buffer size in bytes
+  uint32_t *buffer    = fileBuffer_.empty() ? 0 : &fileBuffer_[0];
 
-    uint32_t *myData_ = (uint32_t *) buffer_;         
-    
-    //fill buffer data with data from file lines
-    for(uint32_t i = 1; i <= dataVector.size() ; i++, myData_++ ){
-      sscanf((dataVector[i-1]).c_str(),"%x",(unsigned int *)myData_);
-      
-      //for debug purposes
-      //std::cout << std::endl << "Data position: " << dec << i << " val = " << getHexString(*myData_);
-    }
-    
-    inputFile.close();                              //close file
-    
-    parseBuffer( buffer_,bufferSize_,singleEvent);  //parse data from buffer
-    
-  }
-  else{ 
-    std::string errorMessage = std::string(" Error::Unable to open file :") + fileName;
-    throw ECALTBParserException(errorMessage);
-  }
+  parseBuffer( buffer,bufferSize,singleEvent);  //parse data from buffer
 }
 
 
@@ -112,42 +90,21 @@ void DCCTBDataParser::parseFile(std::string fileName, bool singleEvent){
 /* parse data from a buffer                                 */
 /*----------------------------------------------------------*/
 void DCCTBDataParser::parseBuffer(uint32_t * buffer, uint32_t bufferSize, bool singleEvent){
+  parseBuffer(*context_, buffer, bufferSize, singleEvent);
+}
+
+void DCCTBDataParser::parseBuffer(DCCTBParseContext & context, uint32_t * buffer, uint32_t bufferSize, bool singleEvent){
 	
-  resetErrorCounters();                           //reset error counters
-	
-  buffer_ = buffer;                               //set class buffer
-  
-  //clear stored data
-  processedEvent_ = 0;
-  events_.clear();
-  std::vector<DCCTBEventBlock *>::iterator it;
-  for( it = dccEvents_.begin(); it!=dccEvents_.end(); it++ ) { delete *it; }
-  dccEvents_.clear();
-  eventErrors_ = "";
+  //reset error counters, clear stored data (blocks are given back to the pools)
+  context.reset(buffer, bufferSize);
 	
   //for debug purposes
   //std::cout << std::endl << "Now in DCCTBDataParser::parseBuffer" << std::endl;
   //std::cout << std::endl << "Buffer Size:" << dec << bufferSize << std::endl;
 	
-  //check if we have a coherent buffer size
-  if( bufferSize%8  ){
-    std::string fatalError ;
-    fatalError += "\n ======================================================================"; 		
-    fatalError += "\n Fatal error at event = " + getDecString(events_.size()+1);
-    fatalError += "\n Buffer Size of = "+ getDecString(bufferSize) + "[bytes] is not divisible by 8 ... ";
-    fatalError += "\n ======================================================================";
-    throw ECALTBParserException(fatalError);
-  }
-  if ( bufferSize < EMPTYEVENTSIZE ){
-    std::string fatalError ;
-    fatalError += "\n ======================================================================"; 		
-    fatalError += "\n Fatal error at event = " + getDecString(events_.size()+1);
-    fatalError += "\n Buffer Size of = "+ getDecString(bufferSize) + "[bytes] is less than an empty event ... ";
-    fatalError += "\n ======================================================================";
-    throw ECALTBParserException(fatalError);
-  }
+  checkBufferSize(context, bufferSize);           //check if we have a coherent buffer size
 
-  uint32_t *myPointer =  buffer_;                        
+  uint32_t *myPointer =  buffer;                        
   
   //  uint32_t processedBytes(0), wordIndex(0), lastEvIndex(0),eventSize(0), eventLength(0), errorMask(0);
   uint32_t processedBytes(0), wordIndex(0), eventLength(0), errorMask(0);
@@ -157,13 +114,23 @@ void DCCTBDataParser::parseBuffer(uint32_t * buffer, uint32_t bufferSize, bool s
 
     //for debug purposes
     //std::cout << "-> processedBytes.  =   " << dec << processedBytes << std::endl;
-    //std::cout << " -> Processed Event index =   " << dec << processedEvent_ << std::endl;
+    //std::cout << " -> Processed Event index =   " << dec << context.processedEvents() << std::endl;
     //std::cout << "-> First ev.word    = 0x" << hex << (*myPointer) << std::endl;
     //std::cout << "-> word index       =   " << dec << wordIndex << std::endl;
     
     //check if Event Length is coherent /////////////////////////////////////////
     uint32_t bytesToEnd         = bufferSize - processedBytes;
-    std::pair<uint32_t,uint32_t> eventD = checkEventLength(myPointer,bytesToEnd,singleEvent);
+
+    //with resync on, a corrupted event length skips the buffer up to the next valid event
+    uint32_t skippedBytes = resyncEvent(context,myPointer,processedBytes,bytesToEnd,singleEvent);
+    if( skippedBytes ){
+      processedBytes += skippedBytes;
+      myPointer      += skippedBytes/4;
+      wordIndex      += skippedBytes/4;
+      continue;
+    }
+
+    std::pair<uint32_t,uint32_t> eventD = checkEventLength(context,myPointer,bytesToEnd,singleEvent);
     eventLength              = eventD.second; 
     errorMask                = eventD.first;
     //////////////////////////////////////////////////////////////////////////////
@@ -176,25 +143,23 @@ void DCCTBDataParser::parseBuffer(uint32_t * buffer, uint32_t bufferSize, bool s
     //for debug purposes debug 
     //std::cout<<std::endl;
     //std::cout<<" out... Bytes To End.... =   "<<dec<<bytesToEnd<<std::endl;
-    //std::cout<<" out... Processed Event  =   "<<dec<<processedEvent_<<std::endl;	
+    //std::cout<<" out... Processed Event  =   "<<dec<<context.processedEvents()<<std::endl;	
     //std::cout<<" out... Event Length     =   "<<dec<<eventLength<<std::endl;
     //std::cout<<" out... LastWord         = 0x"<<hex<<*(myPointer+eventLength*2-1)<<std::endl;
     
     if (parseInternalData_){ 
       //build a new event block from buffer
-      DCCTBEventBlock *myBlock = new DCCTBEventBlock(this,myPointer,eventLength*8, eventLength*2 -1 ,wordIndex,0);
+      DCCTBEventBlock *myBlock = context.eventBlockPool().get();
+      myBlock->initialize(this,myPointer,eventLength*8, eventLength*2 -1 ,wordIndex,0,&context);
       
       //add event to dccEvents vector
-      dccEvents_.push_back(myBlock);
+      context.dccEvents().push_back(myBlock);
     }
     
-    //build the event pointer with error mask and add it to the events vector
-    std::pair<uint32_t *, uint32_t> eventPointer(myPointer,eventLength);
-    std::pair<uint32_t, std::pair<uint32_t*, uint32_t> > eventPointerWithErrorMask(errorMask,eventPointer);
-    events_.push_back(eventPointerWithErrorMask);
+    //add the event pointer with error mask to the events vector
+    context.addEvent(errorMask,myPointer,eventLength);
     		
     //update processed buffer size 
-    processedEvent_++;
     processedBytes += eventLength*8;
     //std::cout << std::endl << "Processed Bytes = " << dec << processedBytes << std::endl;
     
@@ -202,6 +167,199 @@ void DCCTBDataParser::parseBuffer(uint32_t * buffer, uint32_t bufferSize, bool s
     myPointer     += eventLength*2;
     wordIndex     += eventLength*2;
   } 
+  
+  //DCC event checks of the buffer go to the run counters (the blocks count their own errors there)
+  runErrors_.add(context.errorCounters());
+  runErrors_.addEvents(context.processedEvents());
+}
+
+
+/*----------------------------------------------------------*/
+/* DCCTBDataParser::decodeToSoA                               */
+/* decode the events of a buffer into flat arrays           */
+/* (DCCTBEventSoA) without building the block objects       */
+/*----------------------------------------------------------*/
+void DCCTBDataParser::decodeToSoA(uint32_t * buffer, uint32_t bufferSize, bool singleEvent){
+  decodeToSoA(*context_, buffer, bufferSize, singleEvent);
+}
+
+void DCCTBDataParser::decodeToSoA(DCCTBParseContext & context, uint32_t * buffer, uint32_t bufferSize, bool singleEvent){
+
+  //reset error counters, clear stored data (events are given back to the pool)
+  context.reset(buffer, bufferSize);
+
+  checkBufferSize(context, bufferSize);
+
+  uint32_t *myPointer =  buffer;
+  uint32_t processedBytes(0);
+
+  //decode until there are no more events
+  while( processedBytes + EMPTYEVENTSIZE <= bufferSize ){
+
+    uint32_t skippedBytes = resyncEvent(context,myPointer,processedBytes,bufferSize - processedBytes,singleEvent);
+    if( skippedBytes ){
+      processedBytes += skippedBytes;
+      myPointer      += skippedBytes/4;
+      continue;
+    }
+
+    std::pair<uint32_t,uint32_t> eventD = checkEventLength(context,myPointer,bufferSize - processedBytes,singleEvent);
+    uint32_t eventLength = eventD.second;
+
+    DCCTBEventSoA *myEvent = context.soaEventPool().get();
+    myEvent->decode(this,myPointer,eventLength*8,eventD.first);
+    context.soaEvents().push_back(myEvent);
+    countErrors(myEvent);
+
+    context.addEvent(eventD.first,myPointer,eventLength);
+
+    processedBytes += eventLength*8;
+    myPointer      += eventLength*2;
+  }
+
+  runErrors_.add(context.errorCounters());
+  runErrors_.addEvents(context.processedEvents());
+}
+
+
+/*----------------------------------------------------------*/
+/* DCCTBDataParser::walkEvents                              */
+/* gives the events of a buffer to visitor, same walk as    */
+/* parseBuffer but from the event headers only              */
+/*----------------------------------------------------------*/
+void DCCTBDataParser::walkEvents(DCCTBParseContext & context, uint32_t * buffer, uint32_t bufferSize, EventVisitor & visitor){
+
+  context.reset(buffer, bufferSize);
+
+  checkBufferSize(context, bufferSize);
+
+  uint32_t *myPointer =  buffer;
+  uint32_t processedBytes(0);
+
+  while( processedBytes + EMPTYEVENTSIZE <= bufferSize ){
+
+    uint32_t skippedBytes = resyncEvent(context,myPointer,processedBytes,bufferSize - processedBytes);
+    if( skippedBytes ){
+      processedBytes += skippedBytes;
+      myPointer      += skippedBytes/4;
+      continue;
+    }
+
+    std::pair<uint32_t,uint32_t> eventD = checkEventLength(context,myPointer,bufferSize - processedBytes);
+    visitor.addEvent(processedBytes,myPointer,bufferSize - processedBytes,eventD.first,eventD.second);
+    context.addEvent(eventD.first,myPointer,eventD.second);
+
+    processedBytes += eventD.second*8;
+    myPointer      += eventD.second*2;
+  }
+}
+
+
+/*----------------------------------------------------------*/
+/* DCCTBDataParser::walkEvents                              */
+/* gives the events of a file to visitor                    */
+/*----------------------------------------------------------*/
+void DCCTBDataParser::walkEvents(DCCTBParseContext & context, DCCTBRawFileReader & reader, EventVisitor & visitor){
+
+  reader.seek(0);
+
+  while( reader.nextEvent(*this,context) ){
+    std::pair<uint32_t,uint32_t> eventD = checkEventLength(context,reader.event(),reader.eventSize());
+    visitor.addEvent(reader.eventOffset(),reader.event(),reader.eventSize(),eventD.first,eventD.second);
+    context.addEvent(eventD.first,reader.event(),eventD.second);
+  }
+}
+
+
+/*----------------------------------------------------------*/
+/* DCCTBDataParser::countErrors                               */
+/* adds the errors flagged by decodeToSoA to the run        */
+/* counters (same categories as the block errors)           */
+/*----------------------------------------------------------*/
+void DCCTBDataParser::countErrors(DCCTBEventSoA * event){
+
+  uint32_t errors = event->errors();
+  if( errors & DCCTBEventSoA::BLOCK_ERROR )       { runErrors_.add(DCCTBErrorCounters::DCC_NEXTBLOCK);   }
+  if( errors & DCCTBEventSoA::TRIGGERTYPE_ERROR ) { runErrors_.add(DCCTBErrorCounters::DCC_TRIGGERTYPE); }
+
+  for(uint32_t t=0; t<event->numbTowers(); t++){
+    if( event->towerErrors(t) & DCCTBEventSoA::TOWERID_ERROR )     { runErrors_.add(DCCTBErrorCounters::FE_TTSCID);      }
+    if( event->towerErrors(t) & DCCTBEventSoA::TOWERLENGTH_ERROR ) { runErrors_.add(DCCTBErrorCounters::FE_BLOCKLENGTH); }
+    for(uint32_t c=0; c<event->numbXtals(t); c++){
+      if( event->xtalErrors(t,c) & DCCTBEventSoA::XTALID_ERROR ){ runErrors_.add(DCCTBErrorCounters::XTAL_HEADER); }
+    }
+  }
+}
+
+
+/*---------------------------------------------*/
+/* DCCTBDataParser::resyncEvent                  */
+/* skips a corrupted event length: scans for    */
+/* the next valid BOE/EOE pair                  */
+/*---------------------------------------------*/
+uint32_t DCCTBDataParser::resyncEvent(DCCTBParseContext & context, uint32_t * pointerToEvent, uint32_t bufferOffset, uint32_t bytesToEnd, bool singleEvent){
+
+  if( !resync_ || singleEvent || validEvent(pointerToEvent,bytesToEnd,false) ){ return 0; }
+
+  uint32_t numbDWords   = bytesToEnd/8;
+  uint32_t skippedBytes = bytesToEnd;
+
+  //candidates are the 64 bit words with the BOE nibble, the first one with a coherent
+  //event length and the EOE nibble at its end is taken as the next event
+  for(uint32_t dw = 1; dw < numbDWords; dw++){
+    dw += DCCTBBOEScan::findBOE(pointerToEvent + dw*2, numbDWords - dw);
+    if( dw >= numbDWords ){ break; }
+    if( validEvent(pointerToEvent + dw*2, (numbDWords - dw)*8, true) ){ skippedBytes = dw*8; break; }
+  }
+
+  context.addSkippedRange(bufferOffset, skippedBytes);
+  return skippedBytes;
+}
+
+
+/*---------------------------------------------*/
+/* DCCTBDataParser::validEvent                   */
+/* event length fits in bytesToEnd (and BOE and */
+/* EOE nibbles are set if checkMarkers):       */
+/* nothing is read if an empty event does not  */
+/* fit                                         */
+/*---------------------------------------------*/
+bool DCCTBDataParser::validEvent(uint32_t * pointerToEvent, uint32_t bytesToEnd, bool checkMarkers){
+
+  if( bytesToEnd < EMPTYEVENTSIZE ){ return false; }
+
+  uint32_t eventLength = pointerToEvent[2] & EVENTLENGTHMASK;
+  if( eventLength == 0 || eventLength > (bytesToEnd / 8) || eventLength < (EMPTYEVENTSIZE/8) ){ return false; }
+
+  if( !checkMarkers ){ return true; }
+
+  return ( (pointerToEvent[1] >> BOEBEGIN) & BOEMASK ) == BOE
+    &&   ( (pointerToEvent[eventLength*2-1] >> EOEBEGIN) & EOEMASK ) == EOE;
+}
+
+
+/*---------------------------------------------*/
+/* DCCTBDataParser::checkBufferSize              */
+/* throws if the buffer size is not a multiple */
+/* of 8 bytes or is less than an empty event   */
+/*---------------------------------------------*/
+void DCCTBDataParser::checkBufferSize(DCCTBParseContext & context, uint32_t bufferSize){
+  if( bufferSize%8  ){
+    std::string fatalError ;
+    fatalError += "\n ======================================================================"; 		
+    fatalError += "\n Fatal error at event = " + getDecString(context.events().size()+1);
+    fatalError += "\n Buffer Size of = "+ getDecString(bufferSize) + "[bytes] is not divisible by 8 ... ";
+    fatalError += "\n ======================================================================";
+    throw ECALTBParserException(fatalError);
+  }
+  if ( bufferSize < EMPTYEVENTSIZE ){
+    std::string fatalError ;
+    fatalError += "\n ======================================================================"; 		
+    fatalError += "\n Fatal error at event = " + getDecString(context.events().size()+1);
+    fatalError += "\n Buffer Size of = "+ getDecString(bufferSize) + "[bytes] is less than an empty event ... ";
+    fatalError += "\n ======================================================================";
+    throw ECALTBParserException(fatalError);
+  }
 }
 
 
@@ -216,7 +374,12 @@ void DCCTBDataParser::parseBuffer(uint32_t * buffer, uint32_t bufferSize, bool s
 /* and the event length                        */
 /*---------------------------------------------*/
 std::pair<uint32_t,uint32_t> DCCTBDataParser::checkEventLength(uint32_t *pointerToEvent, uint32_t bytesToEnd, bool singleEvent){
+  return checkEventLength(*context_, pointerToEvent, bytesToEnd, singleEvent);
+}
+
+std::pair<uint32_t,uint32_t> DCCTBDataParser::checkEventLength(DCCTBParseContext & context, uint32_t *pointerToEvent, uint32_t bytesToEnd, bool singleEvent){
 	
+  DCCTBErrorCounters & errors = context.errorCounters();
   std::pair<uint32_t,uint32_t> result;    //returns error mask and event length 
   uint32_t errorMask(0);          //error mask to return
 
@@ -224,7 +387,7 @@ std::pair<uint32_t,uint32_t> DCCTBDataParser::checkEventLength(uint32_t *pointer
   //(Note: we have to add one to read the 2nd 32 bit word where BOE is written)
   uint32_t *boePointer = pointerToEvent + 1;
   if( (  ((*boePointer)>>BOEBEGIN)& BOEMASK  )  != BOE ) { 
-    (errors_["DCC::BOE"])++; errorMask = 1; 
+    errors.add(DCCTBErrorCounters::DCC_BOE); errorMask = 1; 
   }
 	
 	
@@ -232,14 +395,14 @@ std::pair<uint32_t,uint32_t> DCCTBDataParser::checkEventLength(uint32_t *pointer
   uint32_t * myPointer = pointerToEvent + 2; 
   uint32_t eventLength = (*myPointer)&EVENTLENGTHMASK;
 
-  // std::cout << " Event Length(from decoding) = " << dec << eventLength << "... bytes to end... " << bytesToEnd << ", event numb : " << processedEvent_ << std::endl;
+  // std::cout << " Event Length(from decoding) = " << dec << eventLength << "... bytes to end... " << bytesToEnd << ", event numb : " << context.processedEvents() << std::endl;
   
   bool eoeError = false;
 
   //check if event is empty but but EVENT LENGTH is not corresponding to it
   if( singleEvent && eventLength != bytesToEnd/8 ){
     eventLength = bytesToEnd/8;
-    (errors_["DCC::EVENT LENGTH"])++; 
+    errors.add(DCCTBErrorCounters::DCC_EVENTLENGTH); 
     errorMask = errorMask | (1<<1);
   }
   //check if event length mismatches the number of words written as data
@@ -250,7 +413,7 @@ std::pair<uint32_t,uint32_t> DCCTBDataParser::checkEventLength(uint32_t *pointer
     std::string fatalError;
 		
     fatalError +="\n ======================================================================"; 		
-    fatalError +="\n Fatal error at event = " + getDecString(events_.size()+1);
+    fatalError +="\n Fatal error at event = " + getDecString(context.events().size()+1);
     fatalError +="\n Decoded event length = " + getDecString(eventLength);
     fatalError +="\n bytes to buffer end  = " + getDecString(bytesToEnd);
     fatalError +="\n Unable to procead the data decoding ...";
@@ -267,7 +430,7 @@ std::pair<uint32_t,uint32_t> DCCTBDataParser::checkEventLength(uint32_t *pointer
   //(Note: event length is multiplied by 2 because its written as 32 bit words and not 64 bit words)
   uint32_t *endOfEventPointer = pointerToEvent + eventLength*2 -1;
   if ( (  ((*endOfEventPointer) >> EOEBEGIN & EOEMASK )  != EOEMASK) && !eoeError ){ 
-    (errors_["DCC::EOE"])++; 
+    errors.add(DCCTBErrorCounters::DCC_EOE); 
     errorMask = errorMask | (1<<2); 
   }
   
@@ -346,10 +509,27 @@ std::string DCCTBDataParser::getIndexedData(uint32_t position, uint32_t *pointer
 /*-------------------------------------------------*/
 DCCTBDataParser::~DCCTBDataParser(){
   
-  // delete DCCTBEvents if any...
-  std::vector<DCCTBEventBlock *>::iterator it;
-  for(it=dccEvents_.begin();it!=dccEvents_.end();it++){delete *it;}
-  dccEvents_.clear();
+  // DCCTBEvents are deleted with the block pools of the context
+  delete context_;
     
   delete mapper_;
 }
+
+
+/*-------------------------------------------------*/
+/* get methods forwarded to the parser context     */
+/*-------------------------------------------------*/
+std::vector<DCCTBEventBlock *> & DCCTBDataParser::dccEvents()         { return context_->dccEvents();        }
+std::vector<DCCTBEventSoA *>   & DCCTBDataParser::soaEvents()         { return context_->soaEvents();        }
+DCCTBErrorCounters             & DCCTBDataParser::errorCounters()     { return context_->errorCounters();    }
+uint32_t * DCCTBDataParser::getBuffer()                               { return context_->getBuffer();        }
+uint32_t   DCCTBDataParser::blockAllocations()                        { return context_->blockAllocations(); }
+
+std::vector< std::pair< uint32_t, std::pair<uint32_t *, uint32_t> > > DCCTBDataParser::events() { return context_->events(); }
+
+DCCTBBlockPool<DCCTBEventBlock>   & DCCTBDataParser::eventBlockPool()   { return context_->eventBlockPool();   }
+DCCTBBlockPool<DCCTBTowerBlock>   & DCCTBDataParser::towerBlockPool()   { return context_->towerBlockPool();   }
+DCCTBBlockPool<DCCTBXtalBlock>    & DCCTBDataParser::xtalBlockPool()    { return context_->xtalBlockPool();    }
+DCCTBBlockPool<DCCTBTCCBlock>     & DCCTBDataParser::tccBlockPool()     { return context_->tccBlockPool();     }
+DCCTBBlockPool<DCCTBSRPBlock>     & DCCTBDataParser::srpBlockPool()     { return context_->srpBlockPool();     }
+DCCTBBlockPool<DCCTBTrailerBlock> & DCCTBDataParser::trailerBlockPool() { return context_->trailerBlockPool(); }
@@ -18,10 +18,22 @@
 #include "ECALParserException.h"      //DATA DECODER
 #include "DCCEventBlock.h"
 #include "DCCDataMapper.h"
+#include "DCCBlockPool.h"
+#include "DCCErrorCounters.h"
+#include "DCCGeometry.h"
 
 
 class DCCTBDataMapper;
 class DCCTBEventBlock;
+class DCCTBTowerBlock;
+class DCCTBXtalBlock;
+class DCCTBTCCBlock;
+class DCCTBSRPBlock;
+class DCCTBTrailerBlock;
+class DCCTBEventSoA;
+class DCCTBParseContext;
+class DCCTBRawFileReader;
+namespace edm { class ParameterSet; }
 
 
 class DCCTBDataParser{
@@ -29,7 +41,12 @@ class DCCTBDataParser{
 public : 
   
   /**
-     Class constructor: takes a vector of 10 parameters and flags for parseInternalData and debug
+     Class constructor: takes a vector of 10 parameters and flags for parseInternalData, debug, lazyDecoding and resync
+     With lazyDecoding the blocks only check their size when built and extract each data field
+     from the buffer on first access (the buffer must stay valid while the blocks are used)
+     With resync an event length that does not fit in a multi event buffer is no longer fatal:
+     the buffer is scanned up to the next valid event and the skipped bytes are recorded
+     in the context (see resyncEvent)
      Parameters are: 
      0 - crystal samples (default is 10)
      1 - number of trigger time samples (default is 1)
@@ -39,10 +56,24 @@ public :
      5 - SR id
      [6-9] - TCC[6-9] id
   */
-  DCCTBDataParser( const std::vector<uint32_t>& parserParameters , bool parseInternalData = true, bool debug = true);
+  DCCTBDataParser( const std::vector<uint32_t>& parserParameters , bool parseInternalData = true, bool debug = true, bool lazyDecoding = false, bool resync = false);
+
+  /**
+     Default parameters: 10 samples, 1 trigger sample, 68 TTs, 68 SR flags, DCC and SR id 1, TCC ids 1 to 4
+  */
+  static std::vector<uint32_t> defaultParameters();
+
+  /**
+     Parameters of an unpacking module: the untracked numbXtalSamples, numbTriggerSamples,
+     numbTTs, numbSRF, dccId, srpId and tccIds of pset, the defaults for the missing ones.
+     Values the parser does not support are reported to category and replaced by the
+     defaults (defined in EcalDCCParserParameters.cc, with the modules)
+  */
+  static std::vector<uint32_t> moduleParameters(const edm::ParameterSet & pset, const char * category);
   
   /**
-    Parse data from file 
+    Parse data from file (hexadecimal text or binary dump), read as a whole:
+    use DCCTBRawFileReader to parse large files one event at a time
   */
   void parseFile( std::string fileName, bool singleEvent = false);
 	
@@ -51,6 +82,47 @@ public :
   */
   void parseBuffer( uint32_t * buffer, uint32_t bufferSize, bool singleEvent = false);
 
+  /**
+     Decode data from a buffer into flat arrays (see DCCTBEventSoA), one walk per event
+     without building the block objects: only the DCC header, trigger primitives,
+     tower/xtal ids and xtal samples are kept (the buffer must stay valid while they are read)
+  */
+  void decodeToSoA( uint32_t * buffer, uint32_t bufferSize, bool singleEvent = false);
+
+  /**
+     Same as above, with all the per buffer state (events, blocks, error counters) kept
+     in context instead of the parser: different threads can use the same parser at the
+     same time, each with its own context (setParameters must not be called meanwhile)
+  */
+  void parseBuffer( DCCTBParseContext & context, uint32_t * buffer, uint32_t bufferSize, bool singleEvent = false);
+  void decodeToSoA( DCCTBParseContext & context, uint32_t * buffer, uint32_t bufferSize, bool singleEvent = false);
+
+  /**
+     Receives the events of walkEvents: offset in bytes from the start of the buffer/file,
+     words of the event (eventSize bytes readable), error mask and event length (64 bit
+     words) of checkEventLength
+  */
+  class EventVisitor{
+  public :
+    virtual ~EventVisitor(){}
+    virtual void addEvent( uint64_t offset, uint32_t * event, uint32_t eventSize, uint32_t errors, uint32_t length ) = 0;
+  };
+
+  /**
+     Walks the events of buffer as parseBuffer finds them (throws ECALTBParserException as
+     parseBuffer does), or the events of the file of reader from its first event (with resync
+     on, the bytes skipped are recorded in reader.skippedRanges()), reading only their headers
+     (checkEventLength): no block is built, each event is given to visitor and its errors are
+     counted in context
+  */
+  void walkEvents( DCCTBParseContext & context, uint32_t * buffer, uint32_t bufferSize, EventVisitor & visitor );
+  void walkEvents( DCCTBParseContext & context, DCCTBRawFileReader & reader, EventVisitor & visitor );
+
+  /**
+     Get method for the context used by the methods without a context argument
+  */
+  DCCTBParseContext * context();
+
   /**
      Get method for DCCTBDataMapper
   */
@@ -61,6 +133,23 @@ public :
      returns 3 bits code with the error found + event length
   */
   std::pair<uint32_t,uint32_t> checkEventLength(uint32_t * pointerToEvent, uint32_t bytesToEnd, bool singleEvent = false);
+  std::pair<uint32_t,uint32_t> checkEventLength(DCCTBParseContext & context, uint32_t * pointerToEvent, uint32_t bytesToEnd, bool singleEvent = false);
+  
+  /**
+     With resync on and in a multi event buffer: if the event length of the event at pointerToEvent
+     (bufferOffset bytes from the start of the buffer) is 0, less than an empty event or more than
+     bytesToEnd, looks for the next 64 bit word with the BOE nibble, an event length that fits and
+     the EOE nibble in the last word of the event. Returns the number of bytes to skip to get there
+     (bytesToEnd if there is no valid event left), recorded in the context skipped ranges, or 0 if
+     the event length is fine (or resync is off: checkEventLength then throws as usual)
+  */
+  uint32_t resyncEvent(DCCTBParseContext & context, uint32_t * pointerToEvent, uint32_t bufferOffset, uint32_t bytesToEnd, bool singleEvent = false);
+
+  /**
+     Throws ECALTBParserException if bufferSize is not a multiple of 8 bytes
+     or is less than an empty event
+  */
+  void checkBufferSize(DCCTBParseContext & context, uint32_t bufferSize);
   
   /**
      Get methods for parser parameters;
@@ -91,9 +180,26 @@ public :
   uint32_t tccBlockSize();
 
   /**
-     Get methods for debug flag
+     Block sizes and sample positions of the current parameters
+  */
+  DCCTBGeometry & geometry();
+
+  /**
+     Projection: only the fields of the groups set in fieldGroups (see below) and the fields
+     of ids (mapper field ids) are decoded when a block is parsed, any other field is extracted
+     from the buffer on access as in lazy decoding (the buffer must stay valid while the blocks
+     are used). A block that does not fit in the event is still decoded as a whole, with the
+     usual errors. ALLFIELDS (the default) decodes every field. Must not be called while
+     buffers are parsed, decodeToSoA does not use it
+  */
+  void  setProjection( uint32_t fieldGroups, const std::vector<DCCTBFieldId> & ids = std::vector<DCCTBFieldId>() );
+
+  /**
+     Get methods for debug and lazy decoding flags
   */
   bool  debug();
+  bool  lazyDecoding();
+  bool  resync();
 
   /**
      Get method for DCCEventBlocks vector
@@ -101,9 +207,37 @@ public :
   std::vector<DCCTBEventBlock *> & dccEvents();
 
   /**
-     Get method for error counters map
+     Get method for the events decoded by decodeToSoA (valid until the next buffer is decoded)
+  */
+  std::vector<DCCTBEventSoA *> & soaEvents();
+
+  /**
+     Get methods for the block pools: blocks are recycled from buffer to buffer
+     and stay valid until the next buffer is parsed (pools of the parser context)
+  */
+  DCCTBBlockPool<DCCTBEventBlock>   & eventBlockPool();
+  DCCTBBlockPool<DCCTBTowerBlock>   & towerBlockPool();
+  DCCTBBlockPool<DCCTBXtalBlock>    & xtalBlockPool();
+  DCCTBBlockPool<DCCTBTCCBlock>     & tccBlockPool();
+  DCCTBBlockPool<DCCTBSRPBlock>     & srpBlockPool();
+  DCCTBBlockPool<DCCTBTrailerBlock> & trailerBlockPool();
+
+  /**
+     Number of block objects allocated while parsing the last buffer
+     (0 once the pools have grown to the size of the events)
+  */
+  uint32_t blockAllocations();
+
+  /**
+     Get method for the error counters of the last buffer (DCC event checks of the parser context)
+  */
+  DCCTBErrorCounters & errorCounters();
+
+  /**
+     Error counters summed over all the buffers parsed or decoded by this parser, with any
+     context, and over the errors found in their blocks (atomic: shared by the threads)
   */
-  std::map<std::string,uint32_t> & errorCounters();
+  DCCTBErrorCounters & runErrorCounters() { return runErrors_; }
 
   /**
    * Get method for events
@@ -128,7 +262,7 @@ public :
   /**
    * Retrieves a pointer to the data buffer
    */
-  uint32_t *getBuffer() { return buffer_;}
+  uint32_t *getBuffer();
   
   /**
      Class destructor
@@ -138,28 +272,36 @@ public :
   enum DCCDataParserGlobalFields{
     EMPTYEVENTSIZE = 32                   //bytes
   };
+
+  //field groups of setProjection: all the fields of the blocks of each kind
+  enum fieldGroups{
+    DCCHEADER     = 1<<0,                 //DCC header (and empty event) fields
+    TCCPRIMITIVES = 1<<1,                 //TCC blocks
+    SRPFLAGS      = 1<<2,                 //SRP blocks
+    TOWERHEADERS  = 1<<3,                 //tower block headers
+    XTALSAMPLES   = 1<<4,                 //crystal blocks (ids and samples)
+    TRAILER       = 1<<5,                 //DCC trailer
+    ALLFIELDS     = (1<<6)-1
+  };
  
 protected :
-  void computeBlockSizes();
+  void countErrors(DCCTBEventSoA * event);
+  bool validEvent(uint32_t * pointerToEvent, uint32_t bytesToEnd, bool checkMarkers);
 
-  uint32_t *buffer_;                //data buffer
-  uint32_t bufferSize_;             //buffer size
+  std::vector<uint32_t> fileBuffer_; //data buffer read by parseFile
 
-  uint32_t srpBlockSize_;           //SR block size
-  uint32_t tccBlockSize_;           //TCC block size
+  DCCTBGeometry geometry_;          //block sizes of the parameters
 
-  uint32_t processedEvent_;
-  std::string eventErrors_;
   DCCTBDataMapper *mapper_;
   
-  std::vector<DCCTBEventBlock *> dccEvents_;
+  DCCTBParseContext *context_;      //context of the methods without a context argument
   
-  // std::pair< errorMask, std::pair< pointer to event, event size (number of DW)> >
-  std::vector< std::pair< uint32_t, std::pair<uint32_t *, uint32_t> > > events_;
+  DCCTBErrorCounters runErrors_;    //error counters of all the parse calls
   
   bool parseInternalData_;          //parse internal data flag
   bool debug_;                      //debug flag
-  std::map<std::string,uint32_t> errors_;        //errors map
+  bool lazyDecoding_;               //lazy field decoding flag
+  bool resync_;                     //resynchronization on bad event lengths flag
   std::vector<uint32_t> parameters;         //parameters vector
 
   enum DCCTBDataParserFields{
@@ -190,15 +332,16 @@ inline uint32_t DCCTBDataParser::tcc2Id()              { return parameters[7]; }
 inline uint32_t DCCTBDataParser::tcc3Id()              { return parameters[8]; } 
 inline uint32_t DCCTBDataParser::tcc4Id()              { return parameters[9]; }
 
-inline void  DCCTBDataParser::setParameters( const std::vector<uint32_t>& newParameters ){ parameters = newParameters; computeBlockSizes();}
+inline void  DCCTBDataParser::setParameters( const std::vector<uint32_t>& newParameters ){ parameters = newParameters; geometry_.compute(parameters);}
 
-inline uint32_t DCCTBDataParser::srpBlockSize()        { return srpBlockSize_; } 
-inline uint32_t DCCTBDataParser::tccBlockSize()        { return tccBlockSize_; } 
+inline uint32_t DCCTBDataParser::srpBlockSize()        { return geometry_.srpBlockSize(); } 
+inline uint32_t DCCTBDataParser::tccBlockSize()        { return geometry_.tccBlockSize(); } 
+inline DCCTBGeometry & DCCTBDataParser::geometry()     { return geometry_; }
 
 inline bool DCCTBDataParser::debug()                          { return debug_;     }
-inline std::vector<DCCTBEventBlock *> &DCCTBDataParser::dccEvents()  { return dccEvents_;    }
-inline std::map<std::string,uint32_t> &DCCTBDataParser::errorCounters()    { return errors_;       }
-inline std::vector< std::pair< uint32_t, std::pair<uint32_t *, uint32_t> > > DCCTBDataParser::events() { return events_;   }
+inline bool DCCTBDataParser::lazyDecoding()                   { return lazyDecoding_; }
+inline bool DCCTBDataParser::resync()                         { return resync_;    }
+inline DCCTBParseContext * DCCTBDataParser::context()         { return context_;   }
 
 
 #endif
@@ -0,0 +1,103 @@
+#include "DCCErrorCounters.h"
+
+#include <sstream>
+
+
+static const char * categoryNames[DCCTBErrorCounters::NUMBCATEGORIES] = {
+  "DCC::BOE",
+  "DCC::EOE",
+  "DCC::EVENT LENGTH",
+  "DCC::RESYNC",
+  "DCC::HEADER",
+  "DCC::HEADER EVENT LENGTH",
+  "DCC::NEXT BLOCK",
+  "DCC::TRIGGER TYPE",
+  "BLOCK::OUT OF SCOPE",
+  "SRP::HEADER",
+  "SRP::BLOCKID",
+  "TCC::HEADER",
+  "TCC::BLOCKID",
+  "FE::HEADER",
+  "FE::TT/SC ID",
+  "FE::BLOCK LENGTH",
+  "XTAL::HEADER",
+  "XTAL::BLOCKID",
+  "TRAILER::EVENT LENGTH",
+  "TRAILER::EOE",
+  "TRAILER::CRC",
+  "TRAILER::T"
+};
+
+
+
+/*----------------------------------------------*/
+/* DCCTBErrorCounters::DCCTBErrorCounters         */
+/* class constructor                            */
+/*----------------------------------------------*/
+DCCTBErrorCounters::DCCTBErrorCounters(){ reset(); }
+
+
+/*----------------------------------------------*/
+/* DCCTBErrorCounters::add                        */
+/* adds the counters of other                   */
+/*----------------------------------------------*/
+void DCCTBErrorCounters::add(DCCTBErrorCounters & other){
+
+  for(uint32_t c=0; c<NUMBCATEGORIES; c++){
+    if( other.counts_[c] ){ __sync_fetch_and_add( &counts_[c], (uint64_t) other.counts_[c] ); }
+  }
+  addEvents( other.events_ );
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBErrorCounters::total                      */
+/* sum of all the counters                      */
+/*----------------------------------------------*/
+uint64_t DCCTBErrorCounters::total(){
+
+  uint64_t sum(0);
+  for(uint32_t c=0; c<NUMBCATEGORIES; c++){ sum += counts_[c]; }
+  return sum;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBErrorCounters::reset                      */
+/* sets all the counters to 0                   */
+/*----------------------------------------------*/
+void DCCTBErrorCounters::reset(){
+
+  for(uint32_t c=0; c<NUMBCATEGORIES; c++){ counts_[c] = 0; }
+  events_ = 0;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBErrorCounters::name                       */
+/* name of an error category                    */
+/*----------------------------------------------*/
+std::string DCCTBErrorCounters::name(errorCategory c){
+  return std::string( categoryNames[c] );
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBErrorCounters::summary                    */
+/* events and non zero counters, one per line   */
+/*----------------------------------------------*/
+std::string DCCTBErrorCounters::summary(){
+
+  std::ostringstream out;
+  out << " DCC events decoded : " << events_;
+
+  if( !total() ){
+    out << "\n No decoding error";
+    return out.str();
+  }
+
+  for(uint32_t c=0; c<NUMBCATEGORIES; c++){
+    if( counts_[c] ){ out << "\n " << categoryNames[c] << " : " << counts_[c]; }
+  }
+  return out.str();
+}
@@ -0,0 +1,97 @@
+/*----------------------------------------------------------*/
+/* DCC ERROR COUNTERS                                       */
+/* one counter per error category found while decoding DCC  */
+/* data. The counters are only touched when an error is     */
+/* found, with atomic increments: the run counters of a     */
+/* parser (see DCCTBDataParser::runErrorCounters) are       */
+/* shared by all the threads using it and summed up at the  */
+/* end of the job                                           */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBERRORCOUNTERS_HH
+#define DCCTBERRORCOUNTERS_HH
+
+#include <string>
+#include <stdint.h>
+
+
+class DCCTBErrorCounters{
+
+public :
+
+  enum errorCategory{
+    DCC_BOE = 0,               // begin of event (header B[60-63])
+    DCC_EOE,                   // end of event (trailer B[60-63])
+    DCC_EVENTLENGTH,           // event length (trailer B[32-55]) does not fit in the buffer
+    DCC_RESYNC,                // bytes skipped to find a valid event
+    DCC_HEADER,                // DCC header words
+    DCC_HEADEREVENTLENGTH,     // event length of the header differs from the event size
+    DCC_NEXTBLOCK,             // unable to get the next block position (decoding stopped)
+    DCC_TRIGGERTYPE,           // trigger type not supported (no tower decoded)
+    BLOCK_OUTOFSCOPE,          // block data field out of the event
+    SRP_HEADER,
+    SRP_BLOCKID,
+    TCC_HEADER,
+    TCC_BLOCKID,
+    FE_HEADER,
+    FE_TTSCID,
+    FE_BLOCKLENGTH,
+    XTAL_HEADER,
+    XTAL_BLOCKID,
+    TRAILER_EVENTLENGTH,
+    TRAILER_EOE,
+    TRAILER_CRC,
+    TRAILER_T,
+    NUMBCATEGORIES
+  };
+
+  DCCTBErrorCounters();
+
+  /**
+     Counts n errors of category c (atomic increment)
+  */
+  void add( errorCategory c, uint32_t n = 1 ) { __sync_fetch_and_add( &counts_[c], (uint64_t) n ); }
+
+  /**
+     Adds all the counters of other
+  */
+  void add( DCCTBErrorCounters & other );
+
+  /**
+     Counts n decoded events (to give the error rates in the summary)
+  */
+  void addEvents( uint32_t n )                { __sync_fetch_and_add( &events_, (uint64_t) n ); }
+
+  uint64_t count( errorCategory c )           { return counts_[c]; }
+  uint64_t operator[]( errorCategory c )      { return counts_[c]; }
+  uint64_t events()                           { return events_;    }
+
+  /**
+     Sum of all the counters
+  */
+  uint64_t total();
+
+  void reset();
+
+  /**
+     Name of a category ("FE::BLOCK LENGTH", "XTAL::BLOCKID", ...)
+  */
+  static std::string name( errorCategory c );
+
+  /**
+     Number of events and counters of the categories with errors, one per line
+  */
+  std::string summary();
+
+protected :
+
+  volatile uint64_t counts_[NUMBCATEGORIES];
+  volatile uint64_t events_;
+
+private :
+
+  DCCTBErrorCounters( const DCCTBErrorCounters & );
+  DCCTBErrorCounters & operator=( const DCCTBErrorCounters & );
+};
+
+#endif
@@ -8,6 +8,8 @@
 #include "DCCTCCBlock.h"
 #include "DCCXtalBlock.h"
 #include "DCCTrailerBlock.h"
+#include "DCCParseContext.h"
+#include "DCCTowerStatus.h"
 
 #include <iomanip>
 #include <sstream>
@@ -20,14 +22,38 @@ DCCTBEventBlock::DCCTBEventBlock(
 	uint32_t wordBufferOffset , 
 	uint32_t wordEventOffset 
 ) : 
-DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
-,dccTrailerBlock_(0),srpBlock_(0),wordBufferOffset_(wordBufferOffset) {
+DCCTBBlockPrototype()
+,dccTrailerBlock_(0),srpBlock_(0),context_(0),wordBufferOffset_(wordBufferOffset) {
 	
+	initialize(parser, buffer, numbBytes, wordsToEnd, wordBufferOffset, wordEventOffset);
+}
+
+
+
+DCCTBEventBlock::DCCTBEventBlock() : 
+DCCTBBlockPrototype()
+,dccTrailerBlock_(0),srpBlock_(0),context_(0),wordBufferOffset_(0),emptyEvent(false) { }
+
+
+
+void DCCTBEventBlock::initialize(
+	DCCTBDataParser * parser, 
+	uint32_t * buffer, 
+	uint32_t numbBytes, 
+	uint32_t wordsToEnd, 
+	uint32_t wordBufferOffset , 
+	uint32_t wordEventOffset ,
+	DCCTBParseContext * context
+){
+	
+	DCCTBBlockPrototype::initialize(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd);
+	context_          = context ? context : parser->context();
+	dccTrailerBlock_  = 0;
+	srpBlock_         = 0;
+	wordBufferOffset_ = wordBufferOffset;
+	towerBlocks_.clear();
+	tccBlocks_.clear();
 	
-	//Reset error counters ////
-	errors_["DCC::HEADER"] = 0;
-	errors_["DCC::EVENT LENGTH"] = 0;
-	///////////////////////////
 	
 	uint32_t wToEnd(0);
 	
@@ -42,8 +68,7 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 			emptyEvent = false;
 		}
 		
-		try{ parseData(); }
-		catch (ECALTBParserBlockException &e){/*ignore*/}
+		parseData();     // an out of scope error is recorded, the checks below are still done
 		///////////////////////////////////////////////////////
 		
 
@@ -55,24 +80,29 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 	
 		// Check if empty event was produced /////////////////////////////////////////////////////////////////
 
-		if( !emptyEvent && getDataField("DCC ERRORS")!= DCCERROR_EMPTYEVENT ){
+		if( !emptyEvent && getDataField(DCCTBDataMapper::DCCERRORS_ID)!= DCCERROR_EMPTYEVENT ){
 			 		
 			// Build the SRP block ////////////////////////////////////////////////////////////////////////////////////
 		
 			bool srp(false);
-			uint32_t sr_ch = getDataField("SR_CHSTATUS");
+			uint32_t sr_ch = getDataField(DCCTBDataMapper::SR_CHSTATUS_ID);
 			if( sr_ch!=CH_TIMEOUT  && sr_ch != CH_DISABLED ){ 			
 				
 				//Go to the begining of the block
-				increment(1," (while trying to create a SR Block !)");
+				if( !nextBlock(1, DCCTBBlockError::NEXTSRP) ){ return; }
 				wToEnd = numbBytes/4-wordCounter_-1;	
 				
 				// Build SRP Block //////////////////////////////////////////////////////////////////////
-				srpBlock_ = new DCCTBSRPBlock( this, parser_, dataP_, parser_->srpBlockSize(), wToEnd,wordCounter_);
+				DCCTBSRPBlock * srpBlock = context_->srpBlockPool().get();
+				if( !srpBlock->initialize( this, parser_, dataP_, parser_->srpBlockSize(), wToEnd,wordCounter_) ){
+					addError(DCCTBBlockError::SUBBLOCK, srpBlock);
+					return;
+				}
+				srpBlock_ = srpBlock;
 				//////////////////////////////////////////////////////////////////////////////////////////
 		
-				increment((parser_->srpBlockSize())/4-1);
-				if(getDataField("SR")){ srp=true; }
+				if( !nextBlock((parser_->srpBlockSize())/4-1) ){ return; }
+				if(getDataField(DCCTBDataMapper::SR_ID)){ srp=true; }
 			}	
 			
 			////////////////////////////////////////////////////////////////////////////////////////////////////////////		
@@ -86,15 +116,14 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 				if( i == 3){ tccId = parser_->tcc3Id();}	
 				if( i == 4){ tccId = parser_->tcc4Id();}
 				
-				std::string tcc = std::string("TCC_CHSTATUS#") + parser_->getDecString(i);	
-				tcc_ch = getDataField(tcc);
+				tcc_ch = getDataField(parser_->mapper()->tccChStatusId(i));
 				
 				if( tcc_ch != CH_TIMEOUT && tcc_ch != CH_DISABLED){	 
 					
 					//std::cout<<"\n debug:Building TCC Block, channel enabled without errors"<<std::endl;
 					
 					// Go to the begining of the block
-					increment(1," (while trying to create a"+tcc+" Block !)");
+					if( !nextBlock(1, DCCTBBlockError::NEXTTCC, i) ){ return; }
 					
 					wToEnd = numbBytes/4-wordCounter_-1;	
 					//wToEnd or wordsToEnd ????????????????????????????????????????
@@ -102,10 +131,15 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 				
 					
 					// Build TCC Block /////////////////////////////////////////////////////////////////////////////////
-					tccBlocks_.push_back(  new DCCTBTCCBlock( this, parser_, dataP_,parser_->tccBlockSize(), wToEnd,wordCounter_, tccId));
+					DCCTBTCCBlock * tccBlock = context_->tccBlockPool().get();
+					if( !tccBlock->initialize( this, parser_, dataP_,parser_->tccBlockSize(), wToEnd,wordCounter_, tccId) ){
+						addError(DCCTBBlockError::SUBBLOCK, tccBlock);
+						return;
+					}
+					tccBlocks_.push_back( tccBlock );
 					//////////////////////////////////////////////////////////////////////////////////////////////////////	
 					
-					increment((parser_->tccBlockSize())/4-1);
+					if( !nextBlock((parser_->tccBlockSize())/4-1) ){ return; }
 				}
 			}
 			////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -115,15 +149,14 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 			// Build channel data //////////////////////////////////////////////////////////////////////////////////////////////////////	
 			// See number of channels that we need according to the trigger type //
 			// TODO : WHEN IN LOCAL MODE WE SHOULD CHECK RUN TYPE
-			uint32_t triggerType = getDataField("TRIGGER TYPE");			
+			uint32_t triggerType = getDataField(DCCTBDataMapper::TRIGGERTYPE_ID);			
 			uint32_t numbChannels;
 			if( triggerType == PHYSICTRIGGER )          { numbChannels = 68; }
 			else if (triggerType == CALIBRATIONTRIGGER ){ numbChannels = 70; }
 			// TODO :: implement other triggers
 			else{
-			  std::string error = std::string("\n DCC::HEADER TRIGGER TYPE = ")+parser_->getDecString(triggerType)+std::string(" is not a valid type !");
-				ECALTBParserBlockException a(error);
-				throw a;
+				addError(DCCTBBlockError::TRIGGERTYPE, this, DCCTBDataMapper::TRIGGERTYPE_ID, 0, 0, triggerType);
+				return;
 			}
 			////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 			
@@ -135,12 +168,11 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 			
 			for( uint32_t i=1; i<=numbChannels; i++){
 				
-			  std::string chStatusId = std::string("FE_CHSTATUS#") + parser_->getDecString(i);
-				uint32_t chStatus = getDataField(chStatusId);
+				uint32_t chStatus = getDataField(parser_->mapper()->feChStatusId(i));
 				
 				// If srp is on, we need to check if channel was suppressed ////////////////////
 				if(srp){ 
-					srFlag   = srpBlock_->getDataField( std::string("SR#") + parser_->getDecString(i));
+					srFlag   = srpBlock_->getDataField( parser_->mapper()->srId(i) );
 					if(srFlag == SR_NREAD){ suppress = true; }
 					else{ suppress = false; }
 				}
@@ -151,20 +183,24 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 
 					
 					//Go to the begining of the block ///////////////////////////////////////////////////////////////////////
-					increment(1," (while trying to create a TOWERHEADER Block for channel "+parser_->getDecString(i)+" !)" );
+					if( !nextBlock(1, DCCTBBlockError::NEXTTOWER, i) ){ return; }
 					/////////////////////////////////////////////////////////////////////////////////////////////////////////
 					
 					
 					// Instantiate a new tower block//////////////////////////////////////////////////////////////////////////
 					wToEnd = numbBytes/4-wordCounter_-1;
-					DCCTBTowerBlock * towerBlock = new DCCTBTowerBlock(this,parser_,dataP_,TOWERHEADER_SIZE,wToEnd,wordCounter_,i); 
+					DCCTBTowerBlock * towerBlock = context_->towerBlockPool().get();
+					if( !towerBlock->initialize(this,parser_,dataP_,TOWERHEADER_SIZE,wToEnd,wordCounter_,i) ){
+						addError(DCCTBBlockError::SUBBLOCK, towerBlock);
+						return;
+					}
 					towerBlocks_.push_back (towerBlock);
-					towerBlock->parseXtalData();
+					if( !towerBlock->parseXtalData() ){ return; }
 					//////////////////////////////////////////////////////////////////////////////////////////////////////////
 					
 					
 					//go to the end of the block ///////////////////////////////
-					increment((towerBlock->getDataField("BLOCK LENGTH"))*2 - 1);
+					if( !nextBlock((towerBlock->getDataField(DCCTBDataMapper::TOWERLENGTH_ID))*2 - 1) ){ return; }
 					////////////////////////////////////////////////////////////
 						
 				}
@@ -173,19 +209,22 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 			
 
 			// go to the begining of the block ////////////////////////////////////////////////////////////////////			
-			increment(1," (while trying to create a DCC TRAILER Block !)");
+			if( !nextBlock(1, DCCTBBlockError::NEXTTRAILER) ){ return; }
 			wToEnd = numbBytes/4-wordCounter_-1;
-			dccTrailerBlock_ = new DCCTBTrailerBlock(parser_,dataP_,TRAILER_SIZE,wToEnd,wordCounter_,blockSize_/8,0);
+			DCCTBTrailerBlock * trailerBlock = context_->trailerBlockPool().get();
+			if( !trailerBlock->initialize(parser_,dataP_,TRAILER_SIZE,wToEnd,wordCounter_,blockSize_/8,0) ){
+				addError(DCCTBBlockError::SUBBLOCK, trailerBlock);
+				return;
+			}
+			dccTrailerBlock_ = trailerBlock;
 			//////////////////////////////////////////////////////////////////////////////////////////////////////
 			
 		}
 	
 	}catch( ECALTBParserException & e){}
 	catch( ECALTBParserBlockException & e){
-	  // uint32_t nEv = (parser_->dccEvents()).size() +1;
-	  errorString_ += std::string(e.what());
-	  blockError_=true;
-	  //std::cout<<"cout"<<e.what();
+	  // fields missing from a truncated header
+	  addError(std::string(e.what()));
 	}
 	
 	
@@ -194,39 +233,35 @@ DCCTBBlockPrototype(parser,"DCCHEADER", buffer, numbBytes,wordsToEnd)
 
 
 
-DCCTBEventBlock::~DCCTBEventBlock(){
+bool DCCTBEventBlock::nextBlock(uint32_t numb, DCCTBBlockError::errorType type, uint32_t channel){
 	
-	std::vector<DCCTBTCCBlock *>::iterator it1;
-	for(it1=tccBlocks_.begin();it1!=tccBlocks_.end();it1++){ delete (*it1);}
-	tccBlocks_.clear();
-	
-	std::vector<DCCTBTowerBlock *>::iterator it2;
-	for(it2=towerBlocks_.begin();it2!=towerBlocks_.end();it2++){ delete (*it2);}
-	towerBlocks_.clear();
-	
-	if(srpBlock_ !=        0 ) { delete srpBlock_;       }
-	if(dccTrailerBlock_ != 0 ) { delete dccTrailerBlock_;}
+	if( increment(numb) ){ return true; }
 	
+	// the error text is built only if asked for (eventErrorString)
+	addError(type, this, 0, wordCounter_ + wordEventOffset_, numb, 0, channel);
+	return false;
 }
 
 
 
+// sub-blocks belong to the parser block pools
+DCCTBEventBlock::~DCCTBEventBlock(){ }
+
+
+
 void DCCTBEventBlock::dataCheck(){
 	
 	
-	std::string checkErrors("");
+	uint32_t firstError = blockErrors_.size();
 	
 	
 	// Check BOE field/////////////////////////////////////////////////////
-	std::pair<bool,std::string> res =  checkDataField("BOE",BOE);
-	if(!res.first){ checkErrors += res.second; (errors_["DCC::HEADER"])++; }
+	if( !checkField(DCCTBDataMapper::BOE_ID,BOE) ){ countError(DCCTBErrorCounters::DCC_HEADER); }
 	///////////////////////////////////////////////////////////////////////
 	
 	
 	// Check H Field //////////////////////////////////////////////////////
-	std::string hField= std::string("H");
-	res = checkDataField(hField,1);
-	if(!res.first){ checkErrors += res.second; (errors_["DCC::HEADER"])++; }
+	if( !checkField(DCCTBDataMapper::H_ID,1) ){ countError(DCCTBErrorCounters::DCC_HEADER); }
 	////////////////////////////////////////////////////////////////////////
 	
 	
@@ -237,27 +272,17 @@ void DCCTBEventBlock::dataCheck(){
 	else if(!emptyEvent){ dccHeaderWords = 7;}
 
 	for(uint32_t i = 1; i<=dccHeaderWords ; i++){
-
-		std::string header= std::string("H") + parser_->getDecString(i);
-		res = checkDataField(header,i);
-		if(!res.first){ checkErrors += res.second; (errors_["DCC::HEADER"])++; }
+		if( !checkField(parser_->mapper()->headerId(i),i) ){ countError(DCCTBErrorCounters::DCC_HEADER); }
 	}
 	////////////////////////////////////////////////////////////////////////////
 	
 	
 	// Check event length ///////////////////////////////////////////////////////
-	res = checkDataField("EVENT LENGTH",blockSize_/8);
-	if(!res.first){ checkErrors += res.second; (errors_["DCC::EVENT LENGTH"])++; }
+	if( !checkField(DCCTBDataMapper::EVENTLENGTH_ID,blockSize_/8) ){ countError(DCCTBErrorCounters::DCC_HEADEREVENTLENGTH); }
 	/////////////////////////////////////////////////////////////////////////////
 		
 	
-	if(checkErrors!=""){
-		errorString_ +="\n ======================================================================\n"; 		
-		errorString_ += std::string(" ") + name_ + std::string(" data fields checks errors : ") ;
-		errorString_ += checkErrors ;
-		errorString_ += "\n ======================================================================";
-		blockError_ = true;	
-	}
+	endChecks(firstError);
 	
 	
 }
@@ -426,10 +451,14 @@ std::pair<bool,std::string> DCCTBEventBlock::compare(DCCTBEventBlock * block){
 }
 			
 		
-		
-		
-		
-		
+
+
+uint32_t * DCCTBEventBlock::headerWords(){
+
+	bool complete = !emptyEvent && blockSize_/4 >= DCCTBTowerStatus::HEADERWORDS
+		&& wordsToEndOfEvent_ >= DCCTBTowerStatus::HEADERWORDS-1;
+	return complete ? beginOfBuffer_ : 0;
+}
 		
 		
 
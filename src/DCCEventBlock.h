@@ -13,6 +13,7 @@ class DCCTBDataParser;
 class DCCTBTrailerBlock;
 class DCCTBTCCBlock;
 class DCCTBSRPBlock;
+class DCCTBParseContext;
 
 class DCCTBEventBlock : public DCCTBBlockPrototype {
 	
@@ -27,6 +28,23 @@ class DCCTBEventBlock : public DCCTBBlockPrototype {
 			uint32_t wordEventOffset = 0 
 		);
 		
+		DCCTBEventBlock();
+		
+		/**
+		   Decodes a new event: the sub-blocks are taken from the block pools of context
+		   (the parser own context if 0), which own them (they stay valid until the next
+		   buffer is parsed with that context)
+		*/
+		void initialize(
+			DCCTBDataParser * parser, 
+			uint32_t * buffer, 
+			uint32_t numbBytes, 
+			uint32_t wordsToEnd, 
+			uint32_t wordBufferOffset = 0 , 
+			uint32_t wordEventOffset = 0 ,
+			DCCTBParseContext * context = 0
+		);
+		
 		~DCCTBEventBlock();
 		
 		void dataCheck(); 
@@ -41,9 +59,18 @@ class DCCTBEventBlock : public DCCTBBlockPrototype {
 		bool eventHasErrors();
 		std::string eventErrorString();
 		void displayEvent(std::ostream & os=std::cout);
+
+		DCCTBParseContext * context() { return context_; }
+
+		// DCC header words, 0 if the event does not hold the complete header (empty or truncated event)
+		uint32_t * headerWords();
 	
 		
 	protected :
+		
+		// increment, recording the error (of type) if the next block can not be reached
+		bool nextBlock(uint32_t numb, DCCTBBlockError::errorType type = DCCTBBlockError::NEXTBLOCK, uint32_t channel = 0);
+		
 		enum dccFields{ 
 			
 			PHYSICTRIGGER        = 1,
@@ -73,6 +100,7 @@ class DCCTBEventBlock : public DCCTBBlockPrototype {
 		std::vector< DCCTBTCCBlock   * > tccBlocks_        ;
 		DCCTBTrailerBlock       *   dccTrailerBlock_  ;
 		DCCTBSRPBlock           *   srpBlock_;
+		DCCTBParseContext       *   context_;
 		uint32_t wordBufferOffset_;
 		bool emptyEvent;
 };
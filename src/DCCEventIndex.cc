@@ -0,0 +1,230 @@
+#include "DCCEventIndex.h"
+#include "DCCDataParser.h"
+#include "DCCDataMapper.h"
+#include "DCCParseContext.h"
+#include "DCCRawFileReader.h"
+#include "ECALParserException.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+
+static const char sidecarMagic[8] = {'D','C','C','T','B','I','D','X'};
+
+static bool fileStatus(std::string fileName, uint64_t & size, uint64_t & mtime){
+  struct stat fileStat;
+  if( stat(fileName.c_str(),&fileStat) ){ return false; }
+  size  = fileStat.st_size;
+  mtime = fileStat.st_mtime;
+  return true;
+}
+
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::DCCTBEventIndex               */
+/* class constructor                            */
+/*----------------------------------------------*/
+DCCTBEventIndex::DCCTBEventIndex(){}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::addEvent                      */
+/* stores the header fields of one event        */
+/*----------------------------------------------*/
+void DCCTBEventIndex::addEvent(uint64_t offset, uint32_t * event, uint32_t eventSize, uint32_t errors, uint32_t length){
+
+  Entry e;
+  e.offset = offset;
+  e.length = (event[DCCTBDataMapper::EVENTLENGTH_WPOSITION] >> DCCTBDataMapper::EVENTLENGTH_BPOSITION) & DCCTBDataMapper::EVENTLENGTH_MASK;
+  e.lv1    = (event[DCCTBDataMapper::DCCL1_WPOSITION]       >> DCCTBDataMapper::DCCL1_BPOSITION)       & DCCTBDataMapper::DCCL1_MASK;
+  e.bx     = (event[DCCTBDataMapper::DCCBX_WPOSITION]       >> DCCTBDataMapper::DCCBX_BPOSITION)       & DCCTBDataMapper::DCCBX_MASK;
+  e.errors = errors;
+
+  entries_.push_back(e);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::build                         */
+/* indexes the events of a buffer: same walk    */
+/* as DCCTBDataParser::parseBuffer              */
+/*----------------------------------------------*/
+void DCCTBEventIndex::build(DCCTBDataParser & parser, uint32_t * buffer, uint32_t bufferSize){
+
+  entries_.clear();
+  lv1Index_.clear();
+
+  DCCTBParseContext context;                //error counters of the index pass
+  parser.walkEvents(context, buffer, bufferSize, *this);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::build                         */
+/* indexes the events of a file                 */
+/*----------------------------------------------*/
+void DCCTBEventIndex::build(DCCTBDataParser & parser, DCCTBRawFileReader & reader){
+
+  entries_.clear();
+  lv1Index_.clear();
+
+  DCCTBParseContext context;
+  parser.walkEvents(context, reader, *this);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::findByLV1                     */
+/* binary search on the events sorted by LV1    */
+/*----------------------------------------------*/
+uint32_t DCCTBEventIndex::findByLV1(uint32_t lv1){
+
+  if( lv1Index_.size() != entries_.size() ){
+    lv1Index_.clear();
+    lv1Index_.reserve(entries_.size());
+    for(uint32_t i=0; i<entries_.size(); i++){
+      lv1Index_.push_back( std::pair<uint32_t,uint32_t>(entries_[i].lv1,i) );
+    }
+    std::sort(lv1Index_.begin(), lv1Index_.end());
+  }
+
+  std::vector< std::pair<uint32_t,uint32_t> >::iterator it =
+    std::lower_bound(lv1Index_.begin(), lv1Index_.end(), std::pair<uint32_t,uint32_t>(lv1,0));
+
+  if( it == lv1Index_.end() || it->first != lv1 ){ return NOTFOUND; }
+  return it->second;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::parseEvent                    */
+/* parses event i of the indexed buffer         */
+/*----------------------------------------------*/
+void DCCTBEventIndex::parseEvent(DCCTBDataParser & parser, DCCTBParseContext & context, uint32_t * buffer, uint32_t i){
+
+  const Entry & e = entries_.at(i);
+  parser.parseBuffer(context, buffer + e.offset/4, e.length*8, true);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::parseEvent                    */
+/* parses event i of the indexed file           */
+/*----------------------------------------------*/
+void DCCTBEventIndex::parseEvent(DCCTBDataParser & parser, DCCTBParseContext & context, DCCTBRawFileReader & reader, uint32_t i){
+
+  reader.seek( entries_.at(i).offset );
+
+  if( !reader.parseNextEvent(parser, context) ){
+    std::string errorMessage = std::string(" Error::Indexed event not found in file :") + reader.fileName();
+    throw ECALTBParserException(errorMessage);
+  }
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::save                          */
+/* writes the sidecar file: magic, version,     */
+/* entry size, number of events, raw file size  */
+/* and modification time, and the entries,      */
+/* ENTRYWORDS 32 bit words                      */
+/* each (field by field, no struct padding)     */
+/*----------------------------------------------*/
+void DCCTBEventIndex::save(std::string rawFileName){
+
+  uint64_t rawStatus[2] = { 0, 0 };            // size, modification time
+  FILE * sidecar = fileStatus(rawFileName, rawStatus[0], rawStatus[1]) ? fopen(sidecarName(rawFileName).c_str(), "wb") : 0;
+
+  bool written = sidecar != 0;
+  if( written ){
+    std::vector<uint32_t> words(entries_.size()*ENTRYWORDS);
+    for(uint32_t i=0; i<entries_.size(); i++){
+      const Entry & e = entries_[i];
+      uint32_t * w = &words[i*ENTRYWORDS];
+      w[0] = (uint32_t) e.offset;
+      w[1] = (uint32_t) (e.offset >> 32);
+      w[2] = e.length;
+      w[3] = e.lv1;
+      w[4] = e.bx | ( (uint32_t) e.errors << 16 );
+    }
+
+    uint32_t header[3] = { VERSION, ENTRYWORDS*4, (uint32_t) entries_.size() };
+    written = fwrite(sidecarMagic, sizeof(sidecarMagic), 1, sidecar) == 1
+      && fwrite(header, sizeof(header), 1, sidecar) == 1
+      && fwrite(rawStatus, sizeof(rawStatus), 1, sidecar) == 1
+      && ( words.empty() || fwrite(&words[0], sizeof(uint32_t), words.size(), sidecar) == words.size() );
+    written = ( fclose(sidecar) == 0 ) && written;
+  }
+
+  if( !written ){
+    std::string errorMessage = std::string(" Error::Unable to write index file :") + sidecarName(rawFileName);
+    throw ECALTBParserException(errorMessage);
+  }
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::load                          */
+/* reads the sidecar file if it matches the     */
+/* size and modification time of the raw file   */
+/* and holds the number of entries it announces */
+/*----------------------------------------------*/
+bool DCCTBEventIndex::load(std::string rawFileName){
+
+  uint64_t rawStatus[2], sidecarSize, sidecarTime;
+  if( !fileStatus(rawFileName, rawStatus[0], rawStatus[1]) || !fileStatus(sidecarName(rawFileName), sidecarSize, sidecarTime) ){ return false; }
+
+  FILE * sidecar = fopen(sidecarName(rawFileName).c_str(), "rb");
+  if( !sidecar ){ return false; }
+
+  char magic[sizeof(sidecarMagic)];
+  uint32_t header[3];
+  uint64_t indexedStatus[2];
+
+  bool loaded = fread(magic, sizeof(magic), 1, sidecar) == 1
+    && fread(header, sizeof(header), 1, sidecar) == 1
+    && fread(indexedStatus, sizeof(indexedStatus), 1, sidecar) == 1
+    && !memcmp(magic, sidecarMagic, sizeof(magic))
+    && header[0] == VERSION && header[1] == ENTRYWORDS*4
+    && indexedStatus[0] == rawStatus[0] && indexedStatus[1] == rawStatus[1]
+    && sidecarSize == sizeof(magic) + sizeof(header) + sizeof(indexedStatus) + (uint64_t) header[2]*ENTRYWORDS*4;
+
+  if( loaded ){
+    std::vector<uint32_t> words(header[2]*ENTRYWORDS);
+    loaded = words.empty() || fread(&words[0], sizeof(uint32_t), words.size(), sidecar) == words.size();
+    if( loaded ){
+      std::vector<Entry> entries(header[2]);
+      for(uint32_t i=0; i<entries.size(); i++){
+	const uint32_t * w = &words[i*ENTRYWORDS];
+	entries[i].offset = w[0] | ( (uint64_t) w[1] << 32 );
+	entries[i].length = w[2];
+	entries[i].lv1    = w[3];
+	entries[i].bx     = w[4] & 0xFFFF;
+	entries[i].errors = w[4] >> 16;
+      }
+      entries_.swap(entries);
+      lv1Index_.clear();
+    }
+  }
+
+  fclose(sidecar);
+  return loaded;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBEventIndex::open                          */
+/* sidecar index or new index of a file         */
+/*----------------------------------------------*/
+void DCCTBEventIndex::open(DCCTBDataParser & parser, DCCTBRawFileReader & reader){
+
+  if( load(reader.fileName()) ){ return; }
+
+  build(parser, reader);
+
+  try{ save(reader.fileName()); }
+  catch( ECALTBParserException & e ){}      //read only directory: the index is rebuilt next time
+}
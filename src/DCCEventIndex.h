@@ -0,0 +1,102 @@
+/*----------------------------------------------------------*/
+/* DCC EVENT INDEX                                          */
+/* position, length, LV1, BX and error mask of every event  */
+/* of a multi event buffer or raw data file, found in one   */
+/* pass over the event headers (checkEventLength) without   */
+/* building any block. One event can then be decoded on its */
+/* own from its offset. The index of a file can be saved to */
+/* and loaded from a sidecar file (raw file name + ".idx")  */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBEVENTINDEX_HH
+#define DCCTBEVENTINDEX_HH
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "DCCDataParser.h"
+
+class DCCTBParseContext;
+class DCCTBRawFileReader;
+
+
+class DCCTBEventIndex : public DCCTBDataParser::EventVisitor{
+
+public :
+
+  struct Entry{
+    uint64_t offset;              // bytes from the start of the buffer/file
+    uint32_t length;              // event length (64 bit words)
+    uint32_t lv1;
+    uint16_t bx;
+    uint16_t errors;              // error mask of checkEventLength (BOE, EVENT LENGTH, EOE)
+  };
+
+  DCCTBEventIndex();
+
+  /**
+     Indexes the events of buffer (bufferSize bytes), as parseBuffer would find them
+     (throws ECALTBParserException as parseBuffer does)
+  */
+  void build( DCCTBDataParser & parser, uint32_t * buffer, uint32_t bufferSize );
+
+  /**
+     Indexes the events of the file of reader, from its first event (with resync on, the
+     corrupted events are skipped and recorded in reader.skippedRanges())
+  */
+  void build( DCCTBDataParser & parser, DCCTBRawFileReader & reader );
+
+  /**
+     Number of events and index entries
+  */
+  uint32_t numbEvents()                 { return entries_.size(); }
+  const Entry & entry( uint32_t i )     { return entries_[i];     }
+
+  /**
+     Index of the first event with level 1 trigger number lv1 (NOTFOUND if none)
+  */
+  uint32_t findByLV1( uint32_t lv1 );
+
+  /**
+     Parses event i alone with parser.parseBuffer(context,...): from the indexed buffer,
+     or from the indexed file after moving reader to the event
+  */
+  void parseEvent( DCCTBDataParser & parser, DCCTBParseContext & context, uint32_t * buffer, uint32_t i );
+  void parseEvent( DCCTBDataParser & parser, DCCTBParseContext & context, DCCTBRawFileReader & reader, uint32_t i );
+
+  /**
+     Saves the index of rawFileName to its sidecar file (throws ECALTBParserException
+     if it can not be written) and loads it back: load returns false if the sidecar
+     does not exist, was not written for a file of the size and modification time
+     of rawFileName or is not as long as its number of entries requires
+  */
+  void save( std::string rawFileName );
+  bool load( std::string rawFileName );
+
+  /**
+     Loads the sidecar of rawFileName or, if it can not be used, indexes the file
+     and saves the sidecar (a sidecar that can not be written is not an error)
+  */
+  void open( DCCTBDataParser & parser, DCCTBRawFileReader & reader );
+
+  static std::string sidecarName( std::string rawFileName ) { return rawFileName + ".idx"; }
+
+  enum indexFields{
+    NOTFOUND   = 0xFFFFFFFF,
+    VERSION    = 2,
+    ENTRYWORDS = 5                // 32 bit words of an entry in the sidecar
+  };
+
+protected :
+
+  void addEvent( uint64_t offset, uint32_t * event, uint32_t eventSize, uint32_t errors, uint32_t length );
+
+  std::vector<Entry> entries_;
+
+  // (lv1, event index) sorted by lv1, built on the first findByLV1
+  std::vector< std::pair<uint32_t,uint32_t> > lv1Index_;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include "DCCEventSoA.h"
+#include "DCCDataParser.h"
+#include "DCCDataMapper.h"
+#include "DCCGainCheck.h"
+#include "DCCXtalDecoder.h"
+#include "ECALParserBlockException.h"
+
+
+// value of a data field in a block starting at block
+static inline uint32_t fieldValue(uint32_t * block, const DCCTBFieldPlan & plan){
+	return ( block[plan.word] >> plan.shift ) & plan.mask;
+}
+
+
+
+DCCTBEventSoA::DCCTBEventSoA() :
+parser_(0), headerTable_(0), buffer_(0), numbWords_(0), errors_(0), numbXtalSamples_(0),
+numbTCCBlocks_(0), numbTTs_(0), numbTowers_(0) { }
+
+
+
+/*-------------------------------------------------*/
+/* DCCTBEventSoA::decode                            */
+/* walks the event as DCCTBEventBlock does: DCC     */
+/* header, SRP block, TCC blocks, tower blocks and  */
+/* trailer, copying the data to the flat arrays     */
+/*-------------------------------------------------*/
+void DCCTBEventSoA::decode(DCCTBDataParser * parser, uint32_t * buffer, uint32_t numbBytes, uint32_t lengthErrors){
+
+	parser_          = parser;
+	buffer_          = buffer;
+	numbWords_       = numbBytes/4;
+	errors_          = lengthErrors & (BOE_ERROR|LENGTH_ERROR|EOE_ERROR);
+	numbXtalSamples_ = parser_->numbXtalSamples();
+	numbTTs_         = parser_->numbTTs();
+	numbTCCBlocks_   = 0;
+	numbTowers_      = 0;
+
+	if( samples_.size() < MAXTOWERS*MAXXTALS*numbXtalSamples_ ){ samples_.resize(MAXTOWERS*MAXXTALS*numbXtalSamples_); }
+	if( tps_.size() < MAXTCC*numbTTs_ ){ tps_.resize(MAXTCC*numbTTs_); }
+
+	DCCTBDataMapper * mapper = parser_->mapper();
+
+	if( numbBytes == DCCTBDataParser::EMPTYEVENTSIZE ){
+		headerTable_ = mapper->fieldTable( mapper->emptyEventFields() );
+		return;
+	}
+	headerTable_ = mapper->fieldTable( mapper->dccFields() );
+
+	if( numbWords_ < HEADER_WORDS ){ errors_ |= BLOCK_ERROR; return; }
+	if( headerField(DCCTBDataMapper::DCCERRORS_ID) == DCCERROR_EMPTYEVENT ){ return; }
+
+	uint32_t position = HEADER_WORDS;
+
+
+	// SRP block ////////////////////////////////////////////////////////////////////
+	uint32_t * srpBlock(0);
+	uint32_t sr_ch = headerField(DCCTBDataMapper::SR_CHSTATUS_ID);
+	if( sr_ch != CH_TIMEOUT && sr_ch != CH_DISABLED ){
+		uint32_t srpWords = parser_->srpBlockSize()/4;
+		if( position + srpWords > numbWords_ ){ errors_ |= BLOCK_ERROR; return; }
+		if( headerField(DCCTBDataMapper::SR_ID) ){ srpBlock = buffer_ + position; }
+		position += srpWords;
+	}
+
+	DCCTBDataFieldTable * srpTable(0);
+	     if( parser_->numbSRF() == 68){ srpTable = mapper->fieldTable( mapper->srp68Fields() ); }
+	else if( parser_->numbSRF() == 32){ srpTable = mapper->fieldTable( mapper->srp32Fields() ); }
+	else if( parser_->numbSRF() == 16){ srpTable = mapper->fieldTable( mapper->srp16Fields() ); }
+	/////////////////////////////////////////////////////////////////////////////////
+
+
+	// TCC blocks ///////////////////////////////////////////////////////////////////
+	DCCTBDataFieldTable * tccTable(0);
+	     if( numbTTs_ == 68){ tccTable = mapper->fieldTable( mapper->tcc68Fields() ); }
+	else if( numbTTs_ == 32){ tccTable = mapper->fieldTable( mapper->tcc32Fields() ); }
+	else if( numbTTs_ == 16){ tccTable = mapper->fieldTable( mapper->tcc16Fields() ); }
+
+	for(uint32_t i=1; i<=MAXTCC; i++){
+		uint32_t tcc_ch = headerField(mapper->tccChStatusId(i));
+		if( tcc_ch == CH_TIMEOUT || tcc_ch == CH_DISABLED ){ continue; }
+
+		uint32_t tccWords = parser_->tccBlockSize()/4;
+		if( position + tccWords > numbWords_ || !tccTable ){ errors_ |= BLOCK_ERROR; return; }
+
+		DCCTBTriggerPrimitive::decode( buffer_ + position, numbTTs_, &tps_[numbTCCBlocks_*numbTTs_] );
+		numbTCCBlocks_++;
+		position += tccWords;
+	}
+	/////////////////////////////////////////////////////////////////////////////////
+
+
+	// Tower blocks /////////////////////////////////////////////////////////////////
+	uint32_t triggerType = headerField(DCCTBDataMapper::TRIGGERTYPE_ID);
+	uint32_t numbChannels;
+	if( triggerType == PHYSICTRIGGER )          { numbChannels = 68; }
+	else if (triggerType == CALIBRATIONTRIGGER ){ numbChannels = 70; }
+	else{ errors_ |= TRIGGERTYPE_ERROR; return; }
+
+	bool zs = headerField(DCCTBDataMapper::ZS_ID);
+	uint32_t numbDWInXtalBlock = parser_->geometry().xtalBlockDWords();
+	uint32_t xtalWords         = parser_->geometry().xtalBlockWords();
+	bool suppress(false);
+
+	for(uint32_t i=1; i<=numbChannels; i++){
+
+		uint32_t chStatus = headerField(mapper->feChStatusId(i));
+
+		if( srpBlock ){
+			uint32_t slot = srpTable ? srpTable->slot(mapper->srId(i)) : (uint32_t) DCCTBDataFieldTable::NOSLOT;
+			if( slot == DCCTBDataFieldTable::NOSLOT ){ errors_ |= BLOCK_ERROR; return; }
+			suppress = ( fieldValue(srpBlock, srpTable->plan(slot)) == SR_NREAD );
+		}
+
+		if( chStatus == CH_TIMEOUT || chStatus == CH_DISABLED || suppress || chStatus == CH_SUPPRESS ){ continue; }
+
+		if( position + TOWERHEADER_WORDS > numbWords_ ){ errors_ |= BLOCK_ERROR; return; }
+
+		uint32_t * tower  = buffer_ + position;
+		uint32_t   t      = numbTowers_++;
+		uint32_t   length = ( tower[DCCTBDataMapper::TOWERLENGTH_WPOSITION] >> DCCTBDataMapper::TOWERLENGTH_BPOSITION ) & DCCTBDataMapper::TOWERLENGTH_MASK;
+		uint32_t   numbXtals = length > 0 ? (length-1)/numbDWInXtalBlock : 0;
+
+		towerIds_[t]    = ( tower[DCCTBDataMapper::TOWERID_WPOSITION] >> DCCTBDataMapper::TOWERID_BPOSITION ) & DCCTBDataMapper::TOWERID_MASK;
+		towerErrors_[t] = 0;
+		numbXtals_[t]   = 0;
+		if( towerIds_[t] != i ){ towerErrors_[t] |= TOWERID_ERROR; }
+		if( (!zs && numbXtals != MAXXTALS) || numbXtals > MAXXTALS ){ towerErrors_[t] |= TOWERLENGTH_ERROR; }
+		if( numbXtals > MAXXTALS ){ towerErrors_[t] |= TOOLONG_ERROR; numbXtals = MAXXTALS; }
+
+		uint32_t xtalPosition = position + TOWERHEADER_WORDS;
+		for(uint32_t c=0; c<numbXtals; c++){
+			if( xtalPosition + xtalWords > numbWords_ ){ checkGains(t); errors_ |= BLOCK_ERROR; return; }
+			if( !zs ){ decodeXtal(buffer_ + xtalPosition, t*MAXXTALS+c, c/5+1, c%5+1); }
+			else     { decodeXtal(buffer_ + xtalPosition, t*MAXXTALS+c, 0, 0);         }
+			numbXtals_[t]++;
+			xtalPosition += xtalWords;
+		}
+		checkGains(t);
+
+		if( length == 0 || position + length*2 > numbWords_ ){ errors_ |= BLOCK_ERROR; return; }
+		position += length*2;
+	}
+	/////////////////////////////////////////////////////////////////////////////////
+
+
+	// Trailer //////////////////////////////////////////////////////////////////////
+	if( position + TRAILER_WORDS > numbWords_ ){ errors_ |= BLOCK_ERROR; }
+	/////////////////////////////////////////////////////////////////////////////////
+}
+
+
+
+void DCCTBEventSoA::decodeXtal(uint32_t * xtal, uint32_t channel, uint32_t expectedStrip, uint32_t expectedXtal){
+
+	uint32_t strip = ( xtal[DCCTBDataMapper::STRIPID_WPOSITION] >> DCCTBDataMapper::STRIPID_BPOSITION ) & DCCTBDataMapper::STRIPID_MASK;
+	uint32_t xt    = ( xtal[DCCTBDataMapper::XTALID_WPOSITION]  >> DCCTBDataMapper::XTALID_BPOSITION  ) & DCCTBDataMapper::XTALID_MASK;
+
+	stripIds_[channel] = strip;
+	xtalIds_[channel]  = xt;
+
+	uint32_t errors(0);
+	if( expectedStrip && (strip != expectedStrip || xt != expectedXtal) ){ errors |= XTALID_ERROR; }
+
+	// ADC#1 shares the first word with the ids, then two samples per word
+	// (the gain bits are checked for the whole tower by checkGains)
+	DCCTBXtalDecoder<0>::decode( parser_->geometry(), xtal, &samples_[channel*numbXtalSamples_] );
+
+	xtalErrors_[channel]   = errors;
+	gainSwitches_[channel] = 0;
+}
+
+
+
+void DCCTBEventSoA::checkGains(uint32_t t){
+
+	uint8_t gainZero[MAXXTALS];
+	uint32_t first = t*MAXXTALS;
+
+	DCCTBGainCheck::checkXtals(&samples_[first*numbXtalSamples_], numbXtals_[t], numbXtalSamples_, gainZero, &gainSwitches_[first]);
+
+	for(uint32_t c=0; c<numbXtals_[t]; c++){
+		if( gainZero[c] )            { xtalErrors_[first+c] |= GAINZERO_ERROR;   }
+		if( gainSwitches_[first+c] ) { xtalErrors_[first+c] |= GAINSWITCH_ERROR; }
+	}
+}
+
+
+
+uint32_t DCCTBEventSoA::headerField(DCCTBFieldId id){
+
+	return fieldValue(buffer_, headerTable_->plan( headerTable_->slot(id) ));
+}
+
+
+
+uint32_t DCCTBEventSoA::getDataField(DCCTBFieldId id){
+
+	uint32_t slot = headerTable_ ? headerTable_->slot(id) : (uint32_t) DCCTBDataFieldTable::NOSLOT;
+	if( slot == DCCTBDataFieldTable::NOSLOT || headerTable_->plan(slot).word >= numbWords_ ){
+		throw ECALTBParserBlockException( std::string("\n field named : ")+parser_->mapper()->fieldName(id)+std::string(" was not found in block DCCHEADER") );
+	}
+
+	return fieldValue(buffer_, headerTable_->plan(slot));
+}
+
+
+
+bool DCCTBEventSoA::eventHasErrors(){
+
+	bool ret( errors_ != 0 );
+
+	for(uint32_t t=0; t<numbTowers_; t++){
+		ret |= (towerErrors_[t] != 0);
+		for(uint32_t c=0; c<numbXtals_[t]; c++){ ret |= ( (xtalErrors_[t*MAXXTALS+c] & XTALID_ERROR) != 0 ); }
+	}
+
+	return ret;
+}
+
+
+
+std::string DCCTBEventSoA::eventErrorString(){
+
+	std::string ret("");
+
+	if( eventHasErrors() ){
+
+		ret +="\n ======================================================================\n";
+		ret += std::string(" Event Erros occurred for L1A ( decoded value ) = ") ;
+		ret += parser_->getDecString( getDataField(DCCTBDataMapper::LV1_ID) );
+		ret += "\n ======================================================================";
+
+		if( errors_ & BOE_ERROR )         { ret += "\n DCC::BOE error"; }
+		if( errors_ & LENGTH_ERROR )      { ret += "\n DCC::EVENT LENGTH error"; }
+		if( errors_ & EOE_ERROR )         { ret += "\n DCC::EOE error"; }
+		if( errors_ & BLOCK_ERROR )       { ret += "\n Unable to get next block position (parser stoped!)"; }
+		if( errors_ & TRIGGERTYPE_ERROR ) {
+			ret += std::string("\n DCC::HEADER TRIGGER TYPE = ")+parser_->getDecString(headerField(DCCTBDataMapper::TRIGGERTYPE_ID))+std::string(" is not a valid type !");
+		}
+
+		for(uint32_t t=0; t<numbTowers_; t++){
+			if( towerErrors_[t] & TOWERID_ERROR ){
+				ret += "\n TOWERHEADER TT/SC ID = " + parser_->getDecString(towerIds_[t]) + " is not the expected one";
+			}
+			if( towerErrors_[t] & TOWERLENGTH_ERROR ){
+				ret += "\n TOWERHEADER ( ID = " + parser_->getDecString(towerIds_[t]) + " ) error in the Tower Length !";
+			}
+			if( towerErrors_[t] & TOOLONG_ERROR ){
+				ret += "\n TOWERHEADER ( ID = " + parser_->getDecString(towerIds_[t]) + " ) Tower Length is larger then expected, only "
+					+ parser_->getDecString(MAXXTALS) + " xtal blocks decoded !";
+			}
+			for(uint32_t c=0; c<numbXtals_[t]; c++){
+				if( xtalErrors_[t*MAXXTALS+c] & XTALID_ERROR ){
+					ret += "\n XTAL ( Tower ID = " + parser_->getDecString(towerIds_[t]) + " ) strip/xtal id "
+						+ parser_->getDecString(stripIds_[t*MAXXTALS+c]) + "/" + parser_->getDecString(xtalIds_[t*MAXXTALS+c])
+						+ " expected " + parser_->getDecString(c/5+1) + "/" + parser_->getDecString(c%5+1);
+				}
+			}
+		}
+	}
+
+	return ret;
+}
@@ -0,0 +1,160 @@
+/*----------------------------------------------------------*/
+/* DCC EVENT SOA                                            */
+/* flat (structure of arrays) copy of the data of one DCC   */
+/* event, decoded by DCCTBDataParser::decodeToSoA in one    */
+/* walk of the buffer without building the tower and xtal   */
+/* block objects.                                           */
+/* The crystal samples are stored as                        */
+/* [tower][strip][xtal][sample]: xtal block c of tower      */
+/* block t is channel t*MAXXTALS+c, its samples start at    */
+/* (t*MAXXTALS+c)*numbXtalSamples()                         */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBEVENTSOA_HH
+#define DCCTBEVENTSOA_HH
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "DCCBlockPrototype.h"
+#include "DCCTriggerPrimitive.h"
+
+class DCCTBDataParser;
+class DCCTBDataFieldTable;
+
+
+class DCCTBEventSoA{
+
+	public :
+
+		DCCTBEventSoA();
+
+		/**
+		   Decodes the event at buffer (numbBytes long), lengthErrors is the error mask
+		   returned by DCCTBDataParser::checkEventLength for this event.
+		   The buffer must stay valid while the header fields are read.
+		*/
+		void decode(DCCTBDataParser * parser, uint32_t * buffer, uint32_t numbBytes, uint32_t lengthErrors);
+
+		/**
+		   DCC header fields, read as the DCCTBEventBlock does
+		   (throws ECALTBParserBlockException if the field is not in the event)
+		*/
+		uint32_t getDataField(DCCTBFieldId id);
+
+		/**
+		   DCC header words, 0 if the event does not hold the complete header (empty or truncated event)
+		*/
+		uint32_t * headerWords()           { return numbWords_ >= HEADER_WORDS ? buffer_ : 0;     }
+
+		/**
+		   Error masks (see the enums below) and error summary
+		*/
+		uint32_t errors()                  { return errors_; }
+		bool eventHasErrors();
+		std::string eventErrorString();
+
+		/**
+		   Trigger primitives of the TCC blocks found in the event (tt from 0 to numbTTs()-1)
+		*/
+		uint32_t numbTCCBlocks()                      { return numbTCCBlocks_;                       }
+		uint32_t numbTTs()                            { return numbTTs_;                             }
+		uint32_t tpg(uint32_t tcc, uint32_t tt)       { return tps_[tcc*numbTTs_+tt].tpg();          }
+		uint32_t triggerFlag(uint32_t tcc, uint32_t tt){ return tps_[tcc*numbTTs_+tt].ttf();          }
+		const DCCTBTriggerPrimitive & triggerPrimitive(uint32_t tcc, uint32_t tt){ return tps_[tcc*numbTTs_+tt]; }
+		std::pair<int,bool> triggerSample(uint32_t tcc, uint32_t tt){
+			return std::pair<int,bool>( tpg(tcc,tt)&ETMASK, bool(tpg(tcc,tt)>>BPOSITION_FGVB) );
+		}
+
+		/**
+		   Tower blocks in readout order and their xtal blocks (c from 0 to numbXtals(t)-1)
+		*/
+		uint32_t numbTowers()                         { return numbTowers_;                          }
+		uint32_t towerID(uint32_t t)                  { return towerIds_[t];                         }
+		uint32_t towerErrors(uint32_t t)              { return towerErrors_[t];                      }
+		uint32_t numbXtals(uint32_t t)                { return numbXtals_[t];                        }
+		uint32_t numbXtalSamples()                    { return numbXtalSamples_;                     }
+		uint32_t stripID(uint32_t t, uint32_t c)      { return stripIds_[t*MAXXTALS+c];              }
+		uint32_t xtalID(uint32_t t, uint32_t c)       { return xtalIds_[t*MAXXTALS+c];               }
+		uint32_t xtalErrors(uint32_t t, uint32_t c)   { return xtalErrors_[t*MAXXTALS+c];            }
+		uint32_t numbGainSwitches(uint32_t t, uint32_t c){ return gainSwitches_[t*MAXXTALS+c];       }
+		const uint16_t * xtalDataSamples(uint32_t t, uint32_t c){ return &samples_[(t*MAXXTALS+c)*numbXtalSamples_]; }
+
+
+		enum eventErrors{
+			BOE_ERROR         = 0x1,      // same bits as checkEventLength
+			LENGTH_ERROR      = 0x2,
+			EOE_ERROR         = 0x4,
+			BLOCK_ERROR       = 0x8,      // a block is out of the event: decoding stopped
+			TRIGGERTYPE_ERROR = 0x10      // unknown trigger type: no tower decoded
+		};
+
+		enum towerErrors{
+			TOWERID_ERROR     = 0x1,      // tower id differs from the DCC channel
+			TOWERLENGTH_ERROR = 0x2,      // wrong number of xtal blocks
+			TOOLONG_ERROR     = 0x4       // more than MAXXTALS xtal blocks: only the first MAXXTALS decoded
+		};
+
+		enum xtalErrors{
+			XTALID_ERROR      = 0x1,      // strip/xtal id differs from the block position (no ZS)
+			GAINZERO_ERROR    = 0x2,      // a sample has gain bits 0
+			GAINSWITCH_ERROR  = 0x4       // forbidden gain decrease between two samples
+		};
+
+		enum soaSizes{
+			MAXTOWERS = 70,
+			MAXXTALS  = 25,
+			MAXTCC    = 4
+		};
+
+	protected :
+
+		uint32_t headerField(DCCTBFieldId id);
+		void decodeXtal(uint32_t * xtal, uint32_t channel, uint32_t expectedStrip, uint32_t expectedXtal);
+		void checkGains(uint32_t t);
+
+		enum dccFields{
+			CH_DISABLED          = 1,
+			CH_TIMEOUT           = 2,
+			CH_SUPPRESS          = 7,
+			SR_NREAD             = 0,
+
+			PHYSICTRIGGER        = 1,
+			CALIBRATIONTRIGGER   = 2,
+
+			DCCERROR_EMPTYEVENT  = 0x1,
+
+			HEADER_WORDS         = 18,
+			TOWERHEADER_WORDS    = 2,
+			TRAILER_WORDS        = 2,
+
+			ETMASK               = 0xFF,
+			BPOSITION_FGVB       = 8
+		};
+
+		DCCTBDataParser     * parser_;
+		DCCTBDataFieldTable * headerTable_;
+		uint32_t * buffer_;
+		uint32_t numbWords_;
+		uint32_t errors_;
+		uint32_t numbXtalSamples_;
+
+		uint32_t numbTCCBlocks_;
+		uint32_t numbTTs_;
+		std::vector<DCCTBTriggerPrimitive> tps_;
+
+		uint32_t numbTowers_;
+		uint32_t towerIds_[MAXTOWERS];
+		uint32_t towerErrors_[MAXTOWERS];
+		uint32_t numbXtals_[MAXTOWERS];
+
+		uint8_t  stripIds_[MAXTOWERS*MAXXTALS];
+		uint8_t  xtalIds_[MAXTOWERS*MAXXTALS];
+		uint8_t  xtalErrors_[MAXTOWERS*MAXXTALS];
+		uint8_t  gainSwitches_[MAXTOWERS*MAXXTALS];
+		std::vector<uint16_t> samples_;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef DCCTBGAINCHECK_HH
+#define DCCTBGAINCHECK_HH
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/*----------------------------------------------------------*/
+/* DCC GAIN CHECK                                           */
+/* validates the gain bits (bits 12-13) of the crystal      */
+/* samples in one pass: a crystal has a gain==0 error if    */
+/* any sample has both gain bits at 0, and one forbidden    */
+/* gain switch for every sample whose gain (sample >> 12)   */
+/* is lower than the gain of the previous sample.           */
+/* checkXtals runs over consecutive crystals (a tower or a  */
+/* supermodule of packed 16 bit samples) in one SSE2 pass   */
+/* when the compiler targets it, with scalar code otherwise */
+/* Note: this class is defined inline                       */
+/*----------------------------------------------------------*/
+class DCCTBGainCheck{
+public :
+
+  enum gainFields{
+    GAINMASK      = 0x3000,
+    GAINBPOSITION = 12
+  };
+
+  /**
+     Checks the numbSamples samples of one crystal (scalar, any sample type)
+  */
+  template <class SAMPLE>
+  static void checkXtal(const SAMPLE * samples, uint32_t numbSamples, bool & gainZero, uint32_t & gainSwitches){
+    gainZero     = false;
+    gainSwitches = 0;
+    for(uint32_t i=0; i<numbSamples; i++){
+      if( !(samples[i] & GAINMASK) ){ gainZero = true; }
+      if( i>0 && (samples[i-1] >> GAINBPOSITION) > (samples[i] >> GAINBPOSITION) ){ gainSwitches++; }
+    }
+  }
+
+  /**
+     Checks numbXtals crystals of numbSamples samples each, stored one after the other
+     from samples: gainZero[x] is set to 1 if crystal x has a gain==0 sample and
+     gainSwitches[x] to its number of forbidden gain switches
+  */
+  static void checkXtals(const uint16_t * samples, uint32_t numbXtals, uint32_t numbSamples,
+                         uint8_t * gainZero, uint8_t * gainSwitches){
+#ifdef __SSE2__
+    if( numbSamples > 0 && numbSamples <= MAXSSE2SAMPLES ){
+      checkXtalsSSE2(samples, numbXtals, numbSamples, gainZero, gainSwitches);
+      return;
+    }
+#endif
+    for(uint32_t x=0; x<numbXtals; x++, samples += numbSamples){
+      bool     zero;
+      uint32_t switches;
+      checkXtal(samples, numbSamples, zero, switches);
+      gainZero[x]     = zero;
+      gainSwitches[x] = switches;
+    }
+  }
+
+protected :
+
+#ifdef __SSE2__
+  enum sse2Sizes{
+    LANES          = 8,
+    MAXSSE2SAMPLES = 64 - LANES      // a crystal and one step must fit in the 64 bit queues
+  };
+
+  /**
+     Walks all the samples 8 at a time, ignoring the crystal boundaries: every step
+     compares the samples with the ones shifted by one and appends one gain==0 bit and
+     one gain switch bit per sample to two 64 bit queues, from which the crystals are
+     taken numbSamples bits at a time (the switch bit of the first sample of a crystal
+     compares it with the previous crystal and is dropped).
+     The last step is read from a zero padded copy so nothing is read after the samples
+  */
+  static void checkXtalsSSE2(const uint16_t * samples, uint32_t numbXtals, uint32_t numbSamples,
+                             uint8_t * gainZero, uint8_t * gainSwitches){
+    const __m128i gainMask = _mm_set1_epi16(GAINMASK);
+    const __m128i zero     = _mm_setzero_si128();
+    const uint64_t xtalMask = (1ULL << numbSamples) - 1;
+    uint32_t numbWords = numbXtals*numbSamples;
+    uint64_t zeroBits(0), switchBits(0);
+    uint32_t queued(0), x(0);
+
+    for(uint32_t i=0; i<numbWords; i+=LANES){
+      __m128i cur, prev;
+      uint32_t lanes = numbWords - i;
+
+      if( lanes >= LANES ){
+        lanes = LANES;
+        cur   = _mm_loadu_si128( (const __m128i *)(samples+i) );
+        prev  = i ? _mm_loadu_si128( (const __m128i *)(samples+i-1) ) : _mm_slli_si128(cur, 2);
+      }else{
+        uint16_t curPad[LANES]  = {0,0,0,0,0,0,0,0};
+        uint16_t prevPad[LANES] = {0,0,0,0,0,0,0,0};
+        for(uint32_t l=0; l<lanes; l++){
+          curPad[l]  = samples[i+l];
+          prevPad[l] = (i+l) ? samples[i+l-1] : 0;
+        }
+        cur  = _mm_loadu_si128( (const __m128i *)curPad );
+        prev = _mm_loadu_si128( (const __m128i *)prevPad );
+      }
+
+      __m128i isZero   = _mm_cmpeq_epi16( _mm_and_si128(cur, gainMask), zero );
+      __m128i isSwitch = _mm_cmpgt_epi16( _mm_srli_epi16(prev, GAINBPOSITION), _mm_srli_epi16(cur, GAINBPOSITION) );
+
+      // bits 0-7 : gain==0 flags, bits 8-15 : gain switch flags
+      uint32_t flags = _mm_movemask_epi8( _mm_packs_epi16(isZero, isSwitch) );
+      uint32_t valid = (1u << lanes) - 1;
+
+      zeroBits   |= uint64_t( flags       & valid ) << queued;
+      switchBits |= uint64_t( (flags>>8)  & valid ) << queued;
+      queued     += lanes;
+
+      while( queued >= numbSamples ){
+        gainZero[x]     = (zeroBits & xtalMask) ? 1 : 0;
+        gainSwitches[x] = __builtin_popcountll( switchBits & xtalMask & ~1ULL );
+        zeroBits   >>= numbSamples;
+        switchBits >>= numbSamples;
+        queued      -= numbSamples;
+        x++;
+      }
+    }
+  }
+#endif
+};
+
+#endif
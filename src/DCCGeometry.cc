@@ -0,0 +1,49 @@
+#include "DCCGeometry.h"
+#include "DCCDataMapper.h"
+
+
+
+/*----------------------------------------------*/
+/* DCCTBGeometry::DCCTBGeometry                   */
+/* class constructor                            */
+/*----------------------------------------------*/
+DCCTBGeometry::DCCTBGeometry() :
+  numbXtalSamples_(0), xtalBlockDWords_(0), tccBlockSize_(0), srpBlockSize_(0), tzsOffset_(0) {}
+
+
+/*----------------------------------------------*/
+/* DCCTBGeometry::compute                         */
+/* block sizes and sample positions             */
+/*----------------------------------------------*/
+void DCCTBGeometry::compute(const std::vector<uint32_t> & parameters){
+
+  numbXtalSamples_ = parameters[0];
+  uint32_t tSamples = parameters[1];                             //number of trigger time samples (default: 1)
+  uint32_t nTT      = parameters[2];                             //number of trigger towers (default: 68)
+  uint32_t nSr      = parameters[3];                             //number of SR flags (default: 68)
+
+  uint32_t tf(0), srf(0);
+
+  if( (nTT*tSamples)<4 || (nTT*tSamples)%4 ) tf=1;            //test is there is no TTC primitives or if it's a multiple of 4?
+  else tf=0;
+
+  if( nSr<16 || nSr%16 ) srf=1;                               //test if the SR flags do not fill whole 64 bit words (16 flags each)
+  else srf=0;
+
+  //TTC block size: header (8 bytes) + 17 words with 4 trigger primitives (17*8bytes)
+  tccBlockSize_ = 8 + ((nTT*tSamples)/4)*8 + tf*8 ;
+
+  //SR block size: header (8 bytes) + 4 words with 16 SR flags + 1 word with 4 SR flags (5*8bytes)
+  srpBlockSize_ = 8 + (nSr/16)*8 + srf*8;
+
+  //crystal block: ids and ADC#1 on the first 32 bit word, then 2 samples per word
+  xtalBlockDWords_ = numbXtalSamples_/4 + 1;
+  tzsOffset_       = numbXtalSamples_/2;
+
+  sampleWords_.resize(numbXtalSamples_);
+  sampleBits_.resize(numbXtalSamples_);
+  for(uint32_t i=1; i <= numbXtalSamples_; i++){
+    sampleWords_[i-1] = DCCTBDataMapper::ADC_WPOSITION + i/2;
+    sampleBits_[i-1]  = ( i==1 || i%2 ) ? DCCTBDataMapper::ADCBOFFSET : 0;
+  }
+}
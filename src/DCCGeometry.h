@@ -0,0 +1,67 @@
+/*----------------------------------------------------------*/
+/* DCC GEOMETRY                                             */
+/* sizes and word offsets of the DCC blocks that only      */
+/* depend on the parser parameters (number of samples, of  */
+/* TTs and of SR flags): computed once when the parameters */
+/* are set (see DCCTBDataParser::geometry) instead of for  */
+/* every tower or crystal                                   */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBGEOMETRY_HH
+#define DCCTBGEOMETRY_HH
+
+#include <vector>
+#include <stdint.h>
+
+
+class DCCTBGeometry{
+
+public :
+
+  DCCTBGeometry();
+
+  /**
+     Computes the geometry for a vector of parser parameters
+     (see DCCTBDataParser::DCCTBDataParser)
+  */
+  void compute( const std::vector<uint32_t> & parameters );
+
+  uint32_t numbXtalSamples()          { return numbXtalSamples_;   }
+
+  /**
+     Crystal block size: 64 bit words, 32 bit words and bytes
+  */
+  uint32_t xtalBlockDWords()          { return xtalBlockDWords_;   }
+  uint32_t xtalBlockWords()           { return xtalBlockDWords_*2; }
+  uint32_t xtalBlockSize()            { return xtalBlockDWords_*8; }
+
+  /**
+     TCC and SR block sizes (bytes)
+  */
+  uint32_t tccBlockSize()             { return tccBlockSize_;      }
+  uint32_t srpBlockSize()             { return srpBlockSize_;      }
+
+  /**
+     32 bit word and bit of ADC#i (i from 1 to numbXtalSamples) in the crystal block
+  */
+  uint32_t sampleWord( uint32_t i )   { return sampleWords_[i-1];  }
+  uint32_t sampleBit( uint32_t i )    { return sampleBits_[i-1];   }
+
+  /**
+     Offset of the 32 bit word with the TZS and gain decision bits
+  */
+  uint32_t tzsOffset()                { return tzsOffset_;         }
+
+protected :
+
+  uint32_t numbXtalSamples_;
+  uint32_t xtalBlockDWords_;
+  uint32_t tccBlockSize_;
+  uint32_t srpBlockSize_;
+  uint32_t tzsOffset_;
+
+  std::vector<uint32_t> sampleWords_;
+  std::vector<uint32_t> sampleBits_;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "DCCHeaderScan.h"
+#include "DCCDataParser.h"
+#include "DCCDataMapper.h"
+#include "DCCParseContext.h"
+#include "DCCRawFileReader.h"
+
+
+// word, bit position and mask of the header columns from DCCID
+static const uint32_t headerFields[DCCTBHeaderScan::NUMBCOLUMNS - DCCTBHeaderScan::DCCID][3] = {
+  { DCCTBDataMapper::DCCID_WPOSITION,        DCCTBDataMapper::DCCID_BPOSITION,        DCCTBDataMapper::DCCID_MASK        },
+  { DCCTBDataMapper::DCCBX_WPOSITION,        DCCTBDataMapper::DCCBX_BPOSITION,        DCCTBDataMapper::DCCBX_MASK        },
+  { DCCTBDataMapper::DCCL1_WPOSITION,        DCCTBDataMapper::DCCL1_BPOSITION,        DCCTBDataMapper::DCCL1_MASK        },
+  { DCCTBDataMapper::TRIGGERTYPE_WPOSITION,  DCCTBDataMapper::TRIGGERTYPE_BPOSITION,  DCCTBDataMapper::TRIGGERTYPE_MASK  },
+  { DCCTBDataMapper::DCCERRORS_WPOSITION,    DCCTBDataMapper::DCCERRORS_BPOSITION,    DCCTBDataMapper::DCCERRORS_MASK    },
+  { DCCTBDataMapper::RNUMB_WPOSITION,        DCCTBDataMapper::RNUMB_BPOSITION,        DCCTBDataMapper::RNUMB_MASK        },
+  { DCCTBDataMapper::RUNTYPE_WPOSITION,      DCCTBDataMapper::RUNTYPE_BPOSITION,      DCCTBDataMapper::RUNTYPE_MASK      },
+  { DCCTBDataMapper::ORBITCOUNTER_WPOSITION, DCCTBDataMapper::ORBITCOUNTER_BPOSITION, DCCTBDataMapper::ORBITCOUNTER_MASK }
+};
+
+
+
+/*----------------------------------------------*/
+/* DCCTBHeaderScan::DCCTBHeaderScan               */
+/* class constructor                            */
+/*----------------------------------------------*/
+DCCTBHeaderScan::DCCTBHeaderScan(){}
+
+
+/*----------------------------------------------*/
+/* DCCTBHeaderScan::clear                         */
+/* removes the events of the last scan          */
+/*----------------------------------------------*/
+void DCCTBHeaderScan::clear(){
+  offsets_.clear();
+  for(uint32_t c=0; c<NUMBCOLUMNS; c++){ columns_[c].clear(); }
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBHeaderScan::addEvent                      */
+/* stores the header fields of one event        */
+/*----------------------------------------------*/
+void DCCTBHeaderScan::addEvent(uint64_t offset, uint32_t * event, uint32_t eventSize, uint32_t errors, uint32_t length){
+
+  offsets_.push_back(offset);
+  columns_[LENGTH].push_back(length);
+  columns_[ERRORS].push_back(errors);
+
+  //the words are read once, a header cut short gives 0 for the missing fields
+  uint32_t words[HEADERWORDS] = {0};
+  for(uint32_t w=0; w<HEADERWORDS && 4*w<eventSize; w++){ words[w] = event[w]; }
+
+  for(uint32_t c=DCCID; c<NUMBCOLUMNS; c++){
+    const uint32_t * field = headerFields[c-DCCID];
+    columns_[c].push_back( (words[field[0]] >> field[1]) & field[2] );
+  }
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBHeaderScan::build                         */
+/* scans the events of a buffer: same walk      */
+/* as DCCTBDataParser::parseBuffer              */
+/*----------------------------------------------*/
+void DCCTBHeaderScan::build(DCCTBDataParser & parser, uint32_t * buffer, uint32_t bufferSize){
+
+  clear();
+
+  DCCTBParseContext context;                //error counters of the scan
+  parser.walkEvents(context, buffer, bufferSize, *this);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBHeaderScan::build                         */
+/* scans the events of a file                   */
+/*----------------------------------------------*/
+void DCCTBHeaderScan::build(DCCTBDataParser & parser, DCCTBRawFileReader & reader){
+
+  clear();
+
+  DCCTBParseContext context;
+  parser.walkEvents(context, reader, *this);
+}
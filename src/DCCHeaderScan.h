@@ -0,0 +1,80 @@
+/*----------------------------------------------------------*/
+/* DCC HEADER SCAN                                          */
+/* run bookkeeping fields of every event of a multi event   */
+/* buffer or raw data file (DCC id, BX, LV1, trigger type,  */
+/* DCC errors, run number, run type and orbit counter),    */
+/* read from the first 7 words of each event in one pass   */
+/* over the event headers (checkEventLength) without       */
+/* building any block, and stored column by column: one    */
+/* vector per field, indexed by event                       */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBHEADERSCAN_HH
+#define DCCTBHEADERSCAN_HH
+
+#include <vector>
+#include <stdint.h>
+
+#include "DCCDataParser.h"
+
+class DCCTBRawFileReader;
+
+
+class DCCTBHeaderScan : public DCCTBDataParser::EventVisitor{
+
+public :
+
+  enum headerColumns{
+    LENGTH = 0,                   // event length (64 bit words)
+    ERRORS,                       // error mask of checkEventLength (BOE, EVENT LENGTH, EOE)
+    DCCID,
+    BX,
+    LV1,
+    TRIGGERTYPE,
+    DCCERRORS,
+    RUNNUMBER,
+    RUNTYPE,
+    ORBITCOUNTER,
+    NUMBCOLUMNS
+  };
+
+  enum headerScanFields{
+    HEADERWORDS = 7               // words read in each event
+  };
+
+  DCCTBHeaderScan();
+
+  /**
+     Scans the events of buffer (bufferSize bytes), as parseBuffer would find them
+     (throws ECALTBParserException as parseBuffer does)
+  */
+  void build( DCCTBDataParser & parser, uint32_t * buffer, uint32_t bufferSize );
+
+  /**
+     Scans the events of the file of reader, from its first event (with resync on, the
+     corrupted events are skipped and recorded in reader.skippedRanges())
+  */
+  void build( DCCTBDataParser & parser, DCCTBRawFileReader & reader );
+
+  /**
+     Number of events, column c (one value per event) and value of column c for event i
+  */
+  uint32_t numbEvents()                                  { return offsets_.size();  }
+  const std::vector<uint32_t> & column( headerColumns c ) { return columns_[c];     }
+  uint32_t value( headerColumns c, uint32_t i )          { return columns_[c][i];   }
+
+  /**
+     Offsets of the events (bytes from the start of the buffer/file)
+  */
+  const std::vector<uint64_t> & offsets()                { return offsets_;         }
+
+protected :
+
+  void clear();
+  void addEvent( uint64_t offset, uint32_t * event, uint32_t eventSize, uint32_t errors, uint32_t length );
+
+  std::vector<uint64_t> offsets_;
+  std::vector<uint32_t> columns_[NUMBCOLUMNS];
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "DCCParseContext.h"
+
+
+
+/*----------------------------------------------*/
+/* DCCTBParseContext::DCCTBParseContext           */
+/* class constructor                            */
+/*----------------------------------------------*/
+DCCTBParseContext::DCCTBParseContext() :
+  buffer_(0), bufferSize_(0), processedEvent_(0) {
+
+  resetErrorCounters();
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBParseContext::reset                       */
+/* prepares the context for a new buffer        */
+/*----------------------------------------------*/
+void DCCTBParseContext::reset(uint32_t * buffer, uint32_t bufferSize){
+
+  resetErrorCounters();
+
+  buffer_         = buffer;
+  bufferSize_     = bufferSize;
+  processedEvent_ = 0;
+
+  //clear stored data (blocks are given back to the pools)
+  events_.clear();
+  skippedRanges_.clear();
+  dccEvents_.clear();
+  soaEvents_.clear();
+
+  eventBlockPool_.releaseAll();    eventBlockPool_.resetAllocations();
+  towerBlockPool_.releaseAll();    towerBlockPool_.resetAllocations();
+  xtalBlockPool_.releaseAll();     xtalBlockPool_.resetAllocations();
+  tccBlockPool_.releaseAll();      tccBlockPool_.resetAllocations();
+  srpBlockPool_.releaseAll();      srpBlockPool_.resetAllocations();
+  trailerBlockPool_.releaseAll();  trailerBlockPool_.resetAllocations();
+  soaEventPool_.releaseAll();      soaEventPool_.resetAllocations();
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBParseContext::resetErrorCounters          */
+/* resets error counters                        */
+/*----------------------------------------------*/
+void DCCTBParseContext::resetErrorCounters(){
+  //set error counters to 0 (DCC::BOE, DCC::EOE, DCC::EVENT LENGTH and DCC::RESYNC are counted here)
+  errors_.reset();
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBParseContext::addSkippedRange             */
+/* bytes skipped by a resynchronization         */
+/*----------------------------------------------*/
+void DCCTBParseContext::addSkippedRange(uint32_t offset, uint32_t size){
+
+  skippedRanges_.push_back( std::pair<uint32_t,uint32_t>(offset,size) );
+  errors_.add(DCCTBErrorCounters::DCC_RESYNC);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBParseContext::addEvent                    */
+/* event pointer with its error mask            */
+/*----------------------------------------------*/
+void DCCTBParseContext::addEvent(uint32_t errorMask, uint32_t * event, uint32_t eventLength){
+
+  std::pair<uint32_t *, uint32_t> eventPointer(event,eventLength);
+  events_.push_back( std::pair<uint32_t, std::pair<uint32_t*, uint32_t> >(errorMask,eventPointer) );
+  processedEvent_++;
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBParseContext::blockAllocations               */
+/* blocks allocated during the last parse call     */
+/*-------------------------------------------------*/
+uint32_t DCCTBParseContext::blockAllocations(){
+  return eventBlockPool_.allocations() + towerBlockPool_.allocations() + xtalBlockPool_.allocations()
+    + tccBlockPool_.allocations() + srpBlockPool_.allocations() + trailerBlockPool_.allocations()
+    + soaEventPool_.allocations();
+}
+
+
+/*-------------------------------------------------*/
+/* DCCTBParseContext::~DCCTBParseContext               */
+/* destructor                                      */
+/*-------------------------------------------------*/
+DCCTBParseContext::~DCCTBParseContext(){
+
+  // events are deleted with the block pools
+  dccEvents_.clear();
+  soaEvents_.clear();
+}
@@ -0,0 +1,118 @@
+/*----------------------------------------------------------*/
+/* DCC PARSE CONTEXT                                        */
+/* state of one parse call of DCCTBDataParser: the buffer,  */
+/* the events found in it, the error counters and the      */
+/* block pools. The parser itself only keeps what does not */
+/* change from event to event (parameters, block sizes and */
+/* data mapper), so one parser can be shared by several    */
+/* threads as long as each of them parses with its own     */
+/* context                                                  */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBPARSECONTEXT_HH
+#define DCCTBPARSECONTEXT_HH
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <stdint.h>
+
+#include "DCCBlockPool.h"
+#include "DCCErrorCounters.h"
+#include "DCCEventBlock.h"
+#include "DCCTowerBlock.h"
+#include "DCCXtalBlock.h"
+#include "DCCTCCBlock.h"
+#include "DCCSRPBlock.h"
+#include "DCCTrailerBlock.h"
+#include "DCCEventSoA.h"
+
+
+class DCCTBParseContext{
+
+public :
+
+  DCCTBParseContext();
+
+  /**
+     Class destructor (the blocks are deleted with the pools)
+  */
+  ~DCCTBParseContext();
+
+  /**
+     Starts a new parse call on buffer: clears the events, resets the error counters
+     and gives all the blocks back to the pools
+  */
+  void reset(uint32_t * buffer, uint32_t bufferSize);
+
+  /**
+     Get methods for the parsed data (valid until the next parse call with this context)
+  */
+  uint32_t * getBuffer()                          { return buffer_;        }
+  uint32_t   bufferSize()                         { return bufferSize_;    }
+  uint32_t   processedEvents()                    { return processedEvent_; }
+  std::vector<DCCTBEventBlock *> & dccEvents()    { return dccEvents_;     }
+  std::vector<DCCTBEventSoA *>   & soaEvents()    { return soaEvents_;     }
+
+  // std::pair< errorMask, std::pair< pointer to event, event size (number of DW)> >
+  std::vector< std::pair< uint32_t, std::pair<uint32_t *, uint32_t> > > & events() { return events_; }
+
+  /**
+     Byte ranges of the buffer (offset from the buffer start, size) skipped to resynchronize
+     on the next valid event (parser with resync on)
+  */
+  std::vector< std::pair<uint32_t,uint32_t> > & skippedRanges() { return skippedRanges_; }
+  void addSkippedRange(uint32_t offset, uint32_t size);
+
+  /**
+     Get method for the error counters of the buffer (DCC event checks) and reset of the counters
+  */
+  DCCTBErrorCounters & errorCounters()             { return errors_;        }
+  void resetErrorCounters();
+
+  /**
+     Get methods for the block pools
+  */
+  DCCTBBlockPool<DCCTBEventBlock>   & eventBlockPool()   { return eventBlockPool_;   }
+  DCCTBBlockPool<DCCTBTowerBlock>   & towerBlockPool()   { return towerBlockPool_;   }
+  DCCTBBlockPool<DCCTBXtalBlock>    & xtalBlockPool()    { return xtalBlockPool_;    }
+  DCCTBBlockPool<DCCTBTCCBlock>     & tccBlockPool()     { return tccBlockPool_;     }
+  DCCTBBlockPool<DCCTBSRPBlock>     & srpBlockPool()     { return srpBlockPool_;     }
+  DCCTBBlockPool<DCCTBTrailerBlock> & trailerBlockPool() { return trailerBlockPool_; }
+  DCCTBBlockPool<DCCTBEventSoA>     & soaEventPool()     { return soaEventPool_;     }
+
+  /**
+     Number of block objects allocated during the last parse call
+  */
+  uint32_t blockAllocations();
+
+  /**
+     Records an event found in the buffer (called by the parser)
+  */
+  void addEvent(uint32_t errorMask, uint32_t * event, uint32_t eventLength);
+
+protected :
+
+  uint32_t *buffer_;                //data buffer
+  uint32_t bufferSize_;             //buffer size
+  uint32_t processedEvent_;
+
+  std::vector<DCCTBEventBlock *> dccEvents_;
+  std::vector<DCCTBEventSoA *>   soaEvents_;
+  std::vector< std::pair< uint32_t, std::pair<uint32_t *, uint32_t> > > events_;
+
+  std::vector< std::pair<uint32_t,uint32_t> > skippedRanges_;
+
+  DCCTBErrorCounters errors_;       //error counters of the buffer
+
+  DCCTBBlockPool<DCCTBEventBlock>   eventBlockPool_;
+  DCCTBBlockPool<DCCTBTowerBlock>   towerBlockPool_;
+  DCCTBBlockPool<DCCTBXtalBlock>    xtalBlockPool_;
+  DCCTBBlockPool<DCCTBTCCBlock>     tccBlockPool_;
+  DCCTBBlockPool<DCCTBSRPBlock>     srpBlockPool_;
+  DCCTBBlockPool<DCCTBTrailerBlock> trailerBlockPool_;
+  DCCTBBlockPool<DCCTBEventSoA>     soaEventPool_;
+};
+
+#endif
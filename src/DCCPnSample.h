@@ -0,0 +1,53 @@
+#ifndef DCCTBPNSAMPLE_HH
+#define DCCTBPNSAMPLE_HH
+
+#include <stdint.h>
+
+
+/*----------------------------------------------------------*/
+/* DCC PN SAMPLE                                            */
+/* PN diode samples from the raw samples of a mem box      */
+/* channel: on the odd strips (1, 3 from 0) the 14 bits    */
+/* come in reversed order, and bit 11 is flipped by the    */
+/* AD9052 on every strip. The bit order is restored with a */
+/* fixed swap network (5 shift and mask steps) instead of  */
+/* one step per bit                                         */
+/* Note: this class is defined inline                       */
+/*----------------------------------------------------------*/
+class DCCTBPnSample{
+public :
+
+  enum pnFields{
+    SAMPLEMASK    = 0x3FFF,           // 12 bit ADC and 2 gain bits
+    AD9052FLIP    = 0x800,
+    GAINMASK      = 0x3000,
+    GAINBPOSITION = 12
+  };
+
+  /**
+     14 bits of raw in reversed order
+  */
+  static uint32_t reverse( uint32_t raw ){
+    uint32_t x = raw & SAMPLEMASK;
+    x = ( (x >> 1) & 0x5555 ) | ( (x & 0x5555) << 1 );
+    x = ( (x >> 2) & 0x3333 ) | ( (x & 0x3333) << 2 );
+    x = ( (x >> 4) & 0x0F0F ) | ( (x & 0x0F0F) << 4 );
+    x = ( (x >> 8) | (x << 8) ) & 0xFFFF;
+    return x >> 2;                    // 16 bit reversal: the 14 bits are in the high part
+  }
+
+  /**
+     PN sample (with its gain bits) from a raw mem sample, reversed for the odd strips
+  */
+  static int decode( int raw, bool reversed ){
+    uint32_t x = reversed ? reverse(raw) : (uint32_t) raw;
+    return ( x ^ AD9052FLIP ) & SAMPLEMASK;
+  }
+
+  /**
+     Gain bits of a PN sample: 0 for gain 1, 1 for gain 16, 2 and 3 are errors
+  */
+  static int gain( int sample ){ return ( sample & GAINMASK ) >> GAINBPOSITION; }
+};
+
+#endif
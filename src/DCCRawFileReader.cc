@@ -0,0 +1,473 @@
+#include "DCCRawFileReader.h"
+#include "DCCDataParser.h"
+#include "DCCParseContext.h"
+#include "ECALParserException.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+static std::string decString(uint64_t data){
+  char buffer[24];
+  sprintf(buffer,"%llu",(unsigned long long)data);
+  return std::string(buffer);
+}
+
+static inline int hexValue(unsigned char c){
+  if( c >= '0' && c <= '9' ){ return c - '0'; }
+  c |= 0x20;                                   //lower case
+  if( c >= 'a' && c <= 'f' ){ return c - 'a' + 10; }
+  return -1;
+}
+
+static inline bool isBlank(unsigned char c){
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::DCCTBRawFileReader         */
+/* class constructor: opens the file            */
+/*----------------------------------------------*/
+DCCTBRawFileReader::DCCTBRawFileReader(std::string fileName, fileFormat format) :
+  fileName_(fileName), format_(format), fd_(-1), fileSize_(0), offset_(0), chunkOffset_(0),
+  map_(0), mapOffset_(0), mapSize_(0), firstWord_(0), endOfFile_(false),
+  inToken_(false), skipToken_(false), tokenChars_(0), tokenDigits_(0), tokenValue_(0), tokenOffset_(0),
+  event_(0), eventSize_(0), eventOffset_(0), numbEvents_(0){
+
+  fd_ = open(fileName_.c_str(), O_RDONLY);
+
+  struct stat fileStat;
+  if( fd_ < 0 || fstat(fd_,&fileStat) ){
+    if( fd_ >= 0 ){ close(fd_); }
+    std::string errorMessage = std::string(" Error::Unable to open file :") + fileName_;
+    throw ECALTBParserException(errorMessage);
+  }
+
+  fileSize_ = fileStat.st_size;
+  pageSize_ = sysconf(_SC_PAGESIZE);
+
+  if( format_ == AUTO ){ format_ = guessFormat(); }
+  if( format_ == HEXTEXT ){ chunk_.resize(CHUNKSIZE); }
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::guessFormat                */
+/* text if the first bytes are only hexadecimal */
+/* digits, blanks and 0x prefixes               */
+/*----------------------------------------------*/
+DCCTBRawFileReader::fileFormat DCCTBRawFileReader::guessFormat(){
+
+  unsigned char firstBytes[64];
+  ssize_t numbBytes = pread(fd_, firstBytes, sizeof(firstBytes), 0);
+
+  for(ssize_t i=0; i<numbBytes; i++){
+    unsigned char c = firstBytes[i];
+    if( hexValue(c) < 0 && !isBlank(c) && c != 'x' && c != 'X' ){ return BINARY; }
+  }
+  return numbBytes > 0 ? HEXTEXT : BINARY;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::nextEvent                  */
+/* reads the next event of the file             */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::nextEvent(){
+
+  bool found = format_ == BINARY ? nextBinaryEvent(0) : nextTextEvent(0);
+  if( found ){ numbEvents_++; }
+  else{ event_ = 0; eventSize_ = 0; }
+
+  return found;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::nextEvent                  */
+/* reads the next event of the file, skipping   */
+/* corrupted event lengths if parser resyncs    */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::nextEvent(DCCTBDataParser & parser, DCCTBParseContext & context){
+
+  size_t numbRanges = skippedRanges_.size();
+
+  bool found = format_ == BINARY ? nextBinaryEvent(&parser) : nextTextEvent(&parser);
+  if( found ){ numbEvents_++; }
+  else{ event_ = 0; eventSize_ = 0; }
+
+  if( skippedRanges_.size() > numbRanges ){ context.errorCounters().add(DCCTBErrorCounters::DCC_RESYNC); }
+
+  return found;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::parseNextEvent             */
+/* reads and parses the next event              */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::parseNextEvent(DCCTBDataParser & parser, DCCTBParseContext & context){
+
+  size_t numbRanges = skippedRanges_.size();
+
+  if( !nextEvent(parser, context) ){ return false; }
+
+  parser.parseBuffer(context, event_, eventSize_, true);
+
+  //parseBuffer resets the context: the resynchronization before the event is counted again
+  if( skippedRanges_.size() > numbRanges ){ context.errorCounters().add(DCCTBErrorCounters::DCC_RESYNC); }
+  return true;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::nextBinaryEvent            */
+/* maps the next event of a binary file: the    */
+/* window is moved forward when the event does  */
+/* not fit in it, so the pages of the events    */
+/* already read are given back                  */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::nextBinaryEvent(DCCTBDataParser * parser){
+
+  uint64_t bytesToEnd = fileSize_ - offset_;
+  if( bytesToEnd < EMPTYEVENTSIZE ){ return false; }
+
+  //event length is in the 3rd 32 bit word (64 bit words)
+  mapWindow(offset_, EMPTYEVENTSIZE);
+  uint32_t * header = (uint32_t *)(map_ + (offset_ - mapOffset_));
+  uint32_t eventLength = header[2] & EVENTLENGTHMASK;
+
+  if( eventLength < EMPTYEVENTSIZE/8 || uint64_t(eventLength)*8 > bytesToEnd ){
+    if( !parser || !parser->resync() ){ throwLengthError(eventLength, bytesToEnd); }
+    if( !resyncBinaryEvent(*parser) ){ return false; }
+
+    //the scan window holds the whole event found
+    header = (uint32_t *)(map_ + (offset_ - mapOffset_));
+    eventLength = header[2] & EVENTLENGTHMASK;
+  }
+
+  mapWindow(offset_, uint64_t(eventLength)*8);
+
+  event_       = (uint32_t *)(map_ + (offset_ - mapOffset_));
+  eventSize_   = eventLength*8;
+  eventOffset_ = offset_;
+  offset_     += eventSize_;
+
+  return true;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::resyncBinaryEvent          */
+/* scans the file from the current event up to  */
+/* the next valid one, RESYNCSIZE bytes at a    */
+/* time: consecutive scans overlap by the       */
+/* largest event so none is missed              */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::resyncBinaryEvent(DCCTBDataParser & parser){
+
+  DCCTBParseContext context;                //the skipped range is recorded below, in file bytes
+  uint64_t start = offset_;
+  bool found = false;
+
+  for(;;){
+    uint64_t bytesToEnd = fileSize_ - offset_;
+    uint32_t scanSize = bytesToEnd < RESYNCSIZE ? bytesToEnd - bytesToEnd%8 : RESYNCSIZE;
+
+    uint32_t skippedBytes = scanSize;
+    if( scanSize >= EMPTYEVENTSIZE ){
+      mapWindow(offset_, scanSize);
+      skippedBytes = parser.resyncEvent(context, (uint32_t *)(map_ + (offset_ - mapOffset_)), 0, scanSize);
+    }
+
+    if( skippedBytes == 0 && scanSize >= EMPTYEVENTSIZE ){ offset_ += 8; continue; }  //first word checked by the previous scan
+    if( skippedBytes < scanSize ){ offset_ += skippedBytes; found = true; break; }
+    if( bytesToEnd <= RESYNCSIZE ){ offset_ = fileSize_; break; }                     //no valid event left
+    offset_ += RESYNCSIZE - MAXEVENTSIZE;
+  }
+
+  skippedRanges_.push_back( std::pair<uint64_t,uint64_t>(start, offset_ - start) );
+  return found;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::mapWindow                  */
+/* makes [offset,offset+size) of the file       */
+/* readable at map_                             */
+/*----------------------------------------------*/
+void DCCTBRawFileReader::mapWindow(uint64_t offset, uint64_t size){
+
+  if( map_ && offset >= mapOffset_ && offset + size <= mapOffset_ + mapSize_ ){ return; }
+
+  unmapWindow();
+
+  mapOffset_ = offset - offset%pageSize_;
+  mapSize_   = offset + size - mapOffset_;
+  if( mapSize_ < WINDOWSIZE ){ mapSize_ = WINDOWSIZE; }
+  if( mapOffset_ + mapSize_ > fileSize_ ){ mapSize_ = fileSize_ - mapOffset_; }
+
+  //private writable mapping: the blocks never change the data, but a write would not reach the file
+  void * address = mmap(0, mapSize_, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd_, mapOffset_);
+  if( address == MAP_FAILED ){
+    map_ = 0;
+    std::string errorMessage = std::string(" Error::Unable to map file :") + fileName_
+      + " at byte " + decString(mapOffset_);
+    throw ECALTBParserException(errorMessage);
+  }
+
+  map_ = (char *)address;
+  madvise(map_, mapSize_, MADV_SEQUENTIAL);
+}
+
+
+void DCCTBRawFileReader::unmapWindow(){
+  if( map_ ){ munmap(map_, mapSize_); }
+  map_ = 0; mapOffset_ = 0; mapSize_ = 0;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::nextTextEvent              */
+/* decodes text until the next event is         */
+/* complete in words_                           */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::nextTextEvent(DCCTBDataParser * parser){
+
+  //drop the words of the previous event
+  dropWords(firstWord_);
+  firstWord_ = 0;
+
+  while( words_.size() < EMPTYEVENTSIZE/4 && decodeChunk() ){}
+  if( words_.size() < EMPTYEVENTSIZE/4 ){ return false; }
+
+  uint32_t eventLength = words_[2] & EVENTLENGTHMASK;
+  if( eventLength >= EMPTYEVENTSIZE/8 ){
+    while( words_.size() < eventLength*2 && decodeChunk() ){}
+  }
+
+  if( eventLength < EMPTYEVENTSIZE/8 || words_.size() < eventLength*2 ){
+    if( !parser || !parser->resync() ){ throwLengthError(eventLength, uint64_t(words_.size())*4); }
+    if( !resyncTextEvent(*parser) ){ return false; }
+
+    //the scan holds the whole event found
+    eventLength = words_[2] & EVENTLENGTHMASK;
+  }
+
+  event_       = &words_[0];
+  eventSize_   = eventLength*8;
+  eventOffset_ = wordOffsets_[0];
+  firstWord_   = eventLength*2;
+
+  return true;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::resyncTextEvent            */
+/* as resyncBinaryEvent, on the decoded words   */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::resyncTextEvent(DCCTBDataParser & parser){
+
+  DCCTBParseContext context;                //the skipped range is recorded below, in bytes of text
+  uint64_t start = wordOffsets_[0];
+  bool found = false;
+
+  for(;;){
+    while( uint64_t(words_.size())*4 < RESYNCSIZE && decodeChunk() ){}
+
+    uint64_t numbBytes = uint64_t(words_.size())*4;
+    uint32_t scanSize = numbBytes < RESYNCSIZE ? numbBytes - numbBytes%8 : RESYNCSIZE;
+
+    uint32_t skippedBytes = scanSize;
+    if( scanSize >= EMPTYEVENTSIZE ){ skippedBytes = parser.resyncEvent(context, &words_[0], 0, scanSize); }
+
+    if( skippedBytes == 0 && scanSize >= EMPTYEVENTSIZE ){ dropWords(2); continue; }  //first word checked by the previous scan
+    if( skippedBytes < scanSize ){ dropWords(skippedBytes/4); found = true; break; }
+    if( endOfFile_ && numbBytes <= RESYNCSIZE ){ dropWords(words_.size()); break; }   //no valid event left
+    dropWords((RESYNCSIZE - MAXEVENTSIZE)/4);
+  }
+
+  uint64_t end = found ? wordOffsets_[0] : fileSize_;
+  skippedRanges_.push_back( std::pair<uint64_t,uint64_t>(start, end - start) );
+  return found;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::dropWords                  */
+/* drops the first decoded words                */
+/*----------------------------------------------*/
+void DCCTBRawFileReader::dropWords(uint32_t numbWords){
+  words_.erase(words_.begin(), words_.begin() + numbWords);
+  wordOffsets_.erase(wordOffsets_.begin(), wordOffsets_.begin() + numbWords);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::decodeChunk                */
+/* decodes the next CHUNKSIZE bytes of text,    */
+/* tokens can continue in the next chunk        */
+/* returns false at the end of the file         */
+/*----------------------------------------------*/
+bool DCCTBRawFileReader::decodeChunk(){
+
+  if( endOfFile_ ){ return false; }
+
+  ssize_t numbBytes = read(fd_, &chunk_[0], chunk_.size());
+  if( numbBytes < 0 ){
+    std::string errorMessage = std::string(" Error::Unable to read file :") + fileName_;
+    throw ECALTBParserException(errorMessage);
+  }
+  if( numbBytes == 0 ){
+    endOfFile_ = true;
+    if( inToken_ ){ endToken(); }
+    return true;
+  }
+
+  const unsigned char * begin = (const unsigned char *)&chunk_[0];
+  const unsigned char * end   = begin + numbBytes;
+
+  for( const unsigned char * c = begin; c != end; c++ ){
+
+    if( isBlank(*c) ){
+      if( inToken_ ){ endToken(); }
+      continue;
+    }
+
+    if( !inToken_ ){
+      inToken_ = true; skipToken_ = false;
+      tokenChars_ = 0; tokenDigits_ = 0; tokenValue_ = 0;
+      tokenOffset_ = chunkOffset_ + (c - begin);
+    }
+    tokenChars_++;
+    if( skipToken_ ){ continue; }
+
+    int digit = hexValue(*c);
+    if( digit >= 0 ){
+      tokenValue_ = (tokenValue_<<4) | digit;
+      tokenDigits_++;
+    }
+    else if( (*c == 'x' || *c == 'X') && tokenChars_ == 2 && tokenValue_ == 0 ){
+      tokenDigits_ = 0;                         //0x prefix
+    }
+    else{
+      skipToken_ = true;                        //as %x: the word ends at the first non hexadecimal character
+    }
+  }
+
+  chunkOffset_ += numbBytes;
+  return true;
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::endToken                   */
+/* stores the word of the token just decoded    */
+/*----------------------------------------------*/
+void DCCTBRawFileReader::endToken(){
+
+  inToken_ = false;
+
+  if( !tokenDigits_ ){
+    std::string errorMessage = std::string(" Error::Not an hexadecimal word in file :") + fileName_
+      + " at byte " + decString(tokenOffset_);
+    throw ECALTBParserException(errorMessage);
+  }
+
+  words_.push_back(tokenValue_);
+  wordOffsets_.push_back(tokenOffset_);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::readAll                    */
+/* reads the remaining words of the file        */
+/*----------------------------------------------*/
+void DCCTBRawFileReader::readAll(std::vector<uint32_t> & words){
+
+  if( format_ == BINARY ){
+    words.resize( (fileSize_ - offset_)/4 );
+
+    char * data = words.empty() ? 0 : (char *)&words[0];
+    uint64_t toRead = uint64_t(words.size())*4;
+    while( toRead ){
+      ssize_t numbBytes = pread(fd_, data, toRead, offset_);
+      if( numbBytes <= 0 ){
+        std::string errorMessage = std::string(" Error::Unable to read file :") + fileName_;
+        throw ECALTBParserException(errorMessage);
+      }
+      data += numbBytes; offset_ += numbBytes; toRead -= numbBytes;
+    }
+    return;
+  }
+
+  words_.erase(words_.begin(), words_.begin() + firstWord_);
+  firstWord_ = 0;
+
+  wordOffsets_.clear();
+  while( decodeChunk() ){ wordOffsets_.clear(); }
+  words.swap(words_);
+  words_.clear();
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::seek                       */
+/* next event is read from byte offset          */
+/*----------------------------------------------*/
+void DCCTBRawFileReader::seek(uint64_t offset){
+
+  offset_ = offset;
+
+  if( format_ == HEXTEXT ){
+    if( lseek(fd_, offset, SEEK_SET) < 0 ){
+      std::string errorMessage = std::string(" Error::Unable to seek in file :") + fileName_
+        + " to byte " + decString(offset);
+      throw ECALTBParserException(errorMessage);
+    }
+    chunkOffset_ = offset;
+    words_.clear(); wordOffsets_.clear();
+    firstWord_ = 0;
+    endOfFile_ = false;
+    inToken_   = false;
+  }
+
+  event_ = 0; eventSize_ = 0;
+  skippedRanges_.clear();
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::throwLengthError           */
+/* the event length does not fit in the file    */
+/*----------------------------------------------*/
+void DCCTBRawFileReader::throwLengthError(uint32_t eventLength, uint64_t bytesToEnd){
+
+  std::string fatalError;
+
+  fatalError +="\n ======================================================================";
+  fatalError +="\n Fatal error at event = " + decString(numbEvents_+1) + " of file " + fileName_;
+  fatalError +="\n Decoded event length = " + decString(eventLength);
+  fatalError +="\n bytes to file end    = " + decString(bytesToEnd);
+  fatalError +="\n Unable to procead the data decoding ...";
+  fatalError +="\n ======================================================================";
+
+  throw ECALTBParserException(fatalError);
+}
+
+
+/*----------------------------------------------*/
+/* DCCTBRawFileReader::~DCCTBRawFileReader        */
+/* destructor                                   */
+/*----------------------------------------------*/
+DCCTBRawFileReader::~DCCTBRawFileReader(){
+  unmapWindow();
+  if( fd_ >= 0 ){ close(fd_); }
+}
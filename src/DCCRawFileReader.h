@@ -0,0 +1,162 @@
+/*----------------------------------------------------------*/
+/* DCC RAW FILE READER                                      */
+/* reads DCC events from a raw data file one at a time:     */
+/* binary DAQ dumps are memory mapped through a window that */
+/* follows the events, hexadecimal text dumps (one 32 bit   */
+/* word per token, as read by DCCTBDataParser::parseFile)   */
+/* are decoded chunk by chunk. Only the current event is    */
+/* kept, so files of any size are scanned in bounded memory */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBRAWFILEREADER_HH
+#define DCCTBRAWFILEREADER_HH
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+#include <sys/types.h>
+
+class DCCTBDataParser;
+class DCCTBParseContext;
+
+
+class DCCTBRawFileReader{
+
+public :
+
+  enum fileFormat{
+    AUTO    = 0,                 // guessed from the first bytes of the file
+    BINARY  = 1,                 // 32 bit words as written by the DAQ
+    HEXTEXT = 2                  // hexadecimal words separated by blanks (0x prefix allowed)
+  };
+
+  /**
+     Opens fileName (throws ECALTBParserException if it can not be opened)
+  */
+  DCCTBRawFileReader( std::string fileName, fileFormat format = AUTO );
+
+  /**
+     Class destructor (unmaps and closes the file)
+  */
+  ~DCCTBRawFileReader();
+
+  /**
+     Reads the next event: returns false at the end of the file (less than an empty
+     event left) and throws ECALTBParserException if the event length written in the
+     header does not fit in the file
+  */
+  bool nextEvent();
+
+  /**
+     As nextEvent, but with parser.resync() on an event length that does not fit is no
+     longer fatal: the file is scanned from the bad event (parser.resyncEvent) up to the
+     next valid event, the skipped bytes are recorded in skippedRanges() and counted in
+     the context (DCC::RESYNC). Returns false if no valid event is left
+  */
+  bool nextEvent( DCCTBDataParser & parser, DCCTBParseContext & context );
+
+  /**
+     Reads the next event (nextEvent(parser,context)) and parses it with
+     parser.parseBuffer(context,...) as a single event buffer: returns false at the
+     end of the file
+  */
+  bool parseNextEvent( DCCTBDataParser & parser, DCCTBParseContext & context );
+
+  /**
+     Current event (valid until the next call to nextEvent), its size in bytes and its
+     position in the file (byte of its first word, also for text files)
+  */
+  uint32_t * event()                    { return event_;       }
+  uint32_t   eventSize()                { return eventSize_;   }
+  uint64_t   eventOffset()              { return eventOffset_; }
+
+  /**
+     Moves to the event at byte offset of the file (an eventOffset() of a previous read)
+  */
+  void seek( uint64_t offset );
+
+  /**
+     Byte ranges of the file (offset, size) skipped to resynchronize on the next valid
+     event since the last seek (text files: bytes of text)
+  */
+  std::vector< std::pair<uint64_t,uint64_t> > & skippedRanges() { return skippedRanges_; }
+
+  /**
+     Number of events read, file format and file name
+  */
+  uint32_t    numbEvents()              { return numbEvents_; }
+  fileFormat  format()                  { return format_;     }
+  std::string fileName()                { return fileName_;   }
+
+  /**
+     Reads all the words of the file from the current position, without looking
+     at the events (used by DCCTBDataParser::parseFile)
+  */
+  void readAll( std::vector<uint32_t> & words );
+
+  enum readerSizes{
+    WINDOWSIZE  = 64*1024*1024,  // bytes mapped at a time (more if an event is larger)
+    CHUNKSIZE   = 1024*1024,     // bytes of text decoded at a time
+    EMPTYEVENTSIZE = 32,         // bytes
+    EVENTLENGTHMASK = 0xFFFFFF,
+    MAXEVENTSIZE = EVENTLENGTHMASK*8,  // bytes
+    RESYNCSIZE  = 256*1024*1024  // bytes scanned at a time to resynchronize (more than MAXEVENTSIZE)
+  };
+
+protected :
+
+  fileFormat guessFormat();
+
+  bool nextBinaryEvent( DCCTBDataParser * parser );
+  bool nextTextEvent( DCCTBDataParser * parser );
+
+  bool resyncBinaryEvent( DCCTBDataParser & parser );
+  bool resyncTextEvent( DCCTBDataParser & parser );
+
+  void mapWindow( uint64_t offset, uint64_t size );
+  void unmapWindow();
+
+  bool decodeChunk();
+  void dropWords( uint32_t numbWords );
+  void endToken();
+  void throwLengthError( uint32_t eventLength, uint64_t bytesToEnd );
+
+  std::string fileName_;
+  fileFormat  format_;
+  int         fd_;
+  uint64_t    fileSize_;
+  uint64_t    offset_;            // file position of the next event (binary)
+  uint64_t    chunkOffset_;       // file position of the next chunk (text)
+
+  char     * map_;                // mapped window [mapOffset_,mapOffset_+mapSize_)
+  uint64_t   mapOffset_;
+  uint64_t   mapSize_;
+  uint64_t   pageSize_;
+
+  std::vector<char>     chunk_;   // text read from the file
+  std::vector<uint32_t> words_;   // decoded words not yet given as events
+  std::vector<uint64_t> wordOffsets_; // and the file position of each of them
+  uint32_t   firstWord_;          // first word of the next event in words_
+  bool       endOfFile_;
+  bool       inToken_;            // hexadecimal token being decoded
+  bool       skipToken_;
+  uint32_t   tokenChars_;
+  uint32_t   tokenDigits_;
+  uint32_t   tokenValue_;
+  uint64_t   tokenOffset_;
+
+  uint32_t * event_;
+  uint32_t   eventSize_;
+  uint64_t   eventOffset_;
+  uint32_t   numbEvents_;
+
+  std::vector< std::pair<uint64_t,uint64_t> > skippedRanges_;
+
+private :
+
+  DCCTBRawFileReader( const DCCTBRawFileReader & );
+  DCCTBRawFileReader & operator=( const DCCTBRawFileReader & );
+};
+
+#endif
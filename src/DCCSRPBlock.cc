@@ -10,51 +10,57 @@ DCCTBSRPBlock::DCCTBSRPBlock(
 	uint32_t numbBytes,
 	uint32_t wordsToEnd,
 	uint32_t wordEventOffset
-) : DCCTBBlockPrototype(parser,"SRP", buffer, numbBytes,wordsToEnd,wordEventOffset), dccBlock_(dccBlock){
+) : DCCTBBlockPrototype(){
 	
-	//Reset error counters ///////
-	errors_["SRP::HEADER"]  = 0;
-	errors_["SRP::BLOCKID"] = 0;
-	//////////////////////////////
+	initialize(dccBlock, parser, buffer, numbBytes, wordsToEnd, wordEventOffset);
+}
+
+
+
+DCCTBSRPBlock::DCCTBSRPBlock() : DCCTBBlockPrototype(), dccBlock_(0) { }
+
+
+
+bool DCCTBSRPBlock::initialize(
+	DCCTBEventBlock * dccBlock,
+	DCCTBDataParser * parser, 
+	uint32_t * buffer, 
+	uint32_t numbBytes,
+	uint32_t wordsToEnd,
+	uint32_t wordEventOffset
+){
+	
+	DCCTBBlockPrototype::initialize(parser,"SRP", buffer, numbBytes,wordsToEnd,wordEventOffset);
+	dccBlock_ = dccBlock;
 	
 	// Get data fields from the mapper and retrieve data /////////////////////////////////////
 	     if( parser_->numbSRF() == 68){ mapperFields_ = parser_->mapper()->srp68Fields();}
 	else if( parser_->numbSRF() == 32){ mapperFields_ = parser_->mapper()->srp32Fields();}	
 	else if( parser_->numbSRF() == 16){ mapperFields_ = parser_->mapper()->srp16Fields();}
-	parseData();
+	if( !parseData() ){ return false; }
 	//////////////////////////////////////////////////////////////////////////////////////////
 	
 	// check internal data ////////////
 	if(parser_->debug()){ dataCheck();}
 	///////////////////////////////////
-
+	
+	return true;
 }
 
 
 
 void DCCTBSRPBlock::dataCheck(){ 
 	
-	std::string checkErrors("");
-
-	std::pair <bool,std::string> res;
+	uint32_t firstError = blockErrors_.size();
 	
-	res = checkDataField("BX", BXMASK & (dccBlock_->getDataField("BX")));
-	if(!res.first){ checkErrors += res.second; (errors_["SRP::HEADER"])++; }
-	res = checkDataField("LV1", L1MASK & (dccBlock_->getDataField("LV1"))); 
-	if(!res.first){ checkErrors += res.second; (errors_["SRP::HEADER"])++; }
+	if( !checkField(DCCTBDataMapper::BX_ID, BXMASK & (dccBlock_->getDataField(DCCTBDataMapper::BX_ID))) ){ countError(DCCTBErrorCounters::SRP_HEADER); }
+	if( !checkField(DCCTBDataMapper::LV1_ID, L1MASK & (dccBlock_->getDataField(DCCTBDataMapper::LV1_ID))) ){ countError(DCCTBErrorCounters::SRP_HEADER); }
 	
 	 
-	res = checkDataField("SRP ID",parser_->srpId()); 
-	if(!res.first){ checkErrors += res.second; (errors_["SRP::HEADER"])++; } 
+	if( !checkField(DCCTBDataMapper::SRPID_ID,parser_->srpId()) ){ countError(DCCTBErrorCounters::SRP_HEADER); } 
 	
 	
-	if(checkErrors!=""){
-		errorString_ +="\n ======================================================================\n"; 		
-		errorString_ += std::string(" ") + name_ + std::string(" data fields checks errors : ") ;
-		errorString_ += checkErrors ;
-		errorString_ += "\n ======================================================================";
-		blockError_ = true;	
-	}
+	endChecks(firstError);
 	
 	
 }
@@ -66,7 +72,7 @@ void  DCCTBSRPBlock::increment(uint32_t numb){
 		for(uint32_t counter=0; counter<numb; counter++, dataP_++,wordCounter_++){
 			uint32_t blockID = (*dataP_)>>BPOSITION_BLOCKID;
 			if( blockID != BLOCKID ){
-				(errors_["SRP::BLOCKID"])++;
+				countError(DCCTBErrorCounters::SRP_BLOCKID);
 				//errorString_ += std::string("\n") + parser_->index(nunb)+(" blockId has value ") + parser_->getDecString(blockID);
 				//errorString  += std::string(", while ")+parser_->getDecString(BLOCKID)+std::string(" is expected");
 			}
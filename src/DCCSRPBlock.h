@@ -30,6 +30,18 @@ class DCCTBSRPBlock : public DCCTBBlockPrototype {
 			uint32_t wordsToEnd, 
 			uint32_t wordEventOffset
 		);
+		
+		DCCTBSRPBlock();
+		
+		// returns false if the block is out of scope (error recorded)
+		bool initialize(
+			DCCTBEventBlock * dccBlock,
+			DCCTBDataParser * parser, 
+			uint32_t * buffer, 
+			uint32_t numbBytes,
+			uint32_t wordsToEnd, 
+			uint32_t wordEventOffset
+		);
 	
 		
 		
@@ -18,22 +18,43 @@ DCCTBTCCBlock::DCCTBTCCBlock(
 	uint32_t wordsToEnd,
 	uint32_t wordEventOffset,
 	uint32_t expectedId) : 
-  DCCTBBlockPrototype(parser,"TCC", buffer, numbBytes, wordsToEnd, wordEventOffset),dccBlock_(dccBlock), expectedId_(expectedId){
+  DCCTBBlockPrototype(){
+
+  initialize(dccBlock, parser, buffer, numbBytes, wordsToEnd, wordEventOffset, expectedId);
+}
+
+DCCTBTCCBlock::DCCTBTCCBlock() : DCCTBBlockPrototype(), dccBlock_(0), expectedId_(0) { }
+
+/*-------------------------------------------------*/
+/* DCCTBTCCBlock::initialize                         */
+/* sets the block on a new buffer                  */
+/*-------------------------------------------------*/
+bool DCCTBTCCBlock::initialize(
+	DCCTBEventBlock * dccBlock,
+	DCCTBDataParser * parser, 
+	uint32_t * buffer, 
+	uint32_t numbBytes,  
+	uint32_t wordsToEnd,
+	uint32_t wordEventOffset,
+	uint32_t expectedId){
+
+  DCCTBBlockPrototype::initialize(parser,"TCC", buffer, numbBytes, wordsToEnd, wordEventOffset);
+  dccBlock_   = dccBlock;
+  expectedId_ = expectedId;
 
-  //Reset error counters
-  errors_["TCC::HEADER"]  = 0;
-  errors_["TCC::BLOCKID"] = 0;
-	
   //Get data fields from the mapper and retrieve data 
   if(      parser_->numbTTs() == 68){ mapperFields_ = parser_->mapper()->tcc68Fields();}
   else if( parser_->numbTTs() == 32){ mapperFields_ = parser_->mapper()->tcc32Fields();}	
   else if( parser_->numbTTs() == 16){ mapperFields_ = parser_->mapper()->tcc16Fields();}
   
-  parseData();
+  if( !parseData() )
+    return false;
   
   // check internal data 
   if(parser_->debug())
     dataCheck();
+  
+  return true;
 }
  
 /*---------------------------------------------------*/
@@ -41,38 +62,25 @@ DCCTBTCCBlock::DCCTBTCCBlock(
 /* check data with data fields                       */
 /*---------------------------------------------------*/
 void DCCTBTCCBlock::dataCheck(){
-  std::pair <bool,std::string> res;            //check result
-  std::string checkErrors("");            //error string
+  uint32_t firstError = blockErrors_.size(); //field errors are recorded from here
 
   //check BX(LOCAL) field (1st word bit 16)
-  res = checkDataField("BX", BXMASK & (dccBlock_->getDataField("BX")));
-  if(!res.first){ 
-    checkErrors += res.second; 
-    (errors_["TCC::HEADER"])++; 
+  if( !checkField(DCCTBDataMapper::BX_ID, BXMASK & (dccBlock_->getDataField(DCCTBDataMapper::BX_ID))) ){ 
+    countError(DCCTBErrorCounters::TCC_HEADER); 
   }
   
   //check LV1(LOCAL) field (1st word bit 32)
-  res = checkDataField("LV1", L1MASK & (dccBlock_->getDataField("LV1"))); 
-  if(!res.first){ 
-    checkErrors += res.second; 
-    (errors_["TCC::HEADER"])++; 
+  if( !checkField(DCCTBDataMapper::LV1_ID, L1MASK & (dccBlock_->getDataField(DCCTBDataMapper::LV1_ID))) ){ 
+    countError(DCCTBErrorCounters::TCC_HEADER); 
   }
   
   //check TCC ID field (1st word bit 0)
-  res = checkDataField("TCC ID",expectedId_); 
-  if(!res.first){ 
-    checkErrors += res.second; 
-    (errors_["TCC::HEADER"])++; 
+  if( !checkField(DCCTBDataMapper::TCCID_ID,expectedId_) ){ 
+    countError(DCCTBErrorCounters::TCC_HEADER); 
   } 
   
   
-  if(checkErrors!=""){
-  	 blockError_=true;
-    errorString_ +="\n ======================================================================\n"; 
-	 errorString_ += std::string(" ") + name_ + std::string("( ID = ")+parser_->getDecString((uint32_t)(expectedId_))+std::string(" ) errors : ") ;
-	 errorString_ += checkErrors ;
-	 errorString_ += "\n ======================================================================";
-  }
+  endChecks(firstError, DCCTBBlockError::IDCHECKS, expectedId_);
   
   
 }
@@ -93,7 +101,7 @@ void  DCCTBTCCBlock::increment(uint32_t numb){
     for(uint32_t counter=0; counter<numb; counter++, dataP_++, wordCounter_++){
       uint32_t blockID = (*dataP_) >> BPOSITION_BLOCKID;
       if( blockID != BLOCKID ){
-	(errors_["TCC::BLOCKID"])++;
+	countError(DCCTBErrorCounters::TCC_BLOCKID);
 	//errorString_ += std::string("\n") + parser_->index(nunb)+(" blockId has value ") + parser_->getDecString(blockID);
 	//errorString  += std::string(", while ")+parser_->getDecString(BLOCKID)+std::string(" is expected");
       }
@@ -106,10 +114,11 @@ void  DCCTBTCCBlock::increment(uint32_t numb){
 
 std::vector< std::pair<int,bool> > DCCTBTCCBlock::triggerSamples() {
   std::vector< std::pair<int,bool> > data;
+  DCCTBDataMapper * mapper = parser_->mapper();
 
+  data.reserve( parser_->numbTTs() );
   for(unsigned int i=1;i <= parser_->numbTTs();i++){
-    std::string name = std::string("TPG#") + parser_->getDecString(i);
-    int tpgValue = getDataField( name ) ;
+    int tpgValue = getDataField( mapper->tpgId(i) ) ;
                  std::pair<int,bool> tpg( tpgValue&ETMASK, bool(tpgValue>>BPOSITION_FGVB));
     data.push_back (tpg);
      
@@ -123,11 +132,11 @@ std::vector< std::pair<int,bool> > DCCTBTCCBlock::triggerSamples() {
 
 std::vector<int> DCCTBTCCBlock::triggerFlags() {
   std::vector<int> data;
+  DCCTBDataMapper * mapper = parser_->mapper();
 
+  data.reserve( parser_->numbTTs() );
   for(unsigned int i=1; i<= parser_->numbTTs();i++){
-    std::string name = std::string("TTF#") + parser_->getDecString(i);
-    
-    data.push_back ( getDataField( name )  );
+    data.push_back ( getDataField( mapper->ttfId(i) )  );
      
   }
 
@@ -136,4 +145,20 @@ std::vector<int> DCCTBTCCBlock::triggerFlags() {
 
 
 
+uint32_t DCCTBTCCBlock::triggerPrimitives(DCCTBTriggerPrimitive * tps) {
+
+  uint32_t numbTTs = parser_->numbTTs();
 
+  // lazy mode: the block is in scope, the primitives are unpacked from the buffer
+  if( lazy_ ){
+    DCCTBTriggerPrimitive::decode(beginOfBuffer_, numbTTs, tps);
+    return numbTTs;
+  }
+
+  DCCTBDataMapper * mapper = parser_->mapper();
+  for(uint32_t i=1; i<=numbTTs; i++){
+    tps[i-1].data = getDataField( mapper->tpgId(i) ) | ( getDataField( mapper->ttfId(i) ) << DCCTBTriggerPrimitive::BPOSITION_TTF );
+  }
+
+  return numbTTs;
+}
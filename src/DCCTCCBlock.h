@@ -16,6 +16,7 @@
 #include "DCCDataParser.h"
 #include "DCCDataMapper.h"
 #include "DCCEventBlock.h"
+#include "DCCTriggerPrimitive.h"
 
 class DCCTBEventBlock;
 class DCCTBDataParser;
@@ -35,11 +36,33 @@ public :
 	      uint32_t wordEventOffset,
 	      uint32_t expectedId );     
   
+  /**
+     Empty block, set up with initialize (used by the block pools)
+  */
+  DCCTBTCCBlock();
+  
+  /**
+     Sets the block on a new buffer: returns false if it is out of scope (error recorded)
+  */
+  bool initialize(DCCTBEventBlock * dccBlock,
+	      DCCTBDataParser * parser, 
+	      uint32_t * buffer, 
+	      uint32_t numbBytes, 
+	      uint32_t wordsToEnd,
+	      uint32_t wordEventOffset,
+	      uint32_t expectedId );     
+  
   
 
   std::vector< std::pair<int, bool> > triggerSamples();
   
   std::vector<int> triggerFlags();
+
+  /**
+     Copies the numbTTs primitives {Et, FGVB, TTF} of the block to tps in one pass
+     (no allocation), returns the number of primitives
+  */
+  uint32_t triggerPrimitives(DCCTBTriggerPrimitive * tps);
   
 protected :
   /**
@@ -3,6 +3,7 @@
 #include "DCCDataParser.h"
 #include "DCCXtalBlock.h"
 #include "DCCDataMapper.h"
+#include "DCCParseContext.h"
 #include "ECALParserBlockException.h"
 #include <stdio.h>
 
@@ -17,37 +18,53 @@ DCCTBTowerBlock::DCCTBTowerBlock(
 	uint32_t wordEventOffset,
 	uint32_t expectedTowerID
 )
-: DCCTBBlockPrototype(parser,"TOWERHEADER", buffer, numbBytes,wordsToEnd, wordEventOffset ) 
- , dccBlock_(dccBlock), expectedTowerID_(expectedTowerID)
+: DCCTBBlockPrototype() 
 {
-	
-	//Reset error counters ///////////
-	errors_["FE::HEADER"]        = 0;
-	errors_["FE::TT/SC ID"]      = 0; 
-	errors_["FE::BLOCK LENGTH"]  = 0;
-	//////////////////////////////////
+	initialize(dccBlock, parser, buffer, numbBytes, wordsToEnd, wordEventOffset, expectedTowerID);
+}
+
+
 
+DCCTBTowerBlock::DCCTBTowerBlock() : DCCTBBlockPrototype(), dccBlock_(0), expectedTowerID_(0) { }
+
+
+
+bool DCCTBTowerBlock::initialize(
+ 	DCCTBEventBlock * dccBlock, 
+	DCCTBDataParser * parser, 
+	uint32_t * buffer, 
+	uint32_t numbBytes,
+	uint32_t wordsToEnd,
+	uint32_t wordEventOffset,
+	uint32_t expectedTowerID
+){
+	DCCTBBlockPrototype::initialize(parser,"TOWERHEADER", buffer, numbBytes,wordsToEnd, wordEventOffset );
+	dccBlock_        = dccBlock;
+	expectedTowerID_ = expectedTowerID;
+	xtalBlocks_.clear();
+	
 	
 	
 	// Get data fields from the mapper and retrieve data /////////////////////////////////////
 	mapperFields_ = parser_->mapper()->towerFields();	
-	parseData();
+	return parseData();
 	//////////////////////////////////////////////////////////////////////////////////////////
  }
  
  
- void DCCTBTowerBlock::parseXtalData(){
+ bool DCCTBTowerBlock::parseXtalData(){
 	
 	uint32_t numbBytes = blockSize_;
 	uint32_t wordsToEnd =wordsToEndOfEvent_;
 	
 	// See if we can construct the correct number of XTAL Blocks////////////////////////////////////////////////////////////////////////////////
-	uint32_t numbDWInXtalBlock = ( parser_->numbXtalSamples() )/4 + 1;
-	uint32_t length            = getDataField("BLOCK LENGTH");
+	DCCTBGeometry & geometry   = parser_->geometry();
+	uint32_t numbDWInXtalBlock = geometry.xtalBlockDWords();
+	uint32_t length            = getDataField(DCCTBDataMapper::TOWERLENGTH_ID);
 	uint32_t numbOfXtalBlocks  = 0 ;
 	
 	if( length > 0 ){ numbOfXtalBlocks = (length-1)/numbDWInXtalBlock; }
-	uint32_t xtalBlockSize     =  numbDWInXtalBlock*8;
+	uint32_t xtalBlockSize     =  geometry.xtalBlockSize();
 	//uint32_t pIncrease         =  numbDWInXtalBlock*2;
 	
 	//std::cout<<"\n DEBUG::numbDWInXtal Block "<<dec<<numbDWInXtalBlock<<std::endl;
@@ -57,28 +74,16 @@ DCCTBTowerBlock::DCCTBTowerBlock(
 
 	
 	
-	bool zs = dccBlock_->getDataField("ZS");
+	bool zs = dccBlock_->getDataField(DCCTBDataMapper::ZS_ID);
 	if( !zs && numbOfXtalBlocks != 25 ){
 	
 	   
-		(errors_["FE::BLOCK LENGTH"])++;
-		errorString_ += "\n ======================================================================\n"; 		
-		errorString_ += std::string(" ") + name_ + std::string(" ZS is not active, error in the Tower Length !") ;
-		errorString_ += "\n Tower Length is : " + (parser_->getDecString(numbBytes/8))+std::string(" , while it should be : ");
-		std::string myString = parser_->getDecString((uint32_t)(25*numbDWInXtalBlock+1));
-		errorString_ += "\n It was only possible to build : " + parser_->getDecString( numbOfXtalBlocks)+ std::string(" XTAL blocks");
-		errorString_ += "\n ======================================================================";
-		blockError_ = true;
+		countError(DCCTBErrorCounters::FE_BLOCKLENGTH);
+		addError(DCCTBBlockError::TOWERLENGTH, this, DCCTBDataMapper::TOWERLENGTH_ID, wordEventOffset_, numbOfXtalBlocks, numbBytes/8);
 	};
 	if( numbOfXtalBlocks > 25 ){
-		if (errors_["FE::BLOCK LENGTH"]==0)(errors_["FE::BLOCK LENGTH"])++;
-		errorString_ += "\n ======================================================================\n"; 		
-		errorString_ += std::string(" ") + name_ + std::string(" Tower Length is larger then expected...!") ;
-		errorString_ += "\n Tower Length is : " + parser_->getDecString(numbBytes/8)+std::string(" , while it should be at maximum : ");
-		std::string myString = parser_->getDecString((uint32_t)(25*numbDWInXtalBlock+1));
-		errorString_ += "\n Action -> data after the xtal 25 is ignored... "; 
-		errorString_ += "\n ======================================================================";
-		blockError_ = true;
+		if (errors_[DCCTBErrorCounters::FE_BLOCKLENGTH]==0) countError(DCCTBErrorCounters::FE_BLOCKLENGTH);
+		addError(DCCTBBlockError::TOWERTOOLONG, this, DCCTBDataMapper::TOWERLENGTH_ID, wordEventOffset_, 25*numbDWInXtalBlock+1, numbBytes/8);
 		
 	}
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -87,23 +92,38 @@ DCCTBTowerBlock::DCCTBTowerBlock(
 	
 	// Get XTAL Data //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	uint32_t stripID, xtalID;
+	DCCTBParseContext * context = dccBlock_->context();
 	
 	
 	for(uint32_t numbXtal=1; numbXtal <= numbOfXtalBlocks && numbXtal <=25 ; numbXtal++){
 	
-		increment(1);
+		if( !increment(1) ){
+			dccBlock_->addError(DCCTBBlockError::NEXTBLOCK, this, 0, wordCounter_ + wordEventOffset_, 1);
+			return false;
+		}
 		
 		stripID =( numbXtal-1)/5 + 1;	
 		xtalID  = numbXtal - (stripID-1)*5;
 		
 		
+		// xtal blocks are recycled by the parse context of the event
+		DCCTBXtalBlock * xtalBlock = context->xtalBlockPool().get();
+		bool xtalParsed;
 		if(!zs){ 	
-			xtalBlocks_.push_back(  new DCCTBXtalBlock( parser_, dataP_, xtalBlockSize, wordsToEnd-wordCounter_,wordCounter_+wordEventOffset_,xtalID, stripID) );
+			xtalParsed = xtalBlock->initialize( parser_, dataP_, xtalBlockSize, wordsToEnd-wordCounter_,wordCounter_+wordEventOffset_,xtalID, stripID);
 		}else{
-			xtalBlocks_.push_back(  new DCCTBXtalBlock( parser_, dataP_, xtalBlockSize, wordsToEnd-wordCounter_,wordCounter_+wordEventOffset_,0,0));
+			xtalParsed = xtalBlock->initialize( parser_, dataP_, xtalBlockSize, wordsToEnd-wordCounter_,wordCounter_+wordEventOffset_,0,0);
 		}
+		if( !xtalParsed ){
+			dccBlock_->addError(DCCTBBlockError::SUBBLOCK, xtalBlock);
+			return false;
+		}
+		xtalBlocks_.push_back( xtalBlock );
 		
-		increment(xtalBlockSize/4-1);
+		if( !increment(xtalBlockSize/4-1) ){
+			dccBlock_->addError(DCCTBBlockError::NEXTBLOCK, this, 0, wordCounter_ + wordEventOffset_, xtalBlockSize/4-1);
+			return false;
+		}
 	}
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -111,49 +131,35 @@ DCCTBTowerBlock::DCCTBTowerBlock(
 	// Check internal data ////////////
 	if(parser_->debug()){ dataCheck();};
 	///////////////////////////////////
+	
+	return true;
 }
 
 
 
-DCCTBTowerBlock::~DCCTBTowerBlock(){
-	std::vector<DCCTBXtalBlock *>::iterator it;
-	for(it=xtalBlocks_.begin();it!=xtalBlocks_.end();it++){ delete (*it);}
-	xtalBlocks_.clear();
-}
+// xtal blocks belong to the parser block pool
+DCCTBTowerBlock::~DCCTBTowerBlock(){ }
 
 
 
 void DCCTBTowerBlock::dataCheck(){
-	std::string checkErrors("");	
+	uint32_t firstError = blockErrors_.size();	
 	
 	
-	std::pair <bool,std::string> res;
-	
 	///////////////////////////////////////////////////////////////////////////
 	// For TB we don-t check Bx 
-	//res = checkDataField("BX", BXMASK & (dccBlock_->getDataField("BX")));
-	//if(!res.first){ checkErrors += res.second; (errors_["FE::HEADER"])++; }
+	//if( !checkField(DCCTBDataMapper::BX_ID, BXMASK & (dccBlock_->getDataField(DCCTBDataMapper::BX_ID))) ){ countError(DCCTBErrorCounters::FE_HEADER); }
 	////////////////////////////////////////////////////////////////////////////
 	
         // mod to account for ECAL counters starting from 0 in the front end N. Almeida
-	res = checkDataField("LV1", L1MASK &  (dccBlock_->getDataField("LV1")  -1)   ); 
-	if(!res.first){ checkErrors += res.second; (errors_["FE::HEADER"])++; }
+	if( !checkField(DCCTBDataMapper::LV1_ID, L1MASK &  (dccBlock_->getDataField(DCCTBDataMapper::LV1_ID)  -1)) ){ countError(DCCTBErrorCounters::FE_HEADER); }
 	
 	
 	if(expectedTowerID_ != 0){ 
-		res = checkDataField("TT/SC ID",expectedTowerID_); 
-		if(!res.first){ checkErrors += res.second; (errors_["FE::HEADER"])++; } 
+		if( !checkField(DCCTBDataMapper::TOWERID_ID,expectedTowerID_) ){ countError(DCCTBErrorCounters::FE_HEADER); } 
 	}
 	
-	if( checkErrors !="" ){
-		std::string myTowerId;
-		
-		errorString_ +="\n ======================================================================\n"; 
-		errorString_ += std::string(" ") + name_ + std::string("( ID = ")+parser_->getDecString((uint32_t)(expectedTowerID_))+std::string(" ) errors : ") ;
-		errorString_ += checkErrors ;
-		errorString_ += "\n ======================================================================";
-		blockError_ = true;	
-	}
+	endChecks(firstError, DCCTBBlockError::IDCHECKS, expectedTowerID_);
 } 
 
 
@@ -176,14 +182,16 @@ std::vector< DCCTBXtalBlock * > DCCTBTowerBlock::xtalBlocksById(uint32_t stripId
 }
 
 int DCCTBTowerBlock::towerID() {
-  int result=-1;
 
-  for(std::set<DCCTBDataField *,DCCTBDataFieldComparator>::iterator it = mapperFields_->begin(); it!= mapperFields_->end(); it++){
-    if ( (*it)->name() == "TT/SC ID" ) 
-      result=getDataField( (*it)->name() )  ;
-    
+  return getDataField( DCCTBDataMapper::TOWERID_ID );
+
+}
+
+bool DCCTBTowerBlock::tooLong() {
+
+  for( std::vector<DCCTBBlockError>::iterator it = blockErrors_.begin(); it != blockErrors_.end(); it++ ){
+    if( it->type == DCCTBBlockError::TOWERTOOLONG ){ return true; }
   }
-  
-  return result;
+  return false;
 
 }
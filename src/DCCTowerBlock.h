@@ -32,10 +32,27 @@ class DCCTBTowerBlock : public DCCTBBlockPrototype {
 			uint32_t expectedTowerID
 		);
 		
+		DCCTBTowerBlock();
+		
+		// returns false if the header is out of scope (error recorded)
+		bool initialize(
+			DCCTBEventBlock * dccBlock,
+			DCCTBDataParser * parser, 
+			uint32_t * buffer, 
+			uint32_t numbBytes, 
+			uint32_t wordsToEnd,
+			uint32_t wordEventOffset,
+			uint32_t expectedTowerID
+		);
+		
 		~DCCTBTowerBlock();
 		
-		void parseXtalData();
+		// returns false if the xtal blocks are out of scope (error recorded in the event block)
+		bool parseXtalData();
 		int towerID();
+		
+		// true if the tower length is larger than 25 xtal blocks (only the first 25 are built)
+		bool tooLong();
 
 		std::vector< DCCTBXtalBlock * > & xtalBlocks();
 		
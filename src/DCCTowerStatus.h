@@ -0,0 +1,87 @@
+#ifndef DCCTBTOWERSTATUS_HH
+#define DCCTBTOWERSTATUS_HH
+
+#include <stdint.h>
+
+#include "DCCDataMapper.h"
+
+
+/*----------------------------------------------------------*/
+/* DCC TOWER STATUS                                         */
+/* FE channel status of the DCC header (70 channels of 4   */
+/* bits, 14 per 64 bit word from word 8) and the towers    */
+/* expected in the event, the locations of the expected     */
+/* channels in readout order (status to location table      */
+/* set once)                                                */
+/* Note: this class is defined inline                       */
+/*----------------------------------------------------------*/
+class DCCTBTowerStatus{
+public :
+
+  enum towerStatusFields{
+    MAXCHANNELS      = 70,
+    CHANNELSPERDWORD = 14,
+    CHANNELSPERWORD  = 8,              // in the first 32 bit word of a 64 bit word, the others in the second
+    STATUSBITS       = 4,
+    STATUSMASK       = DCCTBDataMapper::FE_CHSTATUS_MASK,
+    FIRSTWORD        = DCCTBDataMapper::FE_CHSTATUS_WPOSITION,
+    HEADERWORDS      = FIRSTWORD + 2*(MAXCHANNELS/CHANNELSPERDWORD),
+
+    // statuses of the expected towers: 0 (enabled), 9 (LV1 sync error) and 10 (BX sync error)
+    EXPECTEDSTATUS   = (1<<0) | (1<<9) | (1<<10),
+
+    NOTEXPECTED      = 99999           // location past the last expected tower
+  };
+
+  DCCTBTowerStatus() : numbExpected_(0) {
+    for(uint32_t ch=0; ch<=MAXCHANNELS; ch++){ statusToLocation_[ch] = ch; }
+    clear();
+  }
+
+  /**
+     Location of the tower of channel ch (1 to MAXCHANNELS), the channel itself by default
+  */
+  void setLocations(const int * statusToLocation){
+    for(uint32_t ch=0; ch<=MAXCHANNELS; ch++){ statusToLocation_[ch] = statusToLocation[ch]; }
+  }
+
+  /**
+     Reads the status of the channels 1 to MAXCHANNELS from the DCC header words to status[1..MAXCHANNELS]
+  */
+  static void decode(const uint32_t * dccHeader, short * status){
+    for(uint32_t ch=1; ch<=MAXCHANNELS; ch++){
+      uint32_t pos  = (ch-1)%CHANNELSPERDWORD;
+      uint32_t word = FIRSTWORD + 2*((ch-1)/CHANNELSPERDWORD) + pos/CHANNELSPERWORD;
+      status[ch] = ( dccHeader[word] >> (STATUSBITS*(pos%CHANNELSPERWORD)) ) & STATUSMASK;
+    }
+  }
+
+  /**
+     Sets the expected towers from the channel statuses status[1..MAXCHANNELS]
+  */
+  void fill(const short * status){
+    clear();
+    for(uint32_t ch=1; ch<=MAXCHANNELS; ch++){
+      if( (uint32_t)status[ch] < 32 && ( (EXPECTEDSTATUS >> status[ch]) & 1 ) ){
+        locations_[numbExpected_++] = statusToLocation_[ch];
+      }
+    }
+  }
+
+  uint32_t numbExpected()          { return numbExpected_;                                     }
+
+  /**
+     Location of the n-th expected tower (from 0), NOTEXPECTED after the last one
+  */
+  uint32_t location(uint32_t n)    { return n < numbExpected_ ? locations_[n] : (uint32_t) NOTEXPECTED; }
+
+protected :
+
+  void clear(){ numbExpected_ = 0; }
+
+  uint32_t numbExpected_;
+  uint32_t locations_[MAXCHANNELS];
+  uint32_t statusToLocation_[MAXCHANNELS+1];
+};
+
+#endif
@@ -9,49 +9,54 @@ DCCTBTrailerBlock::DCCTBTrailerBlock(
 	uint32_t wordEventOffset,
 	uint32_t expectedLength,
 	uint32_t expectedCRC
-) : DCCTBBlockPrototype(parser,"DCCTRAILER", buffer, numbBytes,wToEnd, wordEventOffset),
-expectedLength_(expectedLength){
+) : DCCTBBlockPrototype(){
 	
-	errors_["TRAILER::EVENT LENGTH"] = 0 ;
-	errors_["TRAILER::EOE"]    = 0 ; 
-	errors_["TRAILER::CRC"]    = 0 ;
-	errors_["TRAILER::T"]      = 0 ;
+	initialize(parser, buffer, numbBytes, wToEnd, wordEventOffset, expectedLength, expectedCRC);
+}
+
+
+DCCTBTrailerBlock::DCCTBTrailerBlock() : DCCTBBlockPrototype(), expectedLength_(0), expectedCRC_(0) { }
+
+
+bool DCCTBTrailerBlock::initialize(
+	DCCTBDataParser * parser, 
+	uint32_t * buffer, 
+	uint32_t numbBytes,  
+	uint32_t wToEnd,
+	uint32_t wordEventOffset,
+	uint32_t expectedLength,
+	uint32_t expectedCRC
+){
+	
+	DCCTBBlockPrototype::initialize(parser,"DCCTRAILER", buffer, numbBytes,wToEnd, wordEventOffset);
+	expectedLength_ = expectedLength;
+	expectedCRC_    = expectedCRC;
 	
 	// Get data fields from the mapper and retrieve data ///////////////////////////////////////////
 	mapperFields_ = parser_->mapper()->trailerFields();
-	parseData();
+	if( !parseData() ){ return false; }
 	////////////////////////////////////////////////////////////////////////////////////////////////
 
 	// check internal data ////
 	dataCheck();
 	///////////////////////////
-
+	
+	return true;
 }
 
 
 void DCCTBTrailerBlock::dataCheck(){
 	
-	std::string checkErrors("");
-	
-	std::pair<bool,std::string> res;
+	uint32_t firstError = blockErrors_.size();
 	
-	res = checkDataField("EVENT LENGTH",expectedLength_);
-	if(!res.first){ checkErrors += res.second; (errors_["TRAILER::EVENT LENGTH"])++; }
+	if( !checkField(DCCTBDataMapper::EVENTLENGTH_ID,expectedLength_) ){ countError(DCCTBErrorCounters::TRAILER_EVENTLENGTH); }
 	
-	res = checkDataField("EOE",EOE);
-	if(!res.first){ checkErrors += res.second; (errors_["TRAILER::EOE"])++; }
+	if( !checkField(DCCTBDataMapper::EOE_ID,EOE) ){ countError(DCCTBErrorCounters::TRAILER_EOE); }
 	
-	res = checkDataField("T",0);
-	if(!res.first){ checkErrors += res.second; (errors_["TRAILER::T"])++; }
+	if( !checkField(DCCTBDataMapper::T_ID,0) ){ countError(DCCTBErrorCounters::TRAILER_T); }
 	
-	//checkErrors += checkDataField("CRC",expectedCRC_);
+	//checkField(DCCTBDataMapper::CRC_ID,expectedCRC_);
 	
-	if(checkErrors!=""){
-		errorString_ +="\n ======================================================================\n"; 		
-		errorString_ += std::string(" ") + name_ + std::string(" data fields checks errors : ") ;
-		errorString_ += checkErrors ;
-		errorString_ += "\n ======================================================================";
-		blockError_ = true;	
-	}
+	endChecks(firstError);
 }
 
@@ -22,6 +22,19 @@ class DCCTBTrailerBlock : public DCCTBBlockPrototype {
 			uint32_t expectedCRC
 		);
 		
+		DCCTBTrailerBlock();
+		
+		// returns false if the block is out of scope (error recorded)
+		bool initialize(
+			DCCTBDataParser * parser, 
+			uint32_t * buffer, 
+			uint32_t numbBytes,
+			uint32_t wToEnd, 
+			uint32_t wordEventOffset,
+			uint32_t expectedLength,
+			uint32_t expectedCRC
+		);
+		
 		void dataCheck(); 
 		
 		
@@ -0,0 +1,66 @@
+#ifndef DCCTBTRIGGERPRIMITIVE_HH
+#define DCCTBTRIGGERPRIMITIVE_HH
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/*----------------------------------------------------------*/
+/* DCC TRIGGER PRIMITIVE                                    */
+/* one trigger primitive of a TCC block as it is packed in  */
+/* the 16 bit half of its 32 bit word: Et (bits 0-7), fine */
+/* grain veto bit (bit 8) and trigger tower flag (bits     */
+/* 9-11). decode unpacks all the primitives of a TCC block */
+/* in one pass, 8 at a time with SSE2 when the compiler    */
+/* targets it, with scalar code otherwise                  */
+/* Note: this class is defined inline                       */
+/*----------------------------------------------------------*/
+class DCCTBTriggerPrimitive{
+public :
+
+  enum tpFields{
+    ETMASK          = 0xFF,
+    BPOSITION_FGVB  = 8,
+    TPGMASK         = 0x1FF,          // Et and fine grain veto (TPG#i field)
+    BPOSITION_TTF   = 9,
+    TTFMASK         = 0x7,
+    DATAMASK        = 0xFFF,
+    TPWPOSITION     = 2               // 32 bit word of the first primitive in the TCC block
+  };
+
+  uint16_t data;
+
+  int  et()   const { return data & ETMASK;                     }
+  bool fgvb() const { return (data >> BPOSITION_FGVB) & 1;      }
+  int  tpg()  const { return data & TPGMASK;                    }
+  int  ttf()  const { return (data >> BPOSITION_TTF) & TTFMASK; }
+
+  /**
+     Unpacks the numbTTs primitives of the TCC block at tccBlock to tps
+     (two primitives per 32 bit word from word TPWPOSITION, the first in the low half)
+  */
+  static void decode(const uint32_t * tccBlock, uint32_t numbTTs, DCCTBTriggerPrimitive * tps){
+    const uint32_t * words = tccBlock + TPWPOSITION;
+    uint32_t tt(0);
+#ifdef __SSE2__
+    // x86: the 16 bit halves are in memory in primitive order
+    const __m128i dataMask = _mm_set1_epi16(DATAMASK);
+    for(; tt+LANES <= numbTTs; tt+=LANES){
+      __m128i half = _mm_loadu_si128( (const __m128i *)(words + tt/2) );
+      _mm_storeu_si128( (__m128i *)(tps + tt), _mm_and_si128(half, dataMask) );
+    }
+#endif
+    for(; tt<numbTTs; tt++){
+      tps[tt].data = ( words[tt/2] >> (16*(tt%2)) ) & DATAMASK;
+    }
+  }
+
+protected :
+
+  enum sse2Sizes{ LANES = 8 };
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "DCCXtalBlock.h"
 #include "DCCDataParser.h"
 #include "DCCDataMapper.h"
+#include "DCCXtalDecoder.h"
 
 
 DCCTBXtalBlock::DCCTBXtalBlock(
@@ -11,51 +12,59 @@ DCCTBXtalBlock::DCCTBXtalBlock(
 	uint32_t wordEventOffset,
 	uint32_t expectedXtalID,
 	uint32_t expectedStripID
-) : DCCTBBlockPrototype(parser,"XTAL", buffer, numbBytes, wordsToEnd, wordEventOffset),
-expectedXtalID_(expectedXtalID), expectedStripID_(expectedStripID){
+) : DCCTBBlockPrototype(){
 	
+	initialize(parser, buffer, numbBytes, wordsToEnd, wordEventOffset, expectedXtalID, expectedStripID);
+}
+
+
+
+DCCTBXtalBlock::DCCTBXtalBlock() : DCCTBBlockPrototype(), expectedXtalID_(0), expectedStripID_(0) { }
+
+
+
+bool DCCTBXtalBlock::initialize(
+	DCCTBDataParser * parser, 
+	uint32_t * buffer, 
+	uint32_t numbBytes,  
+	uint32_t wordsToEnd,
+	uint32_t wordEventOffset,
+	uint32_t expectedXtalID,
+	uint32_t expectedStripID
+){
 	
-	//Reset error counters ////
-	errors_["XTAL::HEADER"]  = 0;
-	errors_["XTAL::BLOCKID"] = 0; 
-	///////////////////////////
+	DCCTBBlockPrototype::initialize(parser,"XTAL", buffer, numbBytes, wordsToEnd, wordEventOffset);
+	expectedXtalID_  = expectedXtalID;
+	expectedStripID_ = expectedStripID;
 	
 	// Get data fields from the mapper and retrieve data /////////////////////////////////////
 	mapperFields_ = parser_->mapper()->xtalFields();	
-	parseData();
+	if( !parseData() ){ return false; }
 	//////////////////////////////////////////////////////////////////////////////////////////
 	
 	// check internal data ////////////
 	if(parser_->debug()){ dataCheck();}
 	///////////////////////////////////
-
+	
+	return true;
 }
 
 
 
 void DCCTBXtalBlock::dataCheck(){
 	
-	std::string checkErrors("");
-		
-	std::pair <bool,std::string> res;
+	uint32_t firstError = blockErrors_.size();
 	
 	
 	if(expectedXtalID_ !=0){ 
-		res = checkDataField("XTAL ID",expectedXtalID_); 
-		if(!res.first){ checkErrors += res.second; (errors_["XTAL::HEADER"])++; } 
+		if( !checkField(DCCTBDataMapper::XTALID_ID,expectedXtalID_) ){ countError(DCCTBErrorCounters::XTAL_HEADER); } 
 	}
 	if(expectedStripID_!=0){ 
-		res = checkDataField("STRIP ID",expectedStripID_);
-		if(!res.first){ checkErrors += res.second; (errors_["XTAL::HEADER"])++; } 
-	}
-	if(checkErrors!=""){
-		errorString_ +="\n ======================================================================\n"; 		
-		errorString_ += std::string(" ") + name_ + std::string(" data fields checks errors : ") ;
-		errorString_ += checkErrors ;
-		errorString_ += "\n ======================================================================";
-		blockError_ = true;	
+		if( !checkField(DCCTBDataMapper::STRIPID_ID,expectedStripID_) ){ countError(DCCTBErrorCounters::XTAL_HEADER); } 
 	}
 	
+	endChecks(firstError);
+	
 }
 
 
@@ -65,7 +74,7 @@ void  DCCTBXtalBlock::increment(uint32_t numb){
 		for(uint32_t counter=0; counter<numb; counter++, dataP_++,wordCounter_++){
 			uint32_t blockID = (*dataP_)>>BPOSITION_BLOCKID;
 			if( blockID != BLOCKID ){
-				(errors_["XTAL::BLOCKID"])++;
+				countError(DCCTBErrorCounters::XTAL_BLOCKID);
 				//errorString_ += std::string("\n") + parser_->index(nunb)+(" blockId has value ") + parser_->getDecString(blockID);
 				//errorString  += std::string(", while ")+parser_->getDecString(BLOCKID)+std::string(" is expected");
 			}
@@ -75,32 +84,13 @@ void  DCCTBXtalBlock::increment(uint32_t numb){
 
 int DCCTBXtalBlock::xtalID() {
 
-  int result=-1;
-
-  for(  std::set<DCCTBDataField *,DCCTBDataFieldComparator>::iterator 
-           it = mapperFields_->begin(); it!= mapperFields_->end(); it++){
-  
-    if ( (*it)->name() == "XTAL ID" ) 
-      result=getDataField( (*it)->name() )  ;
-    
-  }
-
-
- 
-  return result; 
+  return getDataField( DCCTBDataMapper::XTALID_ID );
 
 }
 
 int DCCTBXtalBlock::stripID() {
-  int result=-1;
 
-  for(std::set<DCCTBDataField *,DCCTBDataFieldComparator>::iterator it = mapperFields_->begin(); it!= mapperFields_->end(); it++){
-    if ( (*it)->name() == "STRIP ID" ) 
-      result=getDataField( (*it)->name() )  ;
-    
-  }
-  
-  return result;
+  return getDataField( DCCTBDataMapper::STRIPID_ID );
 
 }
 
@@ -108,14 +98,38 @@ int DCCTBXtalBlock::stripID() {
 
 std::vector<int> DCCTBXtalBlock::xtalDataSamples() {
   std::vector<int> data;
+  DCCTBDataMapper * mapper = parser_->mapper();
 
+  // lazy mode: the block is in scope, the samples are taken from the buffer
+  if( lazy_ ){
+    data.resize( parser_->numbXtalSamples() );
+    if( !data.empty() ){ DCCTBXtalDecoder<0>::decode( parser_->geometry(), beginOfBuffer_, &data[0] ); }
+    return data;
+  }
 
+  data.reserve( parser_->numbXtalSamples() );
   for(unsigned int i=1;i <= parser_->numbXtalSamples();i++){
-    std::string name = std::string("ADC#") + parser_->getDecString(i);
-    
-    data.push_back ( getDataField( name )  );
-     
+    data.push_back ( getDataField( mapper->adcId(i) )  );
   }
 
   return data;
 }
+
+
+
+uint32_t DCCTBXtalBlock::xtalDataSamples(uint16_t * samples) {
+
+  uint32_t numbSamples = parser_->numbXtalSamples();
+
+  if( lazy_ ){
+    DCCTBXtalDecoder<0>::decode( parser_->geometry(), beginOfBuffer_, samples );
+    return numbSamples;
+  }
+
+  DCCTBDataMapper * mapper = parser_->mapper();
+  for(uint32_t i=1;i <= numbSamples;i++){
+    samples[i-1] = getDataField( mapper->adcId(i) );
+  }
+
+  return numbSamples;
+}
@@ -21,10 +21,27 @@ class DCCTBXtalBlock : public DCCTBBlockPrototype {
 			uint32_t expectedStripID 
 		);
 		
+		DCCTBXtalBlock();
+		
+		// returns false if the block is out of scope (error recorded)
+		bool initialize(
+			DCCTBDataParser * parser, 
+			uint32_t * buffer,
+			uint32_t numbBytes,
+			uint32_t wordsToEnd,  
+			uint32_t wordEventOffset,
+			uint32_t expectedXtalID ,
+			uint32_t expectedStripID 
+		);
+		
 		void dataCheck(); 
 		int xtalID();
                                 int stripID();
 		std::vector<int> xtalDataSamples();
+		
+		// copies the samples to a buffer of parser->numbXtalSamples() samples
+		// (no allocation), returns the number of samples
+		uint32_t xtalDataSamples(uint16_t * samples);
 
 	protected :
 		
@@ -0,0 +1,83 @@
+/*----------------------------------------------------------*/
+/* DCC XTAL DECODER                                         */
+/* extraction of the ADC samples of a crystal block with   */
+/* the word and bit of every sample known at compile time: */
+/* DCCTBXtalDecoder<10>::decode is unrolled into one shift */
+/* and mask per sample. DCCTBXtalDecoder<0> is the decoder */
+/* for a number of samples set at run time: it uses the    */
+/* compiled decoder if there is one for it and the sample  */
+/* positions of the parser geometry otherwise               */
+/*----------------------------------------------------------*/
+
+#ifndef DCCTBXTALDECODER_HH
+#define DCCTBXTALDECODER_HH
+
+#include <stdint.h>
+
+#include "DCCDataMapper.h"
+#include "DCCGeometry.h"
+
+
+// ADC#1 to ADC#I (ADC#1 shares the first word with the ids, then two samples per word)
+template<uint32_t I> class DCCTBXtalSamples{
+
+public :
+
+  enum{
+    WORD = DCCTBDataMapper::ADC_WPOSITION + I/2,
+    BIT  = ( I==1 || I%2 ) ? DCCTBDataMapper::ADCBOFFSET : 0
+  };
+
+  template<class T> static void decode( const uint32_t * xtal, T * samples ){
+    DCCTBXtalSamples<I-1>::decode(xtal, samples);
+    samples[I-1] = ( xtal[WORD] >> BIT ) & DCCTBDataMapper::ADC_MASK;
+  }
+};
+
+template<> class DCCTBXtalSamples<0>{
+
+public :
+
+  template<class T> static void decode( const uint32_t *, T * ){}
+};
+
+
+
+template<uint32_t N> class DCCTBXtalDecoder{
+
+public :
+
+  enum{
+    NUMBSAMPLES = N,
+    DWORDS      = N/4 + 1           // 64 bit words of the crystal block
+  };
+
+  /**
+     Copies the N samples of the crystal block at xtal to samples
+  */
+  template<class T> static void decode( const uint32_t * xtal, T * samples ){
+    DCCTBXtalSamples<N>::decode(xtal, samples);
+  }
+};
+
+template<> class DCCTBXtalDecoder<0>{
+
+public :
+
+  /**
+     Copies the geometry.numbXtalSamples() samples of the crystal block at xtal to samples
+  */
+  template<class T> static void decode( DCCTBGeometry & geometry, const uint32_t * xtal, T * samples ){
+
+    if( geometry.numbXtalSamples() == 10 ){
+      DCCTBXtalDecoder<10>::decode(xtal, samples);
+      return;
+    }
+
+    for(uint32_t i=1; i<=geometry.numbXtalSamples(); i++){
+      samples[i-1] = ( xtal[geometry.sampleWord(i)] >> geometry.sampleBit(i) ) & DCCTBDataMapper::ADC_MASK;
+    }
+  }
+};
+
+#endif
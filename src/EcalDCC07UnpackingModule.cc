@@ -13,8 +13,11 @@
 #include <EventFilter/EcalTBRawToDigi/src/CamacTBDataFormatter.h>
 #include <EventFilter/EcalTBRawToDigi/src/TableDataFormatter.h>
 #include <EventFilter/EcalTBRawToDigi/src/MatacqDataFormatter.h>
+#include <EventFilter/EcalTBRawToDigi/src/EcalDCCEventSummary.h>
+#include <EventFilter/EcalTBRawToDigi/src/EcalDCCCollection.h>
 #include <EventFilter/EcalTBRawToDigi/src/ECALParserException.h>
 #include <EventFilter/EcalTBRawToDigi/src/ECALParserBlockException.h>
+#include <EventFilter/EcalTBRawToDigi/src/DCCDataParser.h>
 #include <DataFormats/FEDRawData/interface/FEDRawData.h>
 #include <DataFormats/FEDRawData/interface/FEDNumbering.h>
 #include <DataFormats/FEDRawData/interface/FEDRawDataCollection.h>
@@ -40,9 +43,12 @@
 #define TABLE_FED_ID 42
 #define MATACQ_FED_ID 43
 
+
 EcalDCCTB07UnpackingModule::EcalDCCTB07UnpackingModule(const edm::ParameterSet& pset) :
   fedRawDataCollectionTag_(pset.getParameter<edm::InputTag>("fedRawDataCollectionTag")) {
 
+  for (unsigned i = 0; i < NCOLLECTIONS; ++i) collectionSizes_[i] = 0;
+
   std::string tbName = pset.getUntrackedParameter<std::string >("tbName", std::string("h2") );
 
   ProduceEEDigis_ = pset.getUntrackedParameter<bool >("produceEEdigi", true );
@@ -124,7 +130,18 @@ EcalDCCTB07UnpackingModule::EcalDCCTB07UnpackingModule(const edm::ParameterSet&
     tbTowerIDToLocation[it] = itEB;
   }
 
-  formatter_ = new EcalTB07DaqFormatter(tbName, cryIcMap, tbStatusToLocation, tbTowerIDToLocation);
+  formatter_ = new EcalTB07DaqFormatter(tbName, cryIcMap, tbStatusToLocation, tbTowerIDToLocation,
+					DCCTBDataParser::moduleParameters(pset, "EcalDCCTB07UnpackingModule"));
+  // decode the DCC events into flat arrays instead of the block objects
+  formatter_->setSoADecoding( pset.getUntrackedParameter<bool >("soaDecoding", false ) );
+  // only the digis put in the event are filled
+  formatter_->setDigiProduction(ProduceEBDigis_, ProduceEEDigis_);
+  // warnings emitted in full per category, the others are summarized every warningSummaryInterval
+  formatter_->warnings().setLimits( pset.getUntrackedParameter<unsigned int>("maxWarnings", 10),
+				    pset.getUntrackedParameter<unsigned int>("warningSummaryInterval", 1000) );
+  // one row of header fields and error counts per DCC event, written to summaryFile if set
+  std::string summaryFile = pset.getUntrackedParameter<std::string >("summaryFile", std::string("") );
+  summary_ = summaryFile.empty() ? 0 : new EcalDCCEventSummary(summaryFile);
   ecalSupervisorFormatter_ = new EcalSupervisorTBDataFormatter();
   camacTBformatter_ = new CamacTBDataFormatter();
   tableFormatter_ = new TableDataFormatter();
@@ -163,6 +180,7 @@ EcalDCCTB07UnpackingModule::EcalDCCTB07UnpackingModule(const edm::ParameterSet&
 EcalDCCTB07UnpackingModule::~EcalDCCTB07UnpackingModule(){
 
   delete formatter_;
+  delete summary_;
 
 }
 
@@ -172,6 +190,14 @@ void EcalDCCTB07UnpackingModule::beginJob(){
 
 void EcalDCCTB07UnpackingModule::endJob(){
 
+  // DCC decoding errors of the whole job
+  edm::LogInfo("EcalTB07RawToDigi") << "DCC decoding error summary\n" << formatter_->parser()->runErrorCounters().summary();
+
+  // counts of the warnings not emitted
+  formatter_->warnings().summary();
+
+  // rows of the last events not written yet
+  if (summary_) summary_->flush();
 }
 
 void EcalDCCTB07UnpackingModule::produce(edm::Event & e, const edm::EventSetup& c){
@@ -233,6 +259,18 @@ void EcalDCCTB07UnpackingModule::produce(edm::Event & e, const edm::EventSetup&
   std::auto_ptr<EcalTBTDCRawInfo> productTdc(new EcalTBTDCRawInfo());                      
   std::auto_ptr<EcalTBEventHeader> productHeader(new EcalTBEventHeader());                      
 
+  // DCC collections (in the order of dccCollections) reserved to their size in the previous events
+  const EcalDCCTBCollection dccCollections[NCOLLECTIONS] = {
+    *productEb, *productEe, *productPN, *productDCCHeader, *productTriggerPrimitives,
+    *productDCCSize, *productTTId, *productBlockSize, *productChId, *productGain, *productGainSwitch,
+    *productMemTtId, *productMemBlockSize, *productMemGain, *productMemChIdErrors };
+  EcalDCCTBCollection::reserveAll(dccCollections, collectionSizes_, NCOLLECTIONS);
+
+  if (summary_) summary_->setCollections(productDCCSize.get(), productTTId.get(), productBlockSize.get(),
+					 productChId.get(), productGain.get(), productGainSwitch.get(),
+					 productMemTtId.get(), productMemBlockSize.get(),
+					 productMemGain.get(), productMemChIdErrors.get());
+
 
   try {
 
@@ -262,6 +300,7 @@ void EcalDCCTB07UnpackingModule::produce(edm::Event & e, const edm::EventSetup&
 	{	// do the DCC data unpacking and fill the collections
 	  
 	  (*productHeader).setSmInBeam(id);
+	  if (summary_) summary_->beginFed(*productDCCHeader);
 	  // YM add productEe to the list of arguments of the formatter
 	  formatter_->interpretRawData(data,  *productEb, *productEe, *productPN, 
 				       *productDCCHeader, 
@@ -271,6 +310,8 @@ void EcalDCCTB07UnpackingModule::produce(edm::Event & e, const edm::EventSetup&
 				       *productMemTtId,  *productMemBlockSize,
 				       *productMemGain,  *productMemChIdErrors,
 				       *productTriggerPrimitives);
+	  if (summary_) summary_->addEvents(e.id().run(), e.id().event(), id, *productDCCHeader,
+					    EcalTB07DaqFormatter::kHeadersPerEvent);
 	  int runType = (*productDCCHeader)[0].getRunType();
 	  if ( runType == EcalDCCHeaderBlock::COSMIC || runType == EcalDCCHeaderBlock::BEAMH4 ) 
 	    (*productHeader).setTriggerMask(0x1);
@@ -292,6 +333,9 @@ void EcalDCCTB07UnpackingModule::produce(edm::Event & e, const edm::EventSetup&
   }//endfor
   
 
+  // largest collection sizes, for the next events
+  EcalDCCTBCollection::recordAll(dccCollections, collectionSizes_, NCOLLECTIONS);
+
   // commit to the event  
   e.put(productPN);
   if (ProduceEBDigis_)  e.put(productEb,"ebDigis");
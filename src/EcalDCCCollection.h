@@ -0,0 +1,50 @@
+#ifndef EcalDCCCollection_H
+#define EcalDCCCollection_H
+/** \class EcalDCCTBCollection
+ *
+ *  One DCC output collection of the unpacking modules, whatever its type, seen
+ *  through its size and reserve, so that the collections of an event can be
+ *  walked as an array (in the order of the collection enum of the module).
+ *  reserveAll gives each collection of the array the largest size it had in the
+ *  previous events (0: not known yet), recordAll updates these sizes.
+ *  Note: this class is defined inline
+ */
+
+#include <cstddef>
+
+
+class EcalDCCTBCollection {
+
+ public:
+
+  EcalDCCTBCollection() : collection_(0), size_(0), reserve_(0) { }
+
+  template <class COLLECTION>
+  EcalDCCTBCollection(COLLECTION & collection) :
+    collection_(&collection), size_(&sizeOf<COLLECTION>), reserve_(&reserveOf<COLLECTION>) { }
+
+  size_t size() const           { return size_(collection_); }
+  void reserve(size_t n) const  { reserve_(collection_, n);  }
+
+  static void reserveAll(const EcalDCCTBCollection * collections, const size_t * sizes, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) if (sizes[i] > 0) collections[i].reserve(sizes[i]);
+  }
+
+  static void recordAll(const EcalDCCTBCollection * collections, size_t * sizes, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) if (collections[i].size() > sizes[i]) sizes[i] = collections[i].size();
+  }
+
+ private:
+
+  template <class COLLECTION>
+  static size_t sizeOf(const void * collection)     { return static_cast<const COLLECTION *>(collection)->size(); }
+
+  template <class COLLECTION>
+  static void reserveOf(void * collection, size_t n) { static_cast<COLLECTION *>(collection)->reserve(n); }
+
+  void * collection_;
+  size_t (*size_)(const void *);
+  void (*reserve_)(void *, size_t);
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "EcalDCCEventSummary.h"
+#include "DCCTowerStatus.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+
+static const char summaryMagic[8] = {'D','C','C','T','B','S','U','M'};
+
+static const char * columnNames[EcalDCCEventSummary::NCOLUMNS] = {
+  "RUN", "EVENT", "FED", "DCCID", "LV1", "BX", "ORBIT", "TRIGGERTYPE", "DCCERRORS",
+  "FESTATUS1", "FESTATUS2", "FESTATUS3", "TCCSTATUS", "SRSTATUS", "EXPECTEDTOWERS",
+  "DCCSIZEERRORS", "TTIDERRORS", "BLOCKSIZEERRORS", "CHIDERRORS", "GAINERRORS", "GAINSWITCHERRORS",
+  "MEMTTIDERRORS", "MEMBLOCKSIZEERRORS", "MEMGAINERRORS", "MEMCHIDERRORS"
+};
+
+
+EcalDCCEventSummary::EcalDCCEventSummary(const std::string & fileName) :
+  file_(fileName.c_str(), std::ios::out | std::ios::binary),
+  dccsize_(0), ttid_(0), blocksize_(0), chid_(0), gain_(0), gainswitch_(0),
+  memttid_(0), memblocksize_(0), memgain_(0), memchid_(0), headersBefore_(0) {
+
+  for (unsigned i = 0; i < NERRORS; ++i) errorsBefore_[i] = 0;
+  for (unsigned c = 0; c < NCOLUMNS; ++c) columns_[c].reserve(FLUSHROWS);
+
+  if (!file_) {
+    edm::LogError("EcalDCCEventSummary") << "unable to open the event summary file " << fileName;
+    return;
+  }
+
+  uint32_t header[2] = { VERSION, NCOLUMNS };
+  file_.write(summaryMagic, sizeof(summaryMagic));
+  file_.write(reinterpret_cast<const char *>(header), sizeof(header));
+  for (unsigned c = 0; c < NCOLUMNS; ++c) file_ << (c ? " " : "") << columnNames[c];
+  file_ << "\n";
+}
+
+
+EcalDCCEventSummary::~EcalDCCEventSummary(){
+  flush();
+}
+
+
+void EcalDCCEventSummary::setCollections(EBDetIdCollection * dccsize, EcalElectronicsIdCollection * ttid,
+					 EcalElectronicsIdCollection * blocksize, EBDetIdCollection * chid,
+					 EBDetIdCollection * gain, EBDetIdCollection * gainswitch,
+					 EcalElectronicsIdCollection * memttid, EcalElectronicsIdCollection * memblocksize,
+					 EcalElectronicsIdCollection * memgain, EcalElectronicsIdCollection * memchid){
+  dccsize_ = dccsize;  ttid_ = ttid;  blocksize_ = blocksize;  chid_ = chid;
+  gain_ = gain;  gainswitch_ = gainswitch;
+  memttid_ = memttid;  memblocksize_ = memblocksize;  memgain_ = memgain;  memchid_ = memchid;
+}
+
+
+// sizes of the integrity collections, in the order of the error columns
+void EcalDCCEventSummary::collectionSizes(size_t * sizes){
+  sizes[0] = dccsize_      ? dccsize_->size()      : 0;
+  sizes[1] = ttid_         ? ttid_->size()         : 0;
+  sizes[2] = blocksize_    ? blocksize_->size()    : 0;
+  sizes[3] = chid_         ? chid_->size()         : 0;
+  sizes[4] = gain_         ? gain_->size()         : 0;
+  sizes[5] = gainswitch_   ? gainswitch_->size()   : 0;
+  sizes[6] = memttid_      ? memttid_->size()      : 0;
+  sizes[7] = memblocksize_ ? memblocksize_->size() : 0;
+  sizes[8] = memgain_      ? memgain_->size()      : 0;
+  sizes[9] = memchid_      ? memchid_->size()      : 0;
+}
+
+
+void EcalDCCEventSummary::beginFed(const EcalRawDataCollection & headers){
+  headersBefore_ = headers.size();
+  collectionSizes(errorsBefore_);
+}
+
+
+void EcalDCCEventSummary::addEvents(unsigned run, unsigned event, int fed, const EcalRawDataCollection & headers,
+				    unsigned headersPerEvent){
+
+  size_t errors[NERRORS];
+  collectionSizes(errors);
+
+  if (headersPerEvent == 0) headersPerEvent = 1;
+
+  for (size_t h = headersBefore_; h < headers.size(); h += headersPerEvent) {
+    const EcalDCCHeaderBlock & header = headers[h];
+
+    uint32_t feStatus[3] = {0, 0, 0};
+    uint32_t expectedTowers = 0;
+    const std::vector<short> & status = header.getFEStatus();
+    for (unsigned ch = 0; ch < status.size() && ch < DCCTBTowerStatus::MAXCHANNELS; ++ch) {
+      if (status[ch] != 0) feStatus[ch/32] |= 1u << (ch%32);
+      if ((unsigned) status[ch] < 32 && ((DCCTBTowerStatus::EXPECTEDSTATUS >> status[ch]) & 1)) ++expectedTowers;
+    }
+
+    uint32_t tccStatus = 0;
+    const std::vector<short> & tcc = header.getTccStatus();
+    for (unsigned i = 0; i < tcc.size() && i < 8; ++i) tccStatus |= (tcc[i] & 0xF) << (4*i);
+
+    columns_[RUN].push_back(run);
+    columns_[EVENT].push_back(event);
+    columns_[FED].push_back(fed);
+    columns_[DCCID].push_back(header.getId());
+    columns_[LV1].push_back(header.getLV1());
+    columns_[BX].push_back(header.getBX());
+    columns_[ORBIT].push_back(header.getOrbit());
+    columns_[TRIGGERTYPE].push_back(header.getBasicTriggerType());
+    columns_[DCCERRORS].push_back(header.getDCCErrors());
+    columns_[FESTATUS1].push_back(feStatus[0]);
+    columns_[FESTATUS2].push_back(feStatus[1]);
+    columns_[FESTATUS3].push_back(feStatus[2]);
+    columns_[TCCSTATUS].push_back(tccStatus);
+    columns_[SRSTATUS].push_back(header.getSrpStatus());
+    columns_[EXPECTEDTOWERS].push_back(expectedTowers);
+
+    // the errors of the FED go to its first DCC event
+    for (unsigned i = 0; i < NERRORS; ++i)
+      columns_[DCCSIZEERRORS+i].push_back(h == headersBefore_ ? errors[i] - errorsBefore_[i] : 0);
+  }
+
+  if (columns_[RUN].size() >= FLUSHROWS) flush();
+}
+
+
+void EcalDCCEventSummary::flush(){
+
+  uint32_t rows = columns_[RUN].size();
+
+  if (file_ && rows > 0) {
+    file_.write(reinterpret_cast<const char *>(&rows), sizeof(rows));
+    for (unsigned c = 0; c < NCOLUMNS; ++c)
+      file_.write(reinterpret_cast<const char *>(&columns_[c][0]), rows*sizeof(uint32_t));
+    file_.flush();
+  }
+
+  for (unsigned c = 0; c < NCOLUMNS; ++c) columns_[c].clear();
+}
@@ -0,0 +1,89 @@
+#ifndef EcalDCCEventSummary_H
+#define EcalDCCEventSummary_H
+/** \class EcalDCCEventSummary
+ *
+ *  One row per DCC event with the header fields and the error counts of the
+ *  unpacker, written to a binary file (one column per field) that DQM trend
+ *  plots can read instead of the integrity collections.
+ *  FESTATUS1-3 are bitmaps of the channels 1-32, 33-64 and 65-70 whose FE status
+ *  is not 0 (enabled), TCCSTATUS packs the 4 bit status of the 4 TCCs (TCC 1 in
+ *  the low bits), the error columns count the entries added to each integrity
+ *  collection while the FED of the event was unpacked.
+ *  Rows are kept column by column and written every FLUSHROWS events, one batch
+ *  at a time and column by column, so that a reader can load a column without
+ *  parsing the others. File format (32 bit words in the byte order of the
+ *  machine that wrote it):
+ *    - header: the 8 characters DCCTBSUM, VERSION, NCOLUMNS, then the column
+ *      names separated by blanks on one line ending with '\n'
+ *    - batches up to the end of the file: the number of rows n, then NCOLUMNS
+ *      arrays of n words, in the order of summaryColumns
+ */
+
+#include <DataFormats/EcalRawData/interface/EcalRawDataCollections.h>
+#include <DataFormats/EcalDetId/interface/EcalDetIdCollections.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+
+class EcalDCCEventSummary {
+
+ public:
+
+  enum summaryColumns{ RUN, EVENT, FED, DCCID, LV1, BX, ORBIT, TRIGGERTYPE, DCCERRORS,
+		       FESTATUS1, FESTATUS2, FESTATUS3, TCCSTATUS, SRSTATUS, EXPECTEDTOWERS,
+		       DCCSIZEERRORS, TTIDERRORS, BLOCKSIZEERRORS, CHIDERRORS, GAINERRORS, GAINSWITCHERRORS,
+		       MEMTTIDERRORS, MEMBLOCKSIZEERRORS, MEMGAINERRORS, MEMCHIDERRORS, NCOLUMNS };
+
+  enum { FLUSHROWS = 1000, VERSION = 1 };
+
+  /// Opens fileName and writes the file header (an error is logged if it can not be opened)
+  EcalDCCEventSummary(const std::string & fileName);
+
+  /// Writes the rows left and closes the file
+  ~EcalDCCEventSummary();
+
+  /// Integrity collections of the current event, counted by addEvents
+  void setCollections(EBDetIdCollection * dccsize, EcalElectronicsIdCollection * ttid,
+		      EcalElectronicsIdCollection * blocksize, EBDetIdCollection * chid,
+		      EBDetIdCollection * gain, EBDetIdCollection * gainswitch,
+		      EcalElectronicsIdCollection * memttid, EcalElectronicsIdCollection * memblocksize,
+		      EcalElectronicsIdCollection * memgain, EcalElectronicsIdCollection * memchid);
+
+  /// Sizes of the collections before a FED is unpacked
+  void beginFed(const EcalRawDataCollection & headers);
+
+  /// One row for each DCC event added since beginFed, whose headers come in groups of
+  /// headersPerEvent (the first one of each group is written, the others are copies)
+  void addEvents(unsigned run, unsigned event, int fed, const EcalRawDataCollection & headers,
+		 unsigned headersPerEvent = 1);
+
+  /// Writes the rows kept so far as one batch
+  void flush();
+
+ private:
+
+  enum errorColumns{ NERRORS = MEMCHIDERRORS - DCCSIZEERRORS + 1 };
+
+  void collectionSizes(size_t * sizes);
+
+  std::ofstream file_;
+  std::vector<uint32_t> columns_[NCOLUMNS];
+
+  EBDetIdCollection * dccsize_;
+  EcalElectronicsIdCollection * ttid_;
+  EcalElectronicsIdCollection * blocksize_;
+  EBDetIdCollection * chid_;
+  EBDetIdCollection * gain_;
+  EBDetIdCollection * gainswitch_;
+  EcalElectronicsIdCollection * memttid_;
+  EcalElectronicsIdCollection * memblocksize_;
+  EcalElectronicsIdCollection * memgain_;
+  EcalElectronicsIdCollection * memchid_;
+
+  size_t headersBefore_;
+  size_t errorsBefore_[NERRORS];
+};
+#endif
@@ -0,0 +1,44 @@
+#include "DCCDataParser.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+
+// DCCTBDataParser parameters of the unpacking modules, the defaults are the ones of the test beam DCC
+std::vector<uint32_t> DCCTBDataParser::moduleParameters(const edm::ParameterSet& pset, const char * category){
+
+  std::vector<uint32_t> parameters = DCCTBDataParser::defaultParameters();
+  parameters[0] = pset.getUntrackedParameter<unsigned int>("numbXtalSamples",    parameters[0]);
+  parameters[1] = pset.getUntrackedParameter<unsigned int>("numbTriggerSamples", parameters[1]);
+  parameters[2] = pset.getUntrackedParameter<unsigned int>("numbTTs",            parameters[2]);
+  parameters[3] = pset.getUntrackedParameter<unsigned int>("numbSRF",            parameters[3]);
+  parameters[4] = pset.getUntrackedParameter<unsigned int>("dccId",              parameters[4]);
+  parameters[5] = pset.getUntrackedParameter<unsigned int>("srpId",              parameters[5]);
+
+  std::vector<unsigned int> tccIds = pset.getUntrackedParameter<std::vector<unsigned int> >("tccIds", std::vector<unsigned int>(parameters.begin()+6, parameters.end()));
+  if ( tccIds.size() != 4 )
+    edm::LogError(category) << "tccIds must have 4 TCC ids, " << tccIds.size() << " given: default ids used";
+  else
+    for (unsigned i = 0; i < 4; ++i) parameters[6+i] = tccIds[i];
+
+  // the digis hold at most 10 samples (EcalDataFrame), the TCC and SRP blocks 16, 32 or 68 towers
+  const std::vector<uint32_t> defaults = DCCTBDataParser::defaultParameters();
+  if ( parameters[0] < 1 || parameters[0] > 10 ) {
+    edm::LogError(category) << "numbXtalSamples must be 1 to 10, not " << parameters[0] << ": " << defaults[0] << " samples used";
+    parameters[0] = defaults[0];
+  }
+  if ( parameters[1] < 1 ) {
+    edm::LogError(category) << "numbTriggerSamples can not be 0: " << defaults[1] << " samples used";
+    parameters[1] = defaults[1];
+  }
+  if ( parameters[2] != 16 && parameters[2] != 32 && parameters[2] != 68 ) {
+    edm::LogError(category) << "numbTTs must be 16, 32 or 68, not " << parameters[2] << ": " << defaults[2] << " used";
+    parameters[2] = defaults[2];
+  }
+  if ( parameters[3] != 16 && parameters[3] != 32 && parameters[3] != 68 ) {
+    edm::LogError(category) << "numbSRF must be 16, 32 or 68, not " << parameters[3] << ": " << defaults[3] << " used";
+    parameters[3] = defaults[3];
+  }
+
+  return parameters;
+}
@@ -14,8 +14,11 @@
 #include <EventFilter/EcalTBRawToDigi/src/CamacTBDataFormatter.h>
 #include <EventFilter/EcalTBRawToDigi/src/TableDataFormatter.h>
 #include <EventFilter/EcalTBRawToDigi/src/MatacqDataFormatter.h>
+#include <EventFilter/EcalTBRawToDigi/src/EcalDCCEventSummary.h>
+#include <EventFilter/EcalTBRawToDigi/src/EcalDCCCollection.h>
 #include <EventFilter/EcalTBRawToDigi/src/ECALParserException.h>
 #include <EventFilter/EcalTBRawToDigi/src/ECALParserBlockException.h>
+#include <EventFilter/EcalTBRawToDigi/src/DCCDataParser.h>
 #include <DataFormats/FEDRawData/interface/FEDRawData.h>
 #include <DataFormats/FEDRawData/interface/FEDNumbering.h>
 #include <DataFormats/FEDRawData/interface/FEDRawDataCollection.h>
@@ -25,6 +28,8 @@
 #include <DataFormats/Common/interface/Handle.h>
 #include <FWCore/Framework/interface/Event.h>
 
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 
 #include <iostream>
@@ -41,10 +46,173 @@
 #define TABLE_FED_ID 42
 #define MATACQ_FED_ID 43
 
+
+// collections filled by one formatter for one DCC FED (parallel unpacking)
+struct EcalDCCTBFedProducts {
+  EBDigiCollection ebDigis;
+  EcalPnDiodeDigiCollection pnDigis;
+  EcalRawDataCollection dccHeaders;
+  EBDetIdCollection dccSize;
+  EcalElectronicsIdCollection ttId;
+  EcalElectronicsIdCollection blockSize;
+  EBDetIdCollection chId;
+  EBDetIdCollection gain;
+  EBDetIdCollection gainSwitch;
+  EcalElectronicsIdCollection memTtId;
+  EcalElectronicsIdCollection memBlockSize;
+  EcalElectronicsIdCollection memGain;
+  EcalElectronicsIdCollection memChIdErrors;
+  EcalTrigPrimDigiCollection triggerPrimitives;
+
+  // message of the exception thrown while unpacking the FED, if any
+  bool failed;
+  std::string error;
+
+  EcalDCCTBFedProducts() : failed(false) { }
+};
+
+// FEDs shared by the unpacking threads: each thread takes the next FED not yet taken
+struct EcalDCCTBFedQueue {
+  const FEDRawDataCollection * rawdata;
+  std::vector<int> fedIds;
+  std::vector<EcalDCCTBFedProducts*> * products;
+  volatile int next;
+};
+
+static void unpackDCCFeds(EcalDCCTBFedQueue * queue, EcalTBDaqFormatter * formatter){
+
+  int k;
+  while ( (k = __sync_fetch_and_add(&queue->next, 1)) < (int) queue->fedIds.size() ) {
+
+    int id = queue->fedIds[k];
+    EcalDCCTBFedProducts & p = *(*queue->products)[id];
+
+    try {
+      formatter->interpretRawData(queue->rawdata->FEDData(id),  p.ebDigis, p.pnDigis,
+				  p.dccHeaders,
+				  p.dccSize,
+				  p.ttId, p.blockSize,
+				  p.chId, p.gain, p.gainSwitch,
+				  p.memTtId,  p.memBlockSize,
+				  p.memGain,  p.memChIdErrors,
+				  p.triggerPrimitives);
+    } catch (ECALTBParserException &e) {
+      p.failed = true; p.error = e.what();
+    } catch (ECALTBParserBlockException &e) {
+      p.failed = true; p.error = e.what();
+    } catch (cms::Exception &e) {
+      p.failed = true; p.error = e.what();
+    } catch (...) {
+      p.failed = true; p.error = "Unknown exception ...";
+    }
+  }
+}
+
+// unpacking threads kept for the whole job, woken for each event: thread t unpacks
+// with formatters[t], formatters[0] is used by the thread calling run
+class EcalDCCTBUnpackingPool {
+ public:
+  EcalDCCTBUnpackingPool(const std::vector<EcalTBDaqFormatter*> & formatters) :
+    formatters_(formatters), queue_(0), generation_(0), busy_(0), stop_(false) {
+    for (unsigned t = 1; t < formatters_.size(); ++t)
+      threads_.create_thread( boost::bind(&EcalDCCTBUnpackingPool::work, this, t) );
+  }
+
+  ~EcalDCCTBUnpackingPool() {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    threads_.join_all();
+  }
+
+  // unpacks the FEDs of queue on all the threads, returns when they are all done
+  void run(EcalDCCTBFedQueue * queue) {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      queue_ = queue;
+      busy_  = formatters_.size() - 1;
+      ++generation_;
+    }
+    wake_.notify_all();
+    unpackDCCFeds(queue, formatters_[0]);
+
+    boost::mutex::scoped_lock lock(mutex_);
+    while (busy_ > 0) done_.wait(lock);
+  }
+
+ private:
+
+  void work(unsigned t) {
+    unsigned long generation = 0;
+    for (;;) {
+      EcalDCCTBFedQueue * queue;
+      {
+	boost::mutex::scoped_lock lock(mutex_);
+	while (!stop_ && generation_ == generation) wake_.wait(lock);
+	if (stop_) return;
+	generation = generation_;
+	queue = queue_;
+      }
+      unpackDCCFeds(queue, formatters_[t]);
+      {
+	boost::mutex::scoped_lock lock(mutex_);
+	if (--busy_ == 0) done_.notify_one();
+      }
+    }
+  }
+
+  std::vector<EcalTBDaqFormatter*> formatters_;
+  boost::thread_group threads_;
+  boost::mutex mutex_;
+  boost::condition_variable wake_, done_;
+  EcalDCCTBFedQueue * queue_;
+  unsigned long generation_;      // events given to the threads so far
+  unsigned busy_;                 // threads still unpacking the current event
+  bool stop_;
+};
+
+// appends the products of a FED to the event collection (reserved beforehand to the sum of the FEDs)
+template <class COLLECTION>
+static void appendCollection(COLLECTION & to, const COLLECTION & from){
+  for (typename COLLECTION::const_iterator it = from.begin(); it != from.end(); ++it) to.push_back(*it);
+}
+
+static void appendCollection(EBDigiCollection & to, const EBDigiCollection & from){
+  for (EBDigiCollection::size_type i = 0; i < from.size(); ++i) to.push_back(from.id(i), from[i].begin());
+}
+
+static void clearFedProducts(std::vector<EcalDCCTBFedProducts*> & products){
+  for (unsigned id = 0; id < products.size(); ++id) { delete products[id]; products[id] = 0; }
+}
+
+
 EcalDCCTBUnpackingModule::EcalDCCTBUnpackingModule(const edm::ParameterSet& pset) :
   fedRawDataCollectionTag_(pset.getParameter<edm::InputTag>("fedRawDataCollectionTag")) {
 
-  formatter_ = new EcalTBDaqFormatter();
+  for (unsigned i = 0; i < NCOLLECTIONS; ++i) collectionSizes_[i] = 0;
+
+  formatter_ = new EcalTBDaqFormatter(DCCTBDataParser::moduleParameters(pset, "EcalDCCTBUnpackingModule"));
+  // warnings emitted in full per category (and thread), the others are summarized every warningSummaryInterval
+  unsigned maxWarnings = pset.getUntrackedParameter<unsigned int>("maxWarnings", 10);
+  unsigned warningSummaryInterval = pset.getUntrackedParameter<unsigned int>("warningSummaryInterval", 1000);
+  formatter_->warnings()->setLimits(maxWarnings, warningSummaryInterval);
+
+  // number of threads unpacking the DCC FEDs of an event (1: serial unpacking)
+  numbThreads_ = pset.getUntrackedParameter<unsigned int>("numbThreads", 1);
+  if (numbThreads_ < 1) numbThreads_ = 1;
+  threadFormatters_.push_back(formatter_);
+  // the other threads share the parser of formatter_, each with its own parse context and warnings
+  for (unsigned t = 1; t < numbThreads_; ++t) {
+    threadFormatters_.push_back(new EcalTBDaqFormatter(formatter_->parser()));
+    threadFormatters_[t]->warnings()->setLimits(maxWarnings, warningSummaryInterval);
+  }
+  pool_ = numbThreads_ > 1 ? new EcalDCCTBUnpackingPool(threadFormatters_) : 0;
+  fedProducts_.resize(FEDNumbering::MAXFEDID+1, (EcalDCCTBFedProducts*) 0);
+  // one row of header fields and error counts per DCC event, written to summaryFile if set
+  std::string summaryFile = pset.getUntrackedParameter<std::string >("summaryFile", std::string("") );
+  summary_ = summaryFile.empty() ? 0 : new EcalDCCEventSummary(summaryFile);
   ecalSupervisorFormatter_ = new EcalSupervisorTBDataFormatter();
   camacTBformatter_ = new CamacTBDataFormatter();
   tableFormatter_ = new TableDataFormatter();
@@ -80,7 +248,11 @@ EcalDCCTBUnpackingModule::EcalDCCTBUnpackingModule(const edm::ParameterSet& pset
 
 EcalDCCTBUnpackingModule::~EcalDCCTBUnpackingModule(){
 
+  delete pool_;
+  for (unsigned t = 1; t < threadFormatters_.size(); ++t) delete threadFormatters_[t];
   delete formatter_;
+  delete summary_;
+  clearFedProducts(fedProducts_);
 
 }
 
@@ -90,6 +262,37 @@ void EcalDCCTBUnpackingModule::beginJob(){
 
 void EcalDCCTBUnpackingModule::endJob(){
 
+  // DCC decoding errors of the whole job: the unpacking threads share the parser of formatter_
+  edm::LogInfo("EcalTBRawToDigi") << "DCC decoding error summary\n" << formatter_->parser()->runErrorCounters().summary();
+
+  // counts of the warnings not emitted, by all the threads
+  for (unsigned t = 1; t < threadFormatters_.size(); ++t) formatter_->warnings()->merge(*threadFormatters_[t]->warnings());
+  formatter_->warnings()->summary();
+
+  // rows of the last events not written yet
+  if (summary_) summary_->flush();
+}
+
+// unpacks all the DCC FEDs of the event on the threads of pool_, each with its own formatter
+void EcalDCCTBUnpackingModule::decodeDCCFeds(const FEDRawDataCollection & rawdata){
+
+  clearFedProducts(fedProducts_);
+
+  EcalDCCTBFedQueue queue;
+  queue.rawdata  = &rawdata;
+  queue.products = &fedProducts_;
+  queue.next     = 0;
+
+  for (int id= 0; id<=FEDNumbering::MAXFEDID; ++id){
+    if ( rawdata.FEDData(id).size()>16 &&
+	 ( (id >= BEG_DCC_FED_ID && id <= END_DCC_FED_ID) ||
+	   (id >= BEG_DCC_FED_ID_GLOBAL && id <= END_DCC_FED_ID_GLOBAL) ) ) {
+      queue.fedIds.push_back(id);
+      fedProducts_[id] = new EcalDCCTBFedProducts();
+    }
+  }
+
+  pool_->run(&queue);
 }
 
 void EcalDCCTBUnpackingModule::produce(edm::Event & e, const edm::EventSetup& c){
@@ -148,9 +351,38 @@ void EcalDCCTBUnpackingModule::produce(edm::Event & e, const edm::EventSetup& c)
   std::auto_ptr<EcalTBTDCRawInfo> productTdc(new EcalTBTDCRawInfo());                      
   std::auto_ptr<EcalTBEventHeader> productHeader(new EcalTBEventHeader());                      
 
+  // DCC collections (in the order of dccCollections) reserved to their size in the previous events
+  const EcalDCCTBCollection dccCollections[NCOLLECTIONS] = {
+    *productEb, *productPN, *productDCCHeader, *productTriggerPrimitives,
+    *productDCCSize, *productTTId, *productBlockSize, *productChId, *productGain, *productGainSwitch,
+    *productMemTtId, *productMemBlockSize, *productMemGain, *productMemChIdErrors };
+  EcalDCCTBCollection::reserveAll(dccCollections, collectionSizes_, NCOLLECTIONS);
+
+  if (summary_) summary_->setCollections(productDCCSize.get(), productTTId.get(), productBlockSize.get(),
+					 productChId.get(), productGain.get(), productGainSwitch.get(),
+					 productMemTtId.get(), productMemBlockSize.get(),
+					 productMemGain.get(), productMemChIdErrors.get());
+
 
   try {
 
+  if (numbThreads_ > 1) {
+    decodeDCCFeds(*rawdata);
+
+    // the DCC collections are reserved once to the sum of the FED products they merge
+    size_t mergedSizes[NCOLLECTIONS] = { 0 };
+    for (unsigned id = 0; id < fedProducts_.size(); ++id) {
+      if (!fedProducts_[id]) continue;
+      EcalDCCTBFedProducts & p = *fedProducts_[id];
+      const EcalDCCTBCollection fedCollections[NCOLLECTIONS] = {
+	p.ebDigis, p.pnDigis, p.dccHeaders, p.triggerPrimitives,
+	p.dccSize, p.ttId, p.blockSize, p.chId, p.gain, p.gainSwitch,
+	p.memTtId, p.memBlockSize, p.memGain, p.memChIdErrors };
+      for (unsigned i = 0; i < NCOLLECTIONS; ++i) mergedSizes[i] += fedCollections[i].size();
+    }
+    EcalDCCTBCollection::reserveAll(dccCollections, mergedSizes, NCOLLECTIONS);
+  }
+
   for (int id= 0; id<=FEDNumbering::MAXFEDID; ++id){ 
 
     //    edm::LogInfo("EcalDCCTBUnpackingModule") << "EcalDCCTBUnpackingModule::Got FED ID "<< id <<" ";
@@ -177,14 +409,38 @@ void EcalDCCTBUnpackingModule::produce(edm::Event & e, const edm::EventSetup& c)
 	{	// do the DCC data unpacking and fill the collections
 	  
 	  (*productHeader).setSmInBeam(id);
-	  formatter_->interpretRawData(data,  *productEb, *productPN, 
-				       *productDCCHeader, 
-				       *productDCCSize, 
-				       *productTTId, *productBlockSize, 
-				       *productChId, *productGain, *productGainSwitch, 
-				       *productMemTtId,  *productMemBlockSize,
-				       *productMemGain,  *productMemChIdErrors,
-				       *productTriggerPrimitives);
+	  if (summary_) summary_->beginFed(*productDCCHeader);
+	  if (numbThreads_ > 1) {
+	    // already unpacked by decodeDCCFeds: merged here to keep the serial FED order
+	    EcalDCCTBFedProducts & p = *fedProducts_[id];
+	    if (p.failed) throw ECALTBParserException(p.error);
+	    // as in serial unpacking, no Pn digis for the Pn with mem errors in the earlier FEDs
+	    EcalTBDaqFormatter::suppressPnDigis(p.pnDigis, *productMemGain, *productMemChIdErrors);
+	    appendCollection(*productEb, p.ebDigis);
+	    appendCollection(*productPN, p.pnDigis);
+	    appendCollection(*productDCCHeader, p.dccHeaders);
+	    appendCollection(*productDCCSize, p.dccSize);
+	    appendCollection(*productTTId, p.ttId);
+	    appendCollection(*productBlockSize, p.blockSize);
+	    appendCollection(*productChId, p.chId);
+	    appendCollection(*productGain, p.gain);
+	    appendCollection(*productGainSwitch, p.gainSwitch);
+	    appendCollection(*productMemTtId, p.memTtId);
+	    appendCollection(*productMemBlockSize, p.memBlockSize);
+	    appendCollection(*productMemGain, p.memGain);
+	    appendCollection(*productMemChIdErrors, p.memChIdErrors);
+	    appendCollection(*productTriggerPrimitives, p.triggerPrimitives);
+	  }
+	  else
+	    formatter_->interpretRawData(data,  *productEb, *productPN, 
+					 *productDCCHeader, 
+					 *productDCCSize, 
+					 *productTTId, *productBlockSize, 
+					 *productChId, *productGain, *productGainSwitch, 
+					 *productMemTtId,  *productMemBlockSize,
+					 *productMemGain,  *productMemChIdErrors,
+					 *productTriggerPrimitives);
+	  if (summary_) summary_->addEvents(e.id().run(), e.id().event(), id, *productDCCHeader);
 	  int runType = (*productDCCHeader)[0].getRunType();
 	  if ( runType == EcalDCCHeaderBlock::COSMIC || runType == EcalDCCHeaderBlock::BEAMH4 ) 
 	    (*productHeader).setTriggerMask(0x1);
@@ -206,6 +462,9 @@ void EcalDCCTBUnpackingModule::produce(edm::Event & e, const edm::EventSetup& c)
   }//endfor
   
 
+  // largest collection sizes, for the next events
+  EcalDCCTBCollection::recordAll(dccCollections, collectionSizes_, NCOLLECTIONS);
+
   // commit to the event  
   e.put(productPN);
   e.put(productEb,"ebDigis");
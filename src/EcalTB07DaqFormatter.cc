@@ -29,6 +29,10 @@
 #include "DCCTCCBlock.h"
 #include "DCCXtalBlock.h"
 #include "DCCDataMapper.h"
+#include "DCCEventSoA.h"
+#include "DCCGainCheck.h"
+#include "DCCParseContext.h"
+#include "DCCPnSample.h"
 
 
 #include <iostream>
@@ -37,39 +41,45 @@
 EcalTB07DaqFormatter::EcalTB07DaqFormatter (std::string tbName,
 					    int cryIcMap[68][5][5], 
 					    int tbStatusToLocation[71], 
-					    int tbTowerIDToLocation[201]) {
+					    int tbTowerIDToLocation[201],
+					    const std::vector<uint32_t> & parserParameters) :
+  warnings_("EcalTB07RawToDigi") {
 
   LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter";
-  std::vector<uint32_t> parameters;
-  parameters.push_back(10); // parameters[0] is the xtal samples 
-  parameters.push_back(1);  // parameters[1] is the number of trigger time samples for TPG's
-  parameters.push_back(68); // parameters[2] is the number of TT
-  parameters.push_back(68); // parameters[3] is the number of SR Flags
-  parameters.push_back(1);  // parameters[4] is the dcc id
-  parameters.push_back(1);  // parameters[5] is the sr id
-  parameters.push_back(1);  // parameters[6] is the tcc1 id
-  parameters.push_back(2);  // parameters[7] is the tcc2 id
-  parameters.push_back(3);  // parameters[8] is the tcc3 id
-  parameters.push_back(4);  // parameters[9] is the tcc4 id
-
-  theParser_ = new DCCTBDataParser(parameters);
+  // lazy decoding: blocks only live while the FED buffer is interpreted,
+  // so fields are extracted from it when (and if) they are read
+  theParser_ = new DCCTBDataParser(parserParameters, true, true, true);
+  theContext_ = new DCCTBParseContext();
+  xtalSamples_.resize(theParser_->numbXtalSamples());
+  triggerPrimitives_.resize(theParser_->numbTTs());
 
   tbName_ = tbName;
+  soaDecoding_ = false;
+  produceEB_ = true;
+  produceEE_ = true;
 
   for(int i=0; i<68; ++i) 
     for (int j=0; j<5; ++j)
       for (int k=0; k<5; ++k)
 	cryIcMap_[i][j][k] = cryIcMap[i][j][k];
   
-  for(int i=0; i<71; ++i)
-    tbStatusToLocation_[i] = tbStatusToLocation[i];
+  towerStatus_.setLocations(tbStatusToLocation);
   
   for(int i=0; i<201; ++i)
     tbTowerIDToLocation_[i] = tbTowerIDToLocation[i];
 
+  buildDetIdTables();
 
 }
  
+EcalTB07DaqFormatter::~EcalTB07DaqFormatter(){
+
+  LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter" << "\n";
+  delete theContext_;
+  delete theParser_;
+
+}
+
 void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData , 
 					    EBDigiCollection& digicollection,
 					    EEDigiCollection& eeDigiCollection,
@@ -100,14 +110,46 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
  
 
   // mean + 3sigma estimation needed when switching to 0suppressed data
-  digicollection.reserve(kCrystals);
-  eeDigiCollection.reserve(kCrystals);
+  if (produceEB_) digicollection.reserve(kCrystals);
+  if (produceEE_) eeDigiCollection.reserve(kCrystals);
   pnAllocated = false;
   
+  // Pn with mem channel errors already in the collections (updated as errors are found)
+  memChannelErrors_ = 0;
+  flagMemChannels(memgaincollection);
+  flagMemChannels(memchidcollection);
+
+
+  // flat decoding: no block objects, the digis are filled from the DCCTBEventSoA arrays
+  if( soaDecoding_ ){
+
+    theParser_->decodeToSoA( *theContext_, reinterpret_cast<uint32_t*>(const_cast<unsigned char*>(pData)), static_cast<uint32_t>(length), shit );
+
+    std::vector< DCCTBEventSoA * > & soaEvents = theContext_->soaEvents();
+    for( std::vector< DCCTBEventSoA * >::iterator itEvent = soaEvents.begin();
+	 itEvent != soaEvents.end();
+	 itEvent++){
+
+      bool eventIsOk = interpretSoAEvent( (*itEvent), digicollection, eeDigiCollection, pndigicollection,
+					  DCCheaderCollection, dccsizecollection,
+					  ttidcollection, blocksizecollection,
+					  chidcollection, gaincollection, gainswitchcollection,
+					  memttidcollection, memblocksizecollection,
+					  memgaincollection, memchidcollection,
+					  tpcollection);
+      if( !eventIsOk ) return;
+    }
+    return;
+  }
 
-  theParser_->parseBuffer( reinterpret_cast<uint32_t*>(const_cast<unsigned char*>(pData)), static_cast<uint32_t>(length), shit );
+
+  theParser_->parseBuffer( *theContext_, reinterpret_cast<uint32_t*>(const_cast<unsigned char*>(pData)), static_cast<uint32_t>(length), shit );
   
-  std::vector< DCCTBEventBlock * > &   dccEventBlocks = theParser_->dccEvents();
+  std::vector< DCCTBEventBlock * > &   dccEventBlocks = theContext_->dccEvents();
+
+  // blocks are recycled by the context: after the first events no new block should be allocated
+  LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+			      << "block allocations " << theContext_->blockAllocations();
 
   // Access each DCCTB block
   for( std::vector< DCCTBEventBlock * >::iterator itEventBlock = dccEventBlocks.begin(); 
@@ -125,122 +167,405 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
       }
 
     // getting the fields of the DCC header
-    EcalDCCHeaderBlock theDCCheader;
-
-    theDCCheader.setId(46);                                                      // tb EE unpacker: forced to 46 to match EE region used at h2
-    int fedId = (*itEventBlock)->getDataField("FED/DCC ID");
-    theDCCheader.setFedId( fedId );                                             // fed id as found in raw data (0... 35 at tb )
-
-    theDCCheader.setRunNumber((*itEventBlock)->getDataField("RUN NUMBER"));
-    short trigger_type = (*itEventBlock)->getDataField("TRIGGER TYPE");
-    short zs  = (*itEventBlock)->getDataField("ZS");
-    short tzs = (*itEventBlock)->getDataField("TZS");
-    short sr  = (*itEventBlock)->getDataField("SR");
-    bool  dataIsSuppressed;
-
-    // if zs&&tzs the suppression algo is used in DCC, the data are not suppressed and zs-bits are set
-    if ( zs && !(tzs) ) dataIsSuppressed = true;
-    else  dataIsSuppressed = false;
-
-    if(trigger_type >0 && trigger_type <5){theDCCheader.setBasicTriggerType(trigger_type);}
-    else{ edm::LogWarning("EcalTB07RawToDigiTriggerType") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
-							<< "unrecognized TRIGGER TYPE: "<<trigger_type;}
-    theDCCheader.setLV1((*itEventBlock)->getDataField("LV1"));
-    theDCCheader.setOrbit((*itEventBlock)->getDataField("ORBIT COUNTER"));
-    theDCCheader.setBX((*itEventBlock)->getDataField("BX"));
-    theDCCheader.setErrors((*itEventBlock)->getDataField("DCC ERRORS"));
-    theDCCheader.setSelectiveReadout( sr );
-    theDCCheader.setZeroSuppression( zs );
-    theDCCheader.setTestZeroSuppression( tzs );
-    theDCCheader.setSrpStatus((*itEventBlock)->getDataField("SR_CHSTATUS"));
-
-
-
-
-    std::vector<short> theTCCs;
-    for(int i=0; i<MAX_TCC_SIZE; i++){
-      
-      char TCCnum[20]; sprintf(TCCnum,"TCC_CHSTATUS#%d",i+1); std::string TCCnumS(TCCnum);
-      theTCCs.push_back ((*itEventBlock)->getDataField(TCCnumS) );
-    }
-    theDCCheader.setTccStatus(theTCCs);
+    short TowerStatus[MAX_TT_SIZE+1];
+    bool  dataIsSuppressed = fillDCCHeader( (*itEventBlock), DCCheaderCollection, TowerStatus);
+    int   lv1 = (*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID);
 
 
     std::vector< DCCTBTCCBlock * > tccBlocks = (*itEventBlock)->tccBlocks();
+    tpcollection.reserve(tpcollection.size() + tccBlocks.size()*theParser_->numbTTs());
     
     for(    std::vector< DCCTBTCCBlock * >::iterator itTCCBlock = tccBlocks.begin(); 
 	    itTCCBlock != tccBlocks.end(); 
 	    itTCCBlock ++)
       {
 
-	std::vector< std::pair<int,bool> > TpSamples = (* itTCCBlock) -> triggerSamples() ;
-	// std::vector of 3 bits
-	std::vector<int> TpFlags      = (* itTCCBlock) -> triggerFlags() ;
+	// Et, fine grain veto and flag (3 bits) of all the towers in one pass
+	uint32_t numbTPs = (* itTCCBlock) -> triggerPrimitives(&triggerPrimitives_[0]) ;
 	
 	// there have always to be 68 primitives and flags, per FED
-	if (TpSamples.size()==68   && TpFlags.size()==68)
+	if (numbTPs==68)
 	  {
-	    for(int i=0; i<((int)TpSamples.size()); i++)	
+	    for(int i=0; i<((int)numbTPs); i++)	
+	      fillTriggerPrimitive(i, triggerPrimitives_[i], tpcollection);
+	  }// end if
+	else
 	      {
+	    edm::LogWarning("EcalTB07RawToDigiTpg") << "68 elements not found for TpFlags or TpSamples, collection will be empty";
+	  }
+      }  
 		
-		int etaTT = (i)  / kTowersInPhi +1;
-		int phiTT = (i) % kTowersInPhi +1;
 
-		// follow HB convention in iphi
-		phiTT=3-phiTT;
-		if(phiTT<=0)phiTT=phiTT+72;
+    std::vector< DCCTBTowerBlock * > dccTowerBlocks = (*itEventBlock)->towerBlocks();
+    LogDebug("EcalTB07RawToDigi") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"
+				<< "dccTowerBlocks size " << dccTowerBlocks.size();
 
-		EcalTriggerPrimitiveSample theSample(TpSamples[i].first, TpSamples[i].second, TpFlags[i]);
 
-		EcalTrigTowerDetId idtt(2, EcalBarrel, etaTT, phiTT, 0);
-		EcalTriggerPrimitiveDigi thePrimitive(idtt);
-		thePrimitive.setSize(1);                          // hard coded
-		thePrimitive.setSample(0, theSample);
+    fillExpectedTowers(TowerStatus);
 		
-		tpcollection.push_back(thePrimitive);
+    // if number of dccEventBlocks NOT same as expected stop
+    if (!      (dccTowerBlocks.size() == towerStatus_.numbExpected())      )
+      { 
+        // we probably always want to know if this happens
+        edm::LogWarning("EcalTB07RawToDigiNumTowerBlocks") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+				      << "number of TowerBlocks found (" << dccTowerBlocks.size()
+				      << ") differs from expected (" << towerStatus_.numbExpected() 
+				      << ") skipping event"; 
 		
-		LogDebug("EcalTB07RawToDigiTpg") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"
-					       << "tower: " << (i+1) 
-					       << " primitive: " << TpSamples[i].first
-					       << " flag: " << TpSamples[i].second;
-
-		LogDebug("EcalTB07RawToDigiTpg") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"<<
-		  "tower: " << (i+1) << " flag: " << TpFlags[i];
-	      }// end loop on tower primitives
+        EBDetId idsm(1, 1);
+        dccsizecollection.push_back(idsm);
+
+	return;
 	    
-	  }// end if
+      }  
+
+
+
+
+
+    // Access the Tower block    
+    for( std::vector< DCCTBTowerBlock * >::iterator itTowerBlock = dccTowerBlocks.begin(); 
+         itTowerBlock!= dccTowerBlocks.end(); 
+         itTowerBlock++){
+
+      int hardwareId = (*itTowerBlock)->towerID();
+      tower = tbTowerIDToLocation_[hardwareId];
+
+      // checking if tt in data is the same as tt expected 
+      // else skip tower and increment problem counter
+      if ( ! checkTowerId(tower, hardwareId, ttidcollection, memttidcollection) ) continue;
+
+      // dccId set to 46 in order to match 'real' CMS positio at H2
+      EcalElectronicsId idtt(46, towerStatus_.location(_expTowersIndex), 1, 1);
+
+
+      /*********************************
+       //    tt: 1 ... 68: crystal data
+       *********************************/
+      if (  0<  hardwareId &&
+	    (hardwareId < (kTriggerTowers+1)  ||
+	     hardwareId == 71 ||
+	     hardwareId == 80)
+	    )
+	{
+
+	  std::vector<DCCTBXtalBlock * > & xtalDataBlocks = (*itTowerBlock)->xtalBlocks();	
+
+	  // if there is no zero suppression, tower block must have have 25 channels in it
+	  if (  (!dataIsSuppressed)   &&   (xtalDataBlocks.size() != kChannelsPerTower)   )
+	    {     
+	      if (warnings_.report(EcalTBWarningAggregator::TOWERSIZE, towerStatus_.location(_expTowersIndex)))
+	        edm::LogWarning("EcalTB07RawToDigiTowerSize") << "EcalTB07DaqFormatter::interpretRawData, no zero suppression "
+					    << "wrong tower block size is: "  << xtalDataBlocks.size() 
+					    << " at LV1 " << lv1
+					    << " for TT " << towerStatus_.location(_expTowersIndex);
+	      // report on wrong tt block size
+	      blocksizecollection.push_back(idtt);
+
+	      ++ _expTowersIndex; 	      continue;	
+
+	    }
+
+	  // tower longer than 25 xtal blocks: the parser built only the first 25
+	  if ( (*itTowerBlock)->tooLong() )
+	    {
+	      if (warnings_.report(EcalTBWarningAggregator::TOWERSIZE, towerStatus_.location(_expTowersIndex)))
+	        edm::LogWarning("EcalTB07RawToDigiTowerSize") << "EcalTB07DaqFormatter::interpretRawData, tower block longer than "
+					    << kChannelsPerTower << " xtals at LV1 " << lv1
+					    << " for TT " << towerStatus_.location(_expTowersIndex);
+	      blocksizecollection.push_back(idtt);
+
+	      ++ _expTowersIndex; 	      continue;	
+	    }
+
+
+	  short expCryInTower =0;
+
+	  // Access the Xstal data
+	  for( std::vector< DCCTBXtalBlock * >::iterator itXtalBlock = xtalDataBlocks.begin(); 
+	       itXtalBlock!= xtalDataBlocks.end(); 
+	       itXtalBlock++){ //loop on crys of a  tower
+
+	    strip              =(*itXtalBlock)->stripID();
+	    ch                 =(*itXtalBlock)->xtalID();
+
+	    short expStripInTower   =  expCryInTower/5 +1;
+	    short expCryInStrip     =  expCryInTower%5 +1;
+
+	    if ( ! checkXtalId(tower, strip, ch, dataIsSuppressed, expCryInTower, lv1, chidcollection) ) continue;
+
+	    uint32_t numbSamples = (*itXtalBlock)->xtalDataSamples(&xtalSamples_[0]);
+	    bool     gainZero;
+	    uint32_t numbGainSwitches;
+	    DCCTBGainCheck::checkXtal(&xtalSamples_[0], numbSamples, gainZero, numbGainSwitches);
+	    fillXtalDigi(tower, strip, ch, expStripInTower, expCryInStrip, &xtalSamples_[0], numbSamples,
+			 gainZero, numbGainSwitches, lv1, digicollection, eeDigiCollection, gaincollection, gainswitchcollection);
+
+	  }// end loop on crystals within a tower block
+
+	  _expTowersIndex++;
+	}// end: tt1 ... tt68, crystal data
+
+
+
+
+
+      /******************************************************************
+       //    tt 69 and 70:  two mem boxes, holding PN0 ... PN9
+       ******************************************************************/	
+      else if (       hardwareId == 69
+                      ||	   hardwareId == 70       )
+	{
+
+	  LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+				      << "processing mem box num: " << hardwareId;
+
+	  // if tt 69 or 70 found, allocate Pn digi collection
+	  if(! pnAllocated) 
+	    {     
+	      pndigicollection.reserve(kPns);
+	      pnAllocated = true;
+	    }
+
+	  DecodeMEM( (*itTowerBlock),  pndigicollection , 
+		     memttidcollection,  memblocksizecollection,
+		     memgaincollection,  memchidcollection);
+
+	}// end of < if it is a mem box>
+
+
+
+
+
+      // wrong tt id
+      else  {
+        if (warnings_.report(EcalTBWarningAggregator::TOWERID, hardwareId))
+          edm::LogWarning("EcalTB07RawToDigiTowerId") <<"@SUB=EcalTB07DaqFormatter::interpretRawData"
+				      << " processing tt with ID not existing ( "
+				      <<  hardwareId << ")";
+        ++ _expTowersIndex;
+	continue; 
+      }// end: tt id error
+
+    }// end loop on trigger towers
+
+  }// end loop on events
+}
+
+
+
+// same as the loop on DCCTBEventBlocks above, reading the flat arrays of the event:
+// returns false if the rest of the buffer has to be skipped
+bool EcalTB07DaqFormatter::interpretSoAEvent( DCCTBEventSoA * event,
+					       EBDigiCollection& digicollection,
+					       EEDigiCollection& eeDigiCollection,
+					       EcalPnDiodeDigiCollection & pndigicollection,
+					       EcalRawDataCollection& DCCheaderCollection,
+					       EBDetIdCollection & dccsizecollection,
+					       EcalElectronicsIdCollection & ttidcollection,
+					       EcalElectronicsIdCollection & blocksizecollection,
+					       EBDetIdCollection & chidcollection , EBDetIdCollection & gaincollection,
+					       EBDetIdCollection & gainswitchcollection,
+					       EcalElectronicsIdCollection & memttidcollection,
+					       EcalElectronicsIdCollection & memblocksizecollection,
+					       EcalElectronicsIdCollection & memgaincollection,
+					       EcalElectronicsIdCollection & memchidcollection,
+					       EcalTrigPrimDigiCollection &tpcollection)
+{
+
+  short TowerStatus[MAX_TT_SIZE+1];
+  bool  dataIsSuppressed = fillDCCHeader( event, DCCheaderCollection, TowerStatus);
+  int   lv1 = event->getDataField(DCCTBDataMapper::LV1_ID);
+
+  tpcollection.reserve(tpcollection.size() + event->numbTCCBlocks()*event->numbTTs());
+
+  for(unsigned tcc=0; tcc < event->numbTCCBlocks(); tcc++)
+    {     
+      // there have always to be 68 primitives and flags, per FED
+      if ( event->numbTTs() == 68 )
+	{
+	  for(int i=0; i<68; i++)
+	    fillTriggerPrimitive(i, event->triggerPrimitive(tcc, i), tpcollection);
+	}
 	else
 	  {
 	    edm::LogWarning("EcalTB07RawToDigiTpg") << "68 elements not found for TpFlags or TpSamples, collection will be empty";
 	  }
       }  
     
+  LogDebug("EcalTB07RawToDigi") << "@SUBS=EcalTB07DaqFormatter::interpretSoAEvent"
+			      << "dccTowerBlocks size " << event->numbTowers();
     
+  fillExpectedTowers(TowerStatus);
+
+  if ( event->numbTowers() != towerStatus_.numbExpected() )
+    {     
+      edm::LogWarning("EcalTB07RawToDigiNumTowerBlocks") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+							 << "number of TowerBlocks found (" << event->numbTowers()
+							 << ") differs from expected (" << towerStatus_.numbExpected()
+							 << ") skipping event";
+
+      EBDetId idsm(1, 1);
+      dccsizecollection.push_back(idsm);
+      return false;
+    }
+
+
+  for(unsigned t=0; t < event->numbTowers(); t++){
+
+    int hardwareId = event->towerID(t);
+    unsigned tower = tbTowerIDToLocation_[hardwareId];
+
+    if ( ! checkTowerId(tower, hardwareId, ttidcollection, memttidcollection) ) continue;
+
+    EcalElectronicsId idtt(46, towerStatus_.location(_expTowersIndex), 1, 1);
+
+    // tt: 1 ... 68: crystal data
+    if ( 0 < hardwareId && (hardwareId < (kTriggerTowers+1) || hardwareId == 71 || hardwareId == 80) )
+      { 
+	unsigned numbXtals = event->numbXtals(t);
+
+	if ( (!dataIsSuppressed) && (numbXtals != kChannelsPerTower) )
+	  {
+	    if (warnings_.report(EcalTBWarningAggregator::TOWERSIZE, towerStatus_.location(_expTowersIndex)))
+	      edm::LogWarning("EcalTB07RawToDigiTowerSize") << "EcalTB07DaqFormatter::interpretRawData, no zero suppression "
+							  << "wrong tower block size is: "  << numbXtals
+							  << " at LV1 " << lv1
+							  << " for TT " << towerStatus_.location(_expTowersIndex);
+	    blocksizecollection.push_back(idtt);
+
+	    ++ _expTowersIndex;   continue;
+	  }
+
+	if ( event->towerErrors(t) & DCCTBEventSoA::TOOLONG_ERROR )
+	  {
+	    if (warnings_.report(EcalTBWarningAggregator::TOWERSIZE, towerStatus_.location(_expTowersIndex)))
+	      edm::LogWarning("EcalTB07RawToDigiTowerSize") << "EcalTB07DaqFormatter::interpretRawData, tower block longer than "
+							  << kChannelsPerTower << " xtals at LV1 " << lv1
+							  << " for TT " << towerStatus_.location(_expTowersIndex);
+	    blocksizecollection.push_back(idtt);
+
+	    ++ _expTowersIndex;   continue;
+	  }
+
+	short expCryInTower =0;
+
+	for(unsigned c=0; c < numbXtals; c++){
+
+	  int strip = event->stripID(t, c);
+	  int ch    = event->xtalID(t, c);
+
+	  short expStripInTower   =  expCryInTower/5 +1;
+	  short expCryInStrip     =  expCryInTower%5 +1;
+
+	  if ( ! checkXtalId(tower, strip, ch, dataIsSuppressed, expCryInTower, lv1, chidcollection) ) continue;
+
+	  // gain bits already checked tower by tower by the decoder
+	  fillXtalDigi(tower, strip, ch, expStripInTower, expCryInStrip, event->xtalDataSamples(t, c), event->numbXtalSamples(),
+		       event->xtalErrors(t, c) & DCCTBEventSoA::GAINZERO_ERROR, event->numbGainSwitches(t, c), lv1, digicollection, eeDigiCollection, gaincollection, gainswitchcollection);
+	}
+
+	_expTowersIndex++;
+      }  
+
+    // tt 69 and 70:  two mem boxes, holding PN0 ... PN9
+    else if ( hardwareId == 69 || hardwareId == 70 )
+      { 
+	LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter::interpretSoAEvent"
+				    << "processing mem box num: " << hardwareId;
+
+	if(! pnAllocated)
+	  {
+	    pndigicollection.reserve(kPns);
+	    pnAllocated = true;
+	  }
+
+	DecodeMEM( event, t, pndigicollection,
+		   memttidcollection,  memblocksizecollection,
+		   memgaincollection,  memchidcollection);
+      }  
+
+    // wrong tt id
+    else  {
+      if (warnings_.report(EcalTBWarningAggregator::TOWERID, hardwareId))
+        edm::LogWarning("EcalTB07RawToDigiTowerId") <<"@SUB=EcalTB07DaqFormatter::interpretRawData"
+						  << " processing tt with ID not existing ( "
+						  <<  hardwareId << ")";
+      ++ _expTowersIndex;
+    }
+
+  }// end loop on trigger towers
+
+  return true;
+}
+
+
+
+// fills the DCC header (and the 3 copies for the EE region used at h4) and the tower statuses:
+// returns true if the data are zero suppressed
+template <class EVENT>
+bool EcalTB07DaqFormatter::fillDCCHeader(EVENT * event, EcalRawDataCollection& DCCheaderCollection, short * TowerStatus)
+{
+    EcalDCCHeaderBlock theDCCheader;
+
+    theDCCheader.setId(46);                                                      // tb EE unpacker: forced to 46 to match EE region used at h2
+    int fedId = event->getDataField(DCCTBDataMapper::DCCID_ID);
+    theDCCheader.setFedId( fedId );                                             // fed id as found in raw data (0... 35 at tb )
+
+    theDCCheader.setRunNumber(event->getDataField(DCCTBDataMapper::RNUMB_ID));
+    short trigger_type = event->getDataField(DCCTBDataMapper::TRIGGERTYPE_ID);
+    short zs  = event->getDataField(DCCTBDataMapper::ZS_ID);
+    short tzs = event->getDataField(DCCTBDataMapper::TZS_ID);
+    short sr  = event->getDataField(DCCTBDataMapper::SR_ID);
+    bool  dataIsSuppressed;
+
+    // if zs&&tzs the suppression algo is used in DCC, the data are not suppressed and zs-bits are set
+    if ( zs && !(tzs) ) dataIsSuppressed = true;
+    else  dataIsSuppressed = false;
+
+    if(trigger_type >0 && trigger_type <5){theDCCheader.setBasicTriggerType(trigger_type);}
+    else{ edm::LogWarning("EcalTB07RawToDigiTriggerType") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+							<< "unrecognized TRIGGER TYPE: "<<trigger_type;}
+    theDCCheader.setLV1(event->getDataField(DCCTBDataMapper::LV1_ID));
+    theDCCheader.setOrbit(event->getDataField(DCCTBDataMapper::ORBITCOUNTER_ID));
+    theDCCheader.setBX(event->getDataField(DCCTBDataMapper::BX_ID));
+    theDCCheader.setErrors(event->getDataField(DCCTBDataMapper::DCCERRORS_ID));
+    theDCCheader.setSelectiveReadout( sr );
+    theDCCheader.setZeroSuppression( zs );
+    theDCCheader.setTestZeroSuppression( tzs );
+    theDCCheader.setSrpStatus(event->getDataField(DCCTBDataMapper::SR_CHSTATUS_ID));
+
+
+
+
+    std::vector<short> theTCCs;
+    for(int i=0; i<MAX_TCC_SIZE; i++){
+
+      theTCCs.push_back (event->getDataField(theParser_->mapper()->tccChStatusId(i+1)) );
+    }
+    theDCCheader.setTccStatus(theTCCs);
     
     
-    short TowerStatus[MAX_TT_SIZE+1];
-    char buffer[20];
-    std::vector<short> theTTstatus;
-    for(int i=1;i<MAX_TT_SIZE+1;i++)
-      { 
- 	sprintf(buffer, "FE_CHSTATUS#%d", i);
- 	std::string Tower(buffer);
- 	TowerStatus[i]= (*itEventBlock)->getDataField(Tower);
-	theTTstatus.push_back(TowerStatus[i]);
-	//std::cout << "tower " << i << " has status " <<  TowerStatus[i] << std::endl;  
-      }
+    // FE channel statuses straight from the header words (field by field if the header is not complete)
+    uint32_t * headerWords = event->headerWords();
+    if( headerWords ){ DCCTBTowerStatus::decode(headerWords, TowerStatus); }
+    else{
+      for(int i=1;i<MAX_TT_SIZE+1;i++)
+	TowerStatus[i]= event->getDataField(theParser_->mapper()->feChStatusId(i));
+    }
+    std::vector<short> theTTstatus(TowerStatus+1, TowerStatus+MAX_TT_SIZE+1);
     bool checkTowerStatus = TowerStatus[1] == 0 && TowerStatus[2] == 0 && TowerStatus[3] == 0 && TowerStatus[4] == 0;
     for (int i=5; i < MAX_TT_SIZE+1; ++i) checkTowerStatus = checkTowerStatus && TowerStatus[i] == 1;
-    if (!checkTowerStatus) {
-      for(int i=1; i<MAX_TT_SIZE+1; ++i) {
-	std::cout << "tower " << i << " has status " << TowerStatus[i] << std::endl;
-      }
+    if (!checkTowerStatus && warnings_.report(EcalTBWarningAggregator::TOWERSTATUS, 0)) {
+      edm::LogWarning status("EcalTB07RawToDigiTowerStatus");
+      status << "@SUB=EcalTB07DaqFormatter::interpretRawData" << "unexpected tower status, tower:status";
+      for(int i=1; i<MAX_TT_SIZE+1; ++i) status << " " << i << ":" << TowerStatus[i];
     }
 
     theDCCheader.setFEStatus(theTTstatus);
 
     EcalDCCTBHeaderRuntypeDecoder theRuntypeDecoder;
-    uint32_t DCCruntype = (*itEventBlock)->getDataField("RUN TYPE");
+    uint32_t DCCruntype = event->getDataField(DCCTBDataMapper::RUNTYPE_ID);
     theRuntypeDecoder.Decode(DCCruntype, &theDCCheader);
     //DCCHeader filled!
     DCCheaderCollection.push_back(theDCCheader);
@@ -254,164 +579,123 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
     hdr.setId(06);
     DCCheaderCollection.push_back(hdr);
 
-    std::vector< DCCTBTowerBlock * > dccTowerBlocks = (*itEventBlock)->towerBlocks();
-    LogDebug("EcalTB07RawToDigi") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"
-				<< "dccTowerBlocks size " << dccTowerBlocks.size();
+    return dataIsSuppressed;
+}
 
 
 
-    _expTowersIndex=0;_numExpectedTowers=0;
-    for (int v=0; v<71; v++){
-      _ExpectedTowers[v]=99999;
-    }
+void EcalTB07DaqFormatter::fillTriggerPrimitive(int i, const DCCTBTriggerPrimitive & tp, EcalTrigPrimDigiCollection &tpcollection)
+{
+  int etaTT = (i)  / kTowersInPhi +1;
+  int phiTT = (i) % kTowersInPhi +1;
+
+  // follow HB convention in iphi
+  phiTT=3-phiTT;
+  if(phiTT<=0)phiTT=phiTT+72;
+
+  EcalTriggerPrimitiveSample theSample(tp.et(), tp.fgvb(), tp.ttf());
+
+  EcalTrigTowerDetId idtt(2, EcalBarrel, etaTT, phiTT, 0);
+  EcalTriggerPrimitiveDigi thePrimitive(idtt);
+  thePrimitive.setSize(1);                          // hard coded
+  thePrimitive.setSample(0, theSample);
 
+  tpcollection.push_back(thePrimitive);
+
+  LogDebug("EcalTB07RawToDigiTpg") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"
+				 << "tower: " << (i+1)
+				 << " primitive: " << tp.et()
+				 << " flag: " << tp.fgvb();
+
+  LogDebug("EcalTB07RawToDigiTpg") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"<<
+    "tower: " << (i+1) << " flag: " << tp.ttf();
+}
+
+
+
+void EcalTB07DaqFormatter::fillExpectedTowers(short * TowerStatus)
+{
     // note: these are the tower statuses handled at the moment - to be completed
     // staus==0:   tower expected;
     // staus==9:   Synk error LV1, tower expected;
     // staus==10:  Synk error BX, tower expected;
     // status==1, 2, 3, 4, 5:  tower not expected
-    for (int u=1; u< (kTriggerTowersAndMem+1); u++)
-      {
-	// map status array to expected tower array
-	//int towerMap[kTriggerTowersAndMem+1];
-	//for (int i=0; i<kTriggerTowersAndMem; ++i ) towerMap[i] = i;
-	//towerMap[1] = 6;
-	//towerMap[2] = 2;
-	//towerMap[3] = 1;
-	//towerMap[4] = 5;
-
-	if(   TowerStatus[u] ==0 || TowerStatus[u] ==9 || TowerStatus[u] ==10  ) 
-	  {_ExpectedTowers[_expTowersIndex]= tbStatusToLocation_[u];
-	    _expTowersIndex++;
-	    _numExpectedTowers++;
-	  }
-      }
+    // the expected towers are taken in status order, at their location (tbStatusToLocation)
+    towerStatus_.fill(TowerStatus);
+
     // resetting counter of expected towers
     _expTowersIndex=0;
-      
-      
-    // if number of dccEventBlocks NOT same as expected stop
-    if (!      (dccTowerBlocks.size() == _numExpectedTowers)      )
-      {
-        // we probably always want to know if this happens
-        edm::LogWarning("EcalTB07RawToDigiNumTowerBlocks") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
-				      << "number of TowerBlocks found (" << dccTowerBlocks.size()
-				      << ") differs from expected (" << _numExpectedTowers 
-				      << ") skipping event"; 
-
-        EBDetId idsm(1, 1);
-        dccsizecollection.push_back(idsm);
-	
-	return;
-	
       }
       
 
 
-
-
-    // Access the Tower block    
-    for( std::vector< DCCTBTowerBlock * >::iterator itTowerBlock = dccTowerBlocks.begin(); 
-         itTowerBlock!= dccTowerBlocks.end(); 
-         itTowerBlock++){
-
-      tower=(*itTowerBlock)->towerID();
+// checks that the tower found in data is the expected one, otherwise reports it and skips the tower
+bool EcalTB07DaqFormatter::checkTowerId(unsigned tower, int hardwareId,
+					EcalElectronicsIdCollection & ttidcollection,
+					EcalElectronicsIdCollection & memttidcollection)
+{
       // here is "correct" h2 map
       //if ( tower == 1  ) tower = 6;
       //if ( tower == 71 ) tower = 2;
       //if ( tower == 80 ) tower = 1;
       //if ( tower == 45 ) tower = 5;
-      tower = tbTowerIDToLocation_[tower];
-
-      // checking if tt in data is the same as tt expected 
-      // else skip tower and increment problem counter
 	    
       // dccId set to 46 in order to match 'real' CMS positio at H2
 
-      EcalElectronicsId idtt(46, _ExpectedTowers[_expTowersIndex], 1, 1);
+      EcalElectronicsId idtt(46, towerStatus_.location(_expTowersIndex), 1, 1);
     
 
-      if (  !(tower == _ExpectedTowers[_expTowersIndex])	  )
+      if (  !(tower == towerStatus_.location(_expTowersIndex))	  )
         {	
 	  
-	  if (_ExpectedTowers[_expTowersIndex] <= 68){
-	    edm::LogWarning("EcalTB07RawToDigiTowerId") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"
+	  if (towerStatus_.location(_expTowersIndex) <= 68){
+	    if (warnings_.report(EcalTBWarningAggregator::TOWERID, tower))
+	      edm::LogWarning("EcalTB07RawToDigiTowerId") << "@SUBS=EcalTB07DaqFormatter::interpretRawData"
 							<< "TTower id found (=" << tower 
-							<< ") different from expected (=" <<  _ExpectedTowers[_expTowersIndex] 
+							<< ") different from expected (=" <<  towerStatus_.location(_expTowersIndex) 
 							<< ") " << (_expTowersIndex+1) << "-th tower checked"
-							<< "\n Real hardware id is " << (*itTowerBlock)->towerID();
+							<< "\n Real hardware id is " << hardwareId;
 
 	    //  report on failed tt_id for regular tower block
 	    ttidcollection.push_back(idtt);
 	  }
 	  else
 	    {
-	      edm::LogWarning("EcalTB07RawToDigiTowerId") << "@SUB=EcalTB07DaqFormatter:interpretRawData"
+	      if (warnings_.report(EcalTBWarningAggregator::TOWERID, tower))
+	        edm::LogWarning("EcalTB07RawToDigiTowerId") << "@SUB=EcalTB07DaqFormatter:interpretRawData"
 							<< "DecodeMEM: tower " << tower  
-							<< " is not the same as expected " << ((int)_ExpectedTowers[_expTowersIndex])
+							<< " is not the same as expected " << ((int)towerStatus_.location(_expTowersIndex))
 							<< " (according to DCC header channel status)";
 	      
 	      // report on failed tt_id for mem tower block
 	      // chosing channel 1 as representative
-	      EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], 1, 1);
+	      EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), 1, 1);
 	      memttidcollection.push_back(id);
 	    }
 
           ++ _expTowersIndex;
-          continue;	
+          return false;
         }// if TT id found  different than expected 
 	
-
-
-      /*********************************
-       //    tt: 1 ... 68: crystal data
-       *********************************/
-      if (  0<  (*itTowerBlock)->towerID() &&
-	    ((*itTowerBlock)->towerID() < (kTriggerTowers+1)  || 
-	     (*itTowerBlock)->towerID() == 71 || 
-	     (*itTowerBlock)->towerID() == 80)
-	    )
-	{
-	  
-	  std::vector<DCCTBXtalBlock * > & xtalDataBlocks = (*itTowerBlock)->xtalBlocks();	
-	  
-	  // if there is no zero suppression, tower block must have have 25 channels in it
-	  if (  (!dataIsSuppressed)   &&   (xtalDataBlocks.size() != kChannelsPerTower)   )
-	    {     
-	      edm::LogWarning("EcalTB07RawToDigiTowerSize") << "EcalTB07DaqFormatter::interpretRawData, no zero suppression "
-					    << "wrong tower block size is: "  << xtalDataBlocks.size() 
-					    << " at LV1 " << (*itEventBlock)->getDataField("LV1")
-					    << " for TT " << _ExpectedTowers[_expTowersIndex];
-	      // report on wrong tt block size
-	      blocksizecollection.push_back(idtt);
-
-	      ++ _expTowersIndex; 	      continue;	
-
+      return true;
 	    }
 	  
 
-	  short cryInTower =0;
-
-	  short expStripInTower;
-	  short expCryInStrip;
-	  short expCryInTower =0;
-
-	  // Access the Xstal data
-	  for( std::vector< DCCTBXtalBlock * >::iterator itXtalBlock = xtalDataBlocks.begin(); 
-	       itXtalBlock!= xtalDataBlocks.end(); 
-	       itXtalBlock++){ //loop on crys of a  tower
 
-	    strip              =(*itXtalBlock)->stripID();
-	    ch                 =(*itXtalBlock)->xtalID();
-	    cryInTower  =(strip-1)* kChannelsPerCard + (ch -1);
+// checks the strip and channel ids of a crystal, reporting the wrong ones:
+// returns false if the crystal must not go to the Event (expCryInTower is updated)
+bool EcalTB07DaqFormatter::checkXtalId(unsigned tower, int strip, int ch, bool dataIsSuppressed,
+				       short & expCryInTower, int lv1, EBDetIdCollection & chidcollection)
+{
+	    short cryInTower  =(strip-1)* kChannelsPerCard + (ch -1);
 
-	    expStripInTower   =  expCryInTower/5 +1;
-	    expCryInStrip     =  expCryInTower%5 +1;
+	    short expStripInTower   =  expCryInTower/5 +1;
+	    short expCryInStrip     =  expCryInTower%5 +1;
 	    
 	    
 	    // FIXME: waiting for geometry to do (TT, strip,chNum) <--> (SMChId)
-	    // short abscissa = (_ExpectedTowers[_expTowersIndex]-1)  /4;
-	    // short ordinate = (_ExpectedTowers[_expTowersIndex]-1)  %4;
+	    // short abscissa = (towerStatus_.location(_expTowersIndex)-1)  /4;
+	    // short ordinate = (towerStatus_.location(_expTowersIndex)-1)  %4;
 	    // temporarily choosing central crystal in trigger tower
 	    // int cryIdInSM  = 45 + ordinate*5 + abscissa * 100;
 	    
@@ -431,14 +715,15 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		      }
 		    }
 		    
-		    edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData with zero suppression, "
+		    if (warnings_.report(EcalTBWarningAggregator::CHID, tower, strip, ch))
+		      edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData with zero suppression, "
 							   << " wrong channel id, since out of range: "
 							   << "\t strip: "  << strip  << "\t channel: " << ch
-							   << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-							   << "\t at LV1 : " << (*itEventBlock)->getDataField("LV1");
+							   << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+							   << "\t at LV1 : " << lv1;
 		    
 		    expCryInTower++;
-		    continue;
+		    return false;
 		  }
 
 
@@ -451,13 +736,14 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		// cry_id wrong because of incorrect ordering within trigger tower
 		else
 		  {
-		    edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData with zero suppression, "
+		    if (warnings_.report(EcalTBWarningAggregator::CHID, tower, strip, ch))
+		      edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData with zero suppression, "
 						  << " based on ch ordering within tt, wrong channel id: "
 						  << "\t strip: "  << strip  << "\t channel: " << ch
 						  << "\t cryInTower "  << cryInTower
 						  << "\t expCryInTower: " << expCryInTower
-						  << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-						  << "\t at LV1: " << (*itEventBlock)->getDataField("LV1");
+						  << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+						  << "\t at LV1: " << lv1;
 		    
 		    int  sm = 1; // hardcoded because of test  beam
 		    for (int StripInTower_ =1;  StripInTower_ < 6; StripInTower_++){
@@ -469,7 +755,7 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		    }
 		    
 		    // chennel with id which does not follow correct odering
-		    expCryInTower++;		    continue;
+		    expCryInTower++;		    return false;
 		    
 		  }// end 'ch_id does not respect growing order'
 		
@@ -489,11 +775,12 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		  int  sm = 1; // hardcoded because of test  beam
 		  EBDetId  idExp(sm, ic,1);
 		  
-		  edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData no zero suppression "
+		  if (warnings_.report(EcalTBWarningAggregator::CHID, tower, expStripInTower, expCryInStrip))
+		    edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData no zero suppression "
 						    << " wrong channel id for channel: "  << expCryInStrip
 						    << "\t strip: " << expStripInTower
-						    << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-						    << "\t at LV1: " << (*itEventBlock)->getDataField("LV1")
+						    << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+						    << "\t at LV1: " << lv1
 						    << "\t   (in the data, found channel:  " << ch
 						    << "\t strip:  " << strip << " ).";
 
@@ -502,7 +789,7 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		  chidcollection.push_back(idExp);
 
 		  // there has been unexpected crystal id, dataframe not to go to the Event
-		  expCryInTower++; 		  continue;
+		  expCryInTower++; 		  return false;
 		  
 		} // if channel in data does not equal expected channel
 
@@ -510,180 +797,174 @@ void EcalTB07DaqFormatter::interpretRawData(const FEDRawData & fedData ,
 
 	    } // end 'not zero suppression'
 	    
+	    return true;
+}
 	    
 	    
+
+// puts the EB and EE data frames of a crystal in the Event, unless a sample has gain==0
+// or there is a forbidden gain transition (gainZero and numbGainSwitches as given by DCCTBGainCheck)
+template <class SAMPLE>
+void EcalTB07DaqFormatter::fillXtalDigi(unsigned tower, int strip, int ch, short expStripInTower, short expCryInStrip,
+					const SAMPLE * xtalDataSamples, unsigned numbSamples,
+					bool gainZero, unsigned numbGainSwitches, int lv1,
+					EBDigiCollection& digicollection, EEDigiCollection& eeDigiCollection,
+					EBDetIdCollection & gaincollection, EBDetIdCollection & gainswitchcollection)
+{
 	    // data  to be stored in EBDataFrame, identified by EBDetId
-	    int  ic = cryIc(tower, strip, ch) ;
-	    int  sm = 1;
-	    EBDetId  id(sm, ic,1);      
+	    // (also the id of the integrity collections)
+	    EBDetId  id = ebDetId(tower, strip, ch);
 	    // EE data to be stored in EEDataFrame, identified by EEDetId
-	    // eeId(int i, int j, int iz (+1/-1), int mode = XYMODE)
-	    int ix = getEE_ix(tower, strip, ch);
-	    int iy = getEE_iy(tower, strip, ch);
-
-	    int iz = 1;
-	    if ( tbName_ == "h4" ) iz = -1;
-	    EEDetId  eeId(ix, iy, iz);
-	        
-            // here data frame go into the Event
-            // removed later on (with a pop_back()) if gain==0 or if forbidden-gain-switch
-            digicollection.push_back( id );
-            eeDigiCollection.push_back( eeId );
-            EBDataFrame theFrame ( digicollection.back() );
-            EEDataFrame eeFrame ( eeDigiCollection.back() );
-
-	    std::vector<int> xtalDataSamples = (*itXtalBlock)->xtalDataSamples();   
-	    //theFrame.setSize(xtalDataSamples.size()); // if needed, to be changed when constructing digicollection
-	    //eeFrame. setSize(xtalDataSamples.size()); // if needed, to be changed when constructing eeDigicollection
-      
-
-	    // gain cannot be 0, checking for that
-	    bool        gainIsOk =true;
-	    unsigned gain_mask      = 12288;    //12th and 13th bit
-	    std::vector <int> xtalGain;
-
-	    for (unsigned short i=0; i<xtalDataSamples.size(); ++i ) {
-	      
-	      theFrame.setSample (i, xtalDataSamples[i] );
-	      eeFrame .setSample (i, xtalDataSamples[i] );
-	      
-	      if((xtalDataSamples[i] & gain_mask) == 0){gainIsOk =false;}
-	      
-	      xtalGain.push_back(0);
-	      xtalGain[i] |= (xtalDataSamples[i] >> 12);
-	    }
+	    EEDetId  eeId;
+	    if (produceEE_) eeId = eeDetId(tower, strip, ch);
 	    
-	    if (! gainIsOk) {
+	    // gain cannot be 0
+	    if (gainZero) {
 	      
-	      edm::LogWarning("EcalTB07RawToDigiGainZero") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+	      if (warnings_.report(EcalTBWarningAggregator::GAINZERO, tower, expStripInTower, expCryInStrip))
+	        edm::LogWarning("EcalTB07RawToDigiGainZero") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
 					    << " gain==0 for strip: "  << expStripInTower
 					    << "\t channel: " << expCryInStrip
-					    << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-					    << "\t ic: " << ic
-					    << "\t at LV1: " << (*itEventBlock)->getDataField("LV1");
+					    << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+					    << "\t ic: " << cryIc(tower, strip, ch)
+					    << "\t at LV1: " << lv1;
 	      // report on gain==0
 	      gaincollection.push_back(id);
 	      
 	      // there has been a gain==0, dataframe not to go to the Event
-              digicollection.pop_back();
-              eeDigiCollection.pop_back();
-	      continue; //	      expCryInTower already incremented
+	      return; //	      expCryInTower already incremented
 	    }
 
 
 	    
 	    
-	    // looking for forbidden gain transitions
+	    // reporting forbidden gain transitions (gain is the sample >> 12)
 	    
 	    short firstGainWrong=-1;
-	    short numGainWrong=0;
 	    
-	    for (unsigned short i=0; i<xtalGain.size(); i++ ) {
+	    for (unsigned short i=1; numbGainSwitches>0 && i<numbSamples; i++ ) {
 	      
-	      if (i>0 && xtalGain[i-1]>xtalGain[i]) {
-		
-		numGainWrong++;// counting forbidden gain transitions
+	      int lastGain = xtalDataSamples[i-1] >> 12;
+	      int gain     = xtalDataSamples[i]   >> 12;
+
+	      if (lastGain>gain) {
 		
 		if (firstGainWrong == -1) {
 		  firstGainWrong=i;
-		  edm::LogWarning("EcalTB07RawToDigiGainSwitch") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+		  if (warnings_.report(EcalTBWarningAggregator::GAINSWITCH, tower, strip, ch))
+		    edm::LogWarning("EcalTB07RawToDigiGainSwitch") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
 							  << "channelHasGainSwitchProblem: crystal eta = " 
 							  << id.ieta() << " phi = " << id.iphi();
 		}
-		edm::LogWarning("EcalTB07RawToDigiGainSwitch") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
+		if (warnings_.report(EcalTBWarningAggregator::GAINSWITCH, tower, strip, ch))
+		  edm::LogWarning("EcalTB07RawToDigiGainSwitch") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
 							<< "channelHasGainSwitchProblem: sample = " << (i-1) 
-							<< " gain: " << xtalGain[i-1] << " sample: " 
-							<< i << " gain: " << xtalGain[i];
+							<< " gain: " << lastGain << " sample: "
+							<< i << " gain: " << gain;
 	      }
 	    }
 
-	    if (numGainWrong>0) {
+	    if (numbGainSwitches>0) {
 	      gainswitchcollection.push_back(id);
 
-	      edm::LogWarning("EcalTB07RawToDigiGainSwitch") << "@SUB=EcalTB07DaqFormatter:interpretRawData"
+	      if (warnings_.report(EcalTBWarningAggregator::GAINSWITCH, tower, strip, ch))
+	        edm::LogWarning("EcalTB07RawToDigiGainSwitch") << "@SUB=EcalTB07DaqFormatter:interpretRawData"
 							<< "channelHasGainSwitchProblem: more than 1 wrong transition";
 		
-	      for (unsigned short i1=0; i1<xtalDataSamples.size(); ++i1 ) {
+	      for (unsigned short i1=0; i1<numbSamples; ++i1 ) {
 		int countADC = 0x00000FFF;
 		countADC &= xtalDataSamples[i1];
-		LogDebug("EcalTB07RawToDigi") << "Sample " << i1 << " ADC " << countADC << " Gain " << xtalGain[i1];
+		LogDebug("EcalTB07RawToDigi") << "Sample " << i1 << " ADC " << countADC << " Gain " << (xtalDataSamples[i1] >> 12);
 	      }
 
 	      // there has been a forbidden gain transition,  dataframe not to go to the Event
-              digicollection.pop_back();
-              eeDigiCollection.pop_back();
-	      continue; //	      expCryInTower already incremented
+	      return; //	      expCryInTower already incremented
 
 	    }// END of:   'if there is a forbidden gain transition'
 
-	  }// end loop on crystals within a tower block
+
+            // here data frame go into the Event, once the samples are checked
+            // (only into the digi collections produced, see setDigiProduction)
+	    if (produceEB_) {
+	      digicollection.push_back( id );
+	      EBDataFrame theFrame ( digicollection.back() );
+	      for (unsigned short i=0; i<numbSamples; ++i )
+		theFrame.setSample (i, xtalDataSamples[i] );
+	    }
+
+	    if (produceEE_) {
+	      eeDigiCollection.push_back( eeId );
+	      EEDataFrame eeFrame ( eeDigiCollection.back() );
+	      for (unsigned short i=0; i<numbSamples; ++i )
+		eeFrame .setSample (i, xtalDataSamples[i] );
+	    }
+}
+
 	  
-	  _expTowersIndex++;
-	}// end: tt1 ... tt68, crystal data
       
 
 
       
       
-      /******************************************************************
-       //    tt 69 and 70:  two mem boxes, holding PN0 ... PN9
-       ******************************************************************/	
-      else if (       (*itTowerBlock)->towerID() == 69 
-                      ||	   (*itTowerBlock)->towerID() == 70       )	
-	{
-	  
-	  LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter::interpretRawData"
-				      << "processing mem box num: " << (*itTowerBlock)->towerID();
 
-	  // if tt 69 or 70 found, allocate Pn digi collection
-	  if(! pnAllocated) 
+void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeDigiCollection & pndigicollection ,
+				    EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
+				    EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection)
 	    {
-	      pndigicollection.reserve(kPns);
-	      pnAllocated = true;
-	    }
-
-	  DecodeMEM( (*itTowerBlock),  pndigicollection , 
-		     memttidcollection,  memblocksizecollection,
-		     memgaincollection,  memchidcollection);
-	  
-	}// end of < if it is a mem box>
       
+  LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter::DecodeMEM"
+ 			      << "in mem " << towerblock->towerID();  
       
+  int  tower_id = towerblock ->towerID() ;
     
+  /******************************************************************************
+   // getting the raw hits from towerBlock while checking tt and ch data structure 
+   ******************************************************************************/
+  std::vector<DCCTBXtalBlock *> & dccXtalBlocks = towerblock->xtalBlocks();
+  std::vector<DCCTBXtalBlock*>::iterator itXtal;
 
+  if ( ! startMEM(tower_id, dccXtalBlocks.size(), memblocksizecollection) ) return;
 
-      // wrong tt id
-      else  {
-        edm::LogWarning("EcalTB07RawToDigiTowerId") <<"@SUB=EcalTB07DaqFormatter::interpretRawData"
-				      << " processing tt with ID not existing ( "
-				      <<  (*itTowerBlock)->towerID() << ")";
-        ++ _expTowersIndex;
-	continue; 
-      }// end: tt id error
+  // loop on channels of the mem block
+  int  cryCounter = 0;
 
-    }// end loop on trigger towers
+  for ( itXtal = dccXtalBlocks.begin(); itXtal < dccXtalBlocks.end(); itXtal++ ) {
+    unsigned numbSamples = (*itXtal)->xtalDataSamples(&xtalSamples_[0]);
+    storeMemXtal(tower_id, cryCounter,
+		 (*itXtal) ->getDataField(DCCTBDataMapper::STRIPID_ID), (*itXtal) ->getDataField(DCCTBDataMapper::XTALID_ID),
+		 &xtalSamples_[0], numbSamples, memchidcollection);
+    cryCounter++;
+  }// end loop on crystals of mem dccXtalBlock
       
-  }// end loop on events
+  unpackPn(tower_id, pndigicollection, memgaincollection, memchidcollection);
 }
 
 
 
+void EcalTB07DaqFormatter::DecodeMEM( DCCTBEventSoA * event, unsigned t, EcalPnDiodeDigiCollection & pndigicollection ,
+				    EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
+				    EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection)
+{
 
+  LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter::DecodeMEM"
+ 			      << "in mem " << event->towerID(t);
 
+  int  tower_id = event->towerID(t);
 
+  if ( ! startMEM(tower_id, event->numbXtals(t), memblocksizecollection) ) return;
 
+  for (unsigned c=0; c < event->numbXtals(t); c++)
+    storeMemXtal(tower_id, c, event->stripID(t, c), event->xtalID(t, c),
+		 event->xtalDataSamples(t, c), event->numbXtalSamples(), memchidcollection);
 
-void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeDigiCollection & pndigicollection ,
-				    EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
-				    EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection)
-{
+  unpackPn(tower_id, pndigicollection, memgaincollection, memchidcollection);
+}
   
-  LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter::DecodeMEM"
- 			      << "in mem " << towerblock->towerID();  
   
-  int  tower_id = towerblock ->towerID() ;
-  int  mem_id   = tower_id-69;
 
+// resets the mem raw samples and checks the mem tower block: returns false if no Pn digi is to be built
+bool EcalTB07DaqFormatter::startMEM(int tower_id, unsigned numbXtals, EcalElectronicsIdCollection &  memblocksizecollection)
+{
   // initializing container
   for (int st_id=0; st_id< kStripsPerTower; st_id++){
     for (int ch_id=0; ch_id<kChannelsPerStrip; ch_id++){
@@ -694,42 +975,40 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
   // check that tower block id corresponds to mem boxes
   if(tower_id != 69 && tower_id != 70) 
     {
-      edm::LogWarning("EcalTB07RawToDigiTowerId") << "@SUB=EcalTB07DaqFormatter:decodeMem"
+      if (warnings_.report(EcalTBWarningAggregator::TOWERID, tower_id))
+        edm::LogWarning("EcalTB07RawToDigiTowerId") << "@SUB=EcalTB07DaqFormatter:decodeMem"
 				    << "DecodeMEM: this is not a mem box tower (" << tower_id << ")";
       ++ _expTowersIndex;
-      return;
+      return false;
     }
 
-     
-  /******************************************************************************
-   // getting the raw hits from towerBlock while checking tt and ch data structure 
-   ******************************************************************************/
-  std::vector<DCCTBXtalBlock *> & dccXtalBlocks = towerblock->xtalBlocks();
-  std::vector<DCCTBXtalBlock*>::iterator itXtal;
-
   // checking mem tower block fo size
-  if (dccXtalBlocks.size() != kChannelsPerTower)
+  if (numbXtals != kChannelsPerTower)
     {     
       LogDebug("EcalTB07RawToDigiDccBlockSize") << "@SUB=EcalTB07DaqFormatter:decodeMem"
-				  << " wrong dccBlock size, namely: "  << dccXtalBlocks.size() 
-				  << ", for mem " << _ExpectedTowers[_expTowersIndex];
+				  << " wrong dccBlock size, namely: "  << numbXtals
+				  << ", for mem " << towerStatus_.location(_expTowersIndex);
 
       // reporting mem-tt block size problem
       // chosing channel 1 as representative as a dummy...
-      EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], 1, 1);
+      EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), 1, 1);
       memblocksizecollection.push_back(id);
 
       ++ _expTowersIndex;
-      return;  // if mem tt block size not ok - do not build any Pn digis
+      return false;  // if mem tt block size not ok - do not build any Pn digis
     }
   
+  return true;
+}
 
-  // loop on channels of the mem block
-  int  cryCounter = 0;   int  strip_id  = 0;   int  xtal_id   = 0;  
 
-  for ( itXtal = dccXtalBlocks.begin(); itXtal < dccXtalBlocks.end(); itXtal++ ) {
-    strip_id                     = (*itXtal) ->getDataField("STRIP ID");
-    xtal_id                      = (*itXtal) ->getDataField("XTAL ID");
+
+// checks the ids of the cryCounter-th channel of the mem block and stores its samples
+template <class SAMPLE>
+void EcalTB07DaqFormatter::storeMemXtal(int tower_id, int cryCounter, int strip_id, int xtal_id,
+					const SAMPLE * xtalDataSamples, unsigned numbSamples,
+					EcalElectronicsIdCollection & memchidcollection)
+{
     int wished_strip_id  = cryCounter/ kStripsPerTower;
     int wished_ch_id     = cryCounter% kStripsPerTower;
     
@@ -738,31 +1017,30 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
       {
 	
 	LogDebug("EcalTB07RawToDigiChId") << "@SUB=EcalTB07DaqFormatter:decodeMem"
-				    << " in mem " <<  towerblock->towerID()
+				    << " in mem " <<  tower_id
 				    << ", expected:\t strip"
 				    << (wished_strip_id+1)  << " cry " << (wished_ch_id+1) << "\tfound: "
 				    << "  strip " <<  strip_id << "  cry " << xtal_id;
 	
 	// report on crystal with unexpected indices
-	EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], wished_strip_id,  wished_ch_id);
+	EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), wished_strip_id,  wished_ch_id);
 	memchidcollection.push_back(id);
+	flagMemChannel(id);
       }
     
     
     // Accessing the 10 time samples per Xtal:
-    memRawSample_[wished_strip_id][wished_ch_id][1] = (*itXtal)->getDataField("ADC#1");
-    memRawSample_[wished_strip_id][wished_ch_id][2] = (*itXtal)->getDataField("ADC#2");
-    memRawSample_[wished_strip_id][wished_ch_id][3] = (*itXtal)->getDataField("ADC#3");
-    memRawSample_[wished_strip_id][wished_ch_id][4] = (*itXtal)->getDataField("ADC#4");
-    memRawSample_[wished_strip_id][wished_ch_id][5] = (*itXtal)->getDataField("ADC#5");
-    memRawSample_[wished_strip_id][wished_ch_id][6] = (*itXtal)->getDataField("ADC#6");
-    memRawSample_[wished_strip_id][wished_ch_id][7] = (*itXtal)->getDataField("ADC#7");
-    memRawSample_[wished_strip_id][wished_ch_id][8] = (*itXtal)->getDataField("ADC#8");
-    memRawSample_[wished_strip_id][wished_ch_id][9] = (*itXtal)->getDataField("ADC#9");
-    memRawSample_[wished_strip_id][wished_ch_id][10] = (*itXtal)->getDataField("ADC#10");
+    for (int sample=1; sample<=kSamplesPerChannel && sample<=(int)numbSamples; sample++)
+      memRawSample_[wished_strip_id][wished_ch_id][sample] = xtalDataSamples[sample-1];
+}
       
-    cryCounter++;
-  }// end loop on crystals of mem dccXtalBlock
+
+
+// unpacks the PN samples of the mem box from the stored raw samples and builds the Pn digis
+void EcalTB07DaqFormatter::unpackPn(int tower_id, EcalPnDiodeDigiCollection & pndigicollection,
+				    EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection)
+{
+  int  mem_id   = tower_id-69;
   
   // tower accepted and digi read from all 25 channels.
   // Increase counter of expected towers before unpacking in the 5 PNs
@@ -773,13 +1051,10 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
   /************************************************************
    // unpacking and 'cooking' the raw numbers to get PN sample
    ************************************************************/
-  int tempSample=0;
+  // every sample of the mem box is written below (-1 if its gain is wrong): no reset of data_MEM
   int memStoreIndex=0;
   int ipn=0;
-  for (memStoreIndex=0; memStoreIndex<500; memStoreIndex++)    {
-    data_MEM[memStoreIndex]= -1;   }
-  
-  
+
   for(int strip=0; strip<kStripsPerTower; strip++) {// loop on strips
     for(int channel=0; channel<kChannelsPerStrip; channel++) {// loop on channels
 
@@ -788,38 +1063,31 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
       else 
 	{ipn=mem_id*5+4-channel;}
 
+      // 1) if strip number is even, 14 bits are reversed in order
+      bool reversed = (strip%2 == 1);
+
       for(int sample=0;sample< kSamplesPerChannel ;sample++) {
-	tempSample= memRawSample_[strip][channel][sample+1];
-
-	int new_data=0;
-	if(strip%2 == 1) {
-	  // 1) if strip number is even, 14 bits are reversed in order
-	  for(int ib=0;ib<14;ib++)
-	    { 
-	      new_data <<= 1;
-	      new_data=new_data | (tempSample&1);
-	      tempSample >>= 1;
-	    }
-	} else {
-	  new_data=tempSample;
-	}
 
 	// 2) flip 11th bit for AD9052 still there on MEM !
-	// 3) mask with 1 1111 1111 1111
-	new_data = (new_data ^ 0x800) & 0x3fff;    // (new_data  XOR 1000 0000 0000) & 11 1111 1111 1111
-	// new_data = (new_data ^ 0x800) & 0x1fff;    // (new_data  XOR 1000 0000 0000) & 1 1111 1111 1111
+	// 3) mask with 11 1111 1111 1111
+	int new_data = DCCTBPnSample::decode(memRawSample_[strip][channel][sample+1], reversed);
+	memStoreIndex= ipn*50+strip*kSamplesPerChannel+sample;
 
 	//(Bit 12) == 1 -> Gain 16;    (Bit 12) == 0 -> Gain 1	
 	// gain in mem can be 1 or 16 encoded resp. with 0 ir 1 in the 13th bit.
 	// checking and reporting if there is any sample with gain==2,3
-	short sampleGain = (new_data &0x3000)/4096;
+	short sampleGain = DCCTBPnSample::gain(new_data);
 	if (  sampleGain==2 || sampleGain==3) 
 	  {
-	    EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], strip, channel);
+	    data_MEM[memStoreIndex]= -1;
+
+	    EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), strip, channel);
 	    memgaincollection.push_back(id);
+	    flagMemChannel(id);
 	    
-	    edm::LogWarning("EcalTB07RawToDigiGainZero")  << "@SUB=EcalTB07DaqFormatter:decodeMem"
-					   << "in mem " <<  towerblock->towerID()
+	    if (warnings_.report(EcalTBWarningAggregator::GAINZERO, tower_id, strip+1, channel+1))
+	      edm::LogWarning("EcalTB07RawToDigiGainZero")  << "@SUB=EcalTB07DaqFormatter:decodeMem"
+					   << "in mem " <<  tower_id
 					   << " :\t strip: "
 					   << (strip +1)  << " cry: " << (channel+1) 
 					   << " has 14th bit non zero! Gain results: "
@@ -828,9 +1096,8 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
 	    continue;
 	  }// end 'if gain is zero'
 
-	memStoreIndex= ipn*50+strip*kSamplesPerChannel+sample;
 	// storing in data_MEM also the gain bits
-	data_MEM[memStoreIndex]= new_data & 0x3fff;
+	data_MEM[memStoreIndex]= new_data;
 
       }// loop on samples
     }// loop on strips
@@ -839,29 +1106,9 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
 
 
 
-  for (int pnId=0; pnId<kPnPerTowerBlock; pnId++) pnIsOkInBlock[pnId]=true;
   // if anything was wrong with mem_tt_id or mem_tt_size: you would have already exited
   // otherwise, if any problem with ch_gain or ch_id: must not produce digis for the pertaining Pn
-
-  if (!      (memgaincollection.size()==0 && memchidcollection.size()==0)          )
-    {
-      for ( EcalElectronicsIdCollection::const_iterator idItr = memgaincollection.begin();
-	    idItr != memgaincollection.end();
-	    ++ idItr ) {
-	int ch = (*idItr).channelId();
-	ch = (ch-1)/5;
-	pnIsOkInBlock [ch] = false;
-      }
-
-      for ( EcalElectronicsIdCollection::const_iterator idItr = memchidcollection.begin();
-	    idItr != memchidcollection.end();
-	    ++ idItr ) {
-	int ch = (*idItr).channelId();
-	ch = (ch-1)/5;
-	pnIsOkInBlock [ch] = false;
-      }
-
-    }// end: if any ch_gain or ch_id problems exclude the Pn's from digi production
+  // (memChannelErrors_ has one bit per Pn with a channel in memgaincollection or memchidcollection)
 
 
 
@@ -870,7 +1117,7 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
   for (int pnId = 1;  pnId <  (kPnPerTowerBlock+1); pnId++){
 
     // if present Pn has any of its 5 channels with problems, do not produce digi for it
-    if (! pnIsOkInBlock [pnId-1] ) continue;
+    if ( memChannelErrors_ & (1 << (pnId-1)) ) continue;
 
     // second argument is DccId which is set to 46 to match h2 data in global CMS geometry
     EcalPnDiodeDetId PnId(2, 46, pnId +  kPnPerTowerBlock*mem_id);
@@ -890,6 +1137,25 @@ void EcalTB07DaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiod
 }
 
 
+// marks the Pn of a mem channel error: pnId-1 is (channelId-1)/5 of the channel reported
+void EcalTB07DaqFormatter::flagMemChannel(const EcalElectronicsId & id)
+{
+  int pn = (id.channelId()-1)/5;
+  if (pn >= 0 && pn < kPnPerTowerBlock) memChannelErrors_ |= (1 << pn);
+}
+
+
+
+void EcalTB07DaqFormatter::flagMemChannels(const EcalElectronicsIdCollection & idcollection)
+{
+  for ( EcalElectronicsIdCollection::const_iterator idItr = idcollection.begin();
+	idItr != idcollection.end();
+	++ idItr )
+    flagMemChannel(*idItr);
+}
+
+
+
 std::pair<int,int>  EcalTB07DaqFormatter::cellIndex(int tower_id, int strip, int ch) {
   
   int xtal= (strip-1)*5+ch-1;
@@ -946,11 +1212,61 @@ int EcalTB07DaqFormatter::getEE_iy(int tower, int strip, int ch){
   return iy;
 }
 
+void EcalTB07DaqFormatter::buildDetIdTables(){
+
+  int sm = 1;
+  int iz = 1;
+  if ( tbName_ == "h4" ) iz = -1;
+
+  for (int tower=1; tower<=68; tower++)
+    for (int strip=1; strip<=5; strip++)
+      for (int ch=1; ch<=5; ch++) {
+
+	int ic = cryIcMap_[tower-1][strip-1][ch-1];
+	if ( 1 <= ic && ic <= kCrystals ) ebDetIds_[tower-1][strip-1][ch-1] = EBDetId(sm, ic, 1);
+
+	// eeId(int i, int j, int iz (+1/-1), int mode = XYMODE)
+	int ix = getEE_ix(tower, strip, ch);
+	int iy = getEE_iy(tower, strip, ch);
+	if ( EEDetId::validDetId(ix, iy, iz) ) eeDetIds_[tower-1][strip-1][ch-1] = EEDetId(ix, iy, iz);
+      }
+}
+
+// the tables cover towers 1-68: other ids (e.g. hardware ids out of the map) go
+// through cryIc, which reports them as it did before the tables
+static bool inDetIdTables(int tower, int strip, int ch){
+  return 1 <= tower && tower <= 68 && 1 <= strip && strip <= 5 && 1 <= ch && ch <= 5;
+}
+
+EBDetId EcalTB07DaqFormatter::ebDetId(int tower, int strip, int ch){
+
+  if ( inDetIdTables(tower, strip, ch) ) {
+    const EBDetId & id = ebDetIds_[tower-1][strip-1][ch-1];
+    if ( id.rawId() ) return id;
+  }
+
+  int sm = 1;
+  return EBDetId(sm, cryIc(tower, strip, ch), 1);
+}
+
+EEDetId EcalTB07DaqFormatter::eeDetId(int tower, int strip, int ch){
+
+  if ( inDetIdTables(tower, strip, ch) ) {
+    const EEDetId & id = eeDetIds_[tower-1][strip-1][ch-1];
+    if ( id.rawId() ) return id;
+  }
+
+  int iz = 1;
+  if ( tbName_ == "h4" ) iz = -1;
+  return EEDetId(getEE_ix(tower, strip, ch), getEE_iy(tower, strip, ch), iz);
+}
+
 int  EcalTB07DaqFormatter::cryIc(int tower, int strip, int ch) {
 
-  if ( strip < 1 || 5<strip || ch <1 || 5 < ch || 68<tower)
+  if ( strip < 1 || 5<strip || ch <1 || 5 < ch || tower < 1 || 68<tower)
     {
-      edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData (cryIc) "
+      if (warnings_.report(EcalTBWarningAggregator::CHID, tower, strip, ch))
+        edm::LogWarning("EcalTB07RawToDigiChId") << "EcalTB07DaqFormatter::interpretRawData (cryIc) "
 					     << " wrong channel id, since out of range: "
 					     << "\t strip: "  << strip  << "\t channel: " << ch
 					     << "\t in TT: " << tower;
@@ -13,7 +13,12 @@
 #include <DataFormats/EcalDigi/interface/EcalDigiCollections.h>
 #include <DataFormats/EcalRawData/interface/EcalRawDataCollections.h>
 #include <DataFormats/EcalDetId/interface/EcalDetIdCollections.h>
+#include <DataFormats/EcalDetId/interface/EBDetId.h>
+#include <DataFormats/EcalDetId/interface/EEDetId.h>
 #include "DCCTowerBlock.h"
+#include "DCCTriggerPrimitive.h"
+#include "DCCTowerStatus.h"
+#include "EcalTBWarningAggregator.h"
 
 #include <vector> 
 #include <map>
@@ -26,12 +31,18 @@
 
 class FEDRawData;
 class DCCDataParser;
+class DCCTBEventSoA;
+class DCCTBParseContext;
 class EcalTB07DaqFormatter   {
 
  public:
 
-  EcalTB07DaqFormatter(std::string tbName, int a[68][5][5], int b[71], int c[201]);
-  virtual ~EcalTB07DaqFormatter(){LogDebug("EcalTB07RawToDigi") << "@SUB=EcalTB07DaqFormatter" << "\n"; };
+  /// parserParameters: see DCCTBDataParser (DCCTBDataParser::defaultParameters for the test beam DCC)
+  EcalTB07DaqFormatter(std::string tbName, int a[68][5][5], int b[71], int c[201], const std::vector<uint32_t> & parserParameters);
+  virtual ~EcalTB07DaqFormatter();
+
+  /// DCC headers added per DCC event: its header and the copies with ids 4, 5 and 6 (EE region used at h4)
+  enum { kHeadersPerEvent = 4 };
 
   void  interpretRawData( const FEDRawData & data , EBDigiCollection& digicollection , EEDigiCollection& eeDigiCollection, 
 			  EcalPnDiodeDigiCollection & pndigicollection,
@@ -43,13 +54,65 @@ class EcalTB07DaqFormatter   {
 			  EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
 			  EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection,
 			  EcalTrigPrimDigiCollection &tpcollection);
+
+  /**
+     With soaDecoding the DCC data are decoded into flat arrays (DCCTBDataParser::decodeToSoA)
+     and the digis are filled from them, without building the DCC block objects
+  */
+  void setSoADecoding(bool soaDecoding) { soaDecoding_ = soaDecoding; }
+
+  /**
+     Digi collections filled by interpretRawData (both by default): the crystals are
+     not decoded into the EB (EE) digis if produceEB (produceEE) is false
+  */
+  void setDigiProduction(bool produceEB, bool produceEE) { produceEB_ = produceEB; produceEE_ = produceEE; }
+
+  DCCTBDataParser * parser() { return theParser_; }
+
+  /// Counts the warnings of the formatter and limits the ones emitted (see EcalTBWarningAggregator)
+  EcalTBWarningAggregator & warnings() { return warnings_; }
  
 
  private:
   
+  bool  interpretSoAEvent( DCCTBEventSoA * event, EBDigiCollection& digicollection , EEDigiCollection& eeDigiCollection, 
+			   EcalPnDiodeDigiCollection & pndigicollection,
+			   EcalRawDataCollection& DCCheaderCollection,
+			   EBDetIdCollection & dccsizecollection,
+			   EcalElectronicsIdCollection & ttidcollection , EcalElectronicsIdCollection & blocksizecollection,
+			   EBDetIdCollection & chidcollection , EBDetIdCollection & gaincollection,
+			   EBDetIdCollection & gainswitchcollection ,
+			   EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
+			   EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection,
+			   EcalTrigPrimDigiCollection &tpcollection);
+
+  template <class EVENT> bool fillDCCHeader(EVENT * event, EcalRawDataCollection& DCCheaderCollection, short * TowerStatus);
+  void fillTriggerPrimitive(int i, const DCCTBTriggerPrimitive & tp, EcalTrigPrimDigiCollection &tpcollection);
+  void fillExpectedTowers(short * TowerStatus);
+  bool checkTowerId(unsigned tower, int hardwareId,
+		    EcalElectronicsIdCollection & ttidcollection, EcalElectronicsIdCollection & memttidcollection);
+  bool checkXtalId(unsigned tower, int strip, int ch, bool dataIsSuppressed,
+		   short & expCryInTower, int lv1, EBDetIdCollection & chidcollection);
+  template <class SAMPLE> void fillXtalDigi(unsigned tower, int strip, int ch, short expStripInTower, short expCryInStrip,
+					    const SAMPLE * xtalDataSamples, unsigned numbSamples,
+					    bool gainZero, unsigned numbGainSwitches, int lv1,
+					    EBDigiCollection& digicollection, EEDigiCollection& eeDigiCollection,
+					    EBDetIdCollection & gaincollection, EBDetIdCollection & gainswitchcollection);
+
   void  DecodeMEM( DCCTBTowerBlock *  towerblock, EcalPnDiodeDigiCollection & pndigicollection ,
 		   EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
 		   EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection);
+  void  DecodeMEM( DCCTBEventSoA * event, unsigned t, EcalPnDiodeDigiCollection & pndigicollection ,
+		   EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
+		   EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection);
+  bool  startMEM(int tower_id, unsigned numbXtals, EcalElectronicsIdCollection &  memblocksizecollection);
+  template <class SAMPLE> void storeMemXtal(int tower_id, int cryCounter, int strip_id, int xtal_id,
+					    const SAMPLE * xtalDataSamples, unsigned numbSamples,
+					    EcalElectronicsIdCollection & memchidcollection);
+  void  unpackPn(int tower_id, EcalPnDiodeDigiCollection & pndigicollection,
+		 EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection);
+  void  flagMemChannel(const EcalElectronicsId & id);
+  void  flagMemChannels(const EcalElectronicsIdCollection & idcollection);
   
   std::pair<int,int>  cellIndex(int tower_id, int strip, int xtal); 
   int            cryIc(int tower_id, int strip, int xtal); 
@@ -58,14 +121,29 @@ class EcalTB07DaqFormatter   {
 
  private:
   DCCTBDataParser* theParser_;
+  DCCTBParseContext* theContext_;
+  std::vector<uint16_t> xtalSamples_;   // samples of the current crystal
+  std::vector<DCCTBTriggerPrimitive> triggerPrimitives_;   // primitives of the current TCC block
   int cryIcMap_[68][5][5];
-  int tbStatusToLocation_[71];
   int tbTowerIDToLocation_[201];
   std::string tbName_;
+  bool soaDecoding_;
+  bool produceEB_;
+  bool produceEE_;
+  EcalTBWarningAggregator warnings_;
 
   int getEE_ix(int tower, int strip, int ch);
   int getEE_iy(int tower, int strip, int ch);
 
+  // EB and EE DetIds of the crystals (tower 1-68, strip and channel 1-5), built once from
+  // the crystal map: a null DetId marks a crystal with no valid id, which is then built
+  // (and throws) when it is used
+  void buildDetIdTables();
+  EBDetId ebDetId(int tower, int strip, int ch);
+  EEDetId eeDetId(int tower, int strip, int ch);
+  EBDetId ebDetIds_[68][5][5];
+  EEDetId eeDetIds_[68][5][5];
+
   enum SMGeom_t {
      kModules = 4,           // Number of modules per supermodule
      kTriggerTowers = 68,    // Number of trigger towers per supermodule
@@ -90,16 +168,15 @@ class EcalTB07DaqFormatter   {
     kTriggerTowersAndMem  = 70    // Number of trigger towers block including mems
   };
 
-  // index and container for expected towers (according to DCC status)
-  unsigned _numExpectedTowers;
-  unsigned _ExpectedTowers[71];
+  // expected towers (according to DCC status) and index of the next one
+  DCCTBTowerStatus towerStatus_;
   unsigned _expTowersIndex;
 
   // used for mem boxes unpacking
   int    memRawSample_[kStripsPerTower][kChannelsPerStrip][ kSamplesPerChannel+1];       // store raw data for one mem
   int    data_MEM[500];                                                                                                                  // collects unpacked data for both mems 
   bool pnAllocated;
-  bool pnIsOkInBlock[kPnPerTowerBlock];
+  unsigned memChannelErrors_;                     // one bit per Pn of the mem box with a channel error
 
 };
 #endif
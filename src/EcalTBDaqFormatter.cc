@@ -26,26 +26,47 @@
 #include "DCCTCCBlock.h"
 #include "DCCXtalBlock.h"
 #include "DCCDataMapper.h"
+#include "DCCParseContext.h"
+#include "DCCGainCheck.h"
+#include "DCCPnSample.h"
 
 
 #include <iostream>
 
-EcalTBDaqFormatter::EcalTBDaqFormatter () {
+EcalTBDaqFormatter::EcalTBDaqFormatter (const std::vector<uint32_t> & parserParameters) {
 
   LogDebug("EcalTBRawToDigi") << "@SUB=EcalTBDaqFormatter";
-  std::vector<uint32_t> parameters;
-  parameters.push_back(10); // parameters[0] is the xtal samples 
-  parameters.push_back(1);  // parameters[1] is the number of trigger time samples for TPG's
-  parameters.push_back(68); // parameters[2] is the number of TT
-  parameters.push_back(68); // parameters[3] is the number of SR Flags
-  parameters.push_back(1);  // parameters[4] is the dcc id
-  parameters.push_back(1);  // parameters[5] is the sr id
-  parameters.push_back(1);  // parameters[6] is the tcc1 id
-  parameters.push_back(2);  // parameters[7] is the tcc2 id
-  parameters.push_back(3);  // parameters[8] is the tcc3 id
-  parameters.push_back(4);  // parameters[9] is the tcc4 id
-
-  theParser_ = new DCCTBDataParser(parameters);
+  // lazy decoding: blocks only live while the FED buffer is interpreted,
+  // so fields are extracted from it when (and if) they are read
+  theParser_ = new DCCTBDataParser(parserParameters, true, true, true);
+  theContext_ = new DCCTBParseContext();
+  ownParser_ = true;
+  warnings_ = new EcalTBWarningAggregator("EcalTBRawToDigi");
+  xtalSamples_.resize(theParser_->numbXtalSamples());
+  triggerPrimitives_.resize(theParser_->numbTTs());
+  buildDetIdTables();
+
+}
+
+EcalTBDaqFormatter::EcalTBDaqFormatter (DCCTBDataParser * sharedParser) {
+
+  LogDebug("EcalTBRawToDigi") << "@SUB=EcalTBDaqFormatter";
+  theParser_ = sharedParser;
+  theContext_ = new DCCTBParseContext();
+  ownParser_ = false;
+  warnings_ = new EcalTBWarningAggregator("EcalTBRawToDigi");
+  xtalSamples_.resize(theParser_->numbXtalSamples());
+  triggerPrimitives_.resize(theParser_->numbTTs());
+  buildDetIdTables();
+
+}
+
+EcalTBDaqFormatter::~EcalTBDaqFormatter(){
+
+  LogDebug("EcalTBRawToDigi") << "@SUB=EcalTBDaqFormatter" << "\n";
+  delete theContext_;
+  delete warnings_;
+  if (ownParser_) delete theParser_;
 
 }
 
@@ -76,11 +97,21 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
   // mean + 3sigma estimation needed when switching to 0suppressed data
   digicollection.reserve(kCrystals);
   pnAllocated = false;
+
+  // Pn with mem channel errors already in the collections (updated as errors are found)
+  memChannelErrors_ = 0;
+  flagMemChannels(memgaincollection);
+  flagMemChannels(memchidcollection);
   
 
-  theParser_->parseBuffer( reinterpret_cast<uint32_t*>(const_cast<unsigned char*>(pData)), static_cast<uint32_t>(length), shit );
+  // the parser may be shared: the events and blocks live in the formatter own context
+  theParser_->parseBuffer( *theContext_, reinterpret_cast<uint32_t*>(const_cast<unsigned char*>(pData)), static_cast<uint32_t>(length), shit );
   
-  std::vector< DCCTBEventBlock * > &   dccEventBlocks = theParser_->dccEvents();
+  std::vector< DCCTBEventBlock * > &   dccEventBlocks = theContext_->dccEvents();
+
+  // blocks are recycled by the context: after the first events no new block should be allocated
+  LogDebug("EcalTBRawToDigi") << "@SUB=EcalTBDaqFormatter::interpretRawData"
+			      << "block allocations " << theContext_->blockAllocations();
 
   // Access each DCCTB block
   for( std::vector< DCCTBEventBlock * >::iterator itEventBlock = dccEventBlocks.begin(); 
@@ -101,14 +132,14 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
     EcalDCCHeaderBlock theDCCheader;
 
     theDCCheader.setId(28);                                                     // tb unpacker: forced to 28 to get first geom slot in EB
-    int fedId = (*itEventBlock)->getDataField("FED/DCC ID");
+    int fedId = (*itEventBlock)->getDataField(DCCTBDataMapper::DCCID_ID);
     theDCCheader.setFedId( fedId );                                             // fed id as found in raw data (0... 35 at tb )
 
-    theDCCheader.setRunNumber((*itEventBlock)->getDataField("RUN NUMBER"));
-    short trigger_type = (*itEventBlock)->getDataField("TRIGGER TYPE");
-    short zs  = (*itEventBlock)->getDataField("ZS");
-    short tzs = (*itEventBlock)->getDataField("TZS");
-    short sr  = (*itEventBlock)->getDataField("SR");
+    theDCCheader.setRunNumber((*itEventBlock)->getDataField(DCCTBDataMapper::RNUMB_ID));
+    short trigger_type = (*itEventBlock)->getDataField(DCCTBDataMapper::TRIGGERTYPE_ID);
+    short zs  = (*itEventBlock)->getDataField(DCCTBDataMapper::ZS_ID);
+    short tzs = (*itEventBlock)->getDataField(DCCTBDataMapper::TZS_ID);
+    short sr  = (*itEventBlock)->getDataField(DCCTBDataMapper::SR_ID);
     bool  dataIsSuppressed;
 
     // if zs&&tzs the suppression algo is used in DCC, the data are not suppressed and zs-bits are set
@@ -118,14 +149,14 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
     if(trigger_type >0 && trigger_type <5){theDCCheader.setBasicTriggerType(trigger_type);}
     else{ edm::LogWarning("EcalTBRawToDigiTriggerType") << "@SUB=EcalTBDaqFormatter::interpretRawData"
 							<< "unrecognized TRIGGER TYPE: "<<trigger_type;}
-    theDCCheader.setLV1((*itEventBlock)->getDataField("LV1"));
-    theDCCheader.setOrbit((*itEventBlock)->getDataField("ORBIT COUNTER"));
-    theDCCheader.setBX((*itEventBlock)->getDataField("BX"));
-    theDCCheader.setErrors((*itEventBlock)->getDataField("DCC ERRORS"));
+    theDCCheader.setLV1((*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID));
+    theDCCheader.setOrbit((*itEventBlock)->getDataField(DCCTBDataMapper::ORBITCOUNTER_ID));
+    theDCCheader.setBX((*itEventBlock)->getDataField(DCCTBDataMapper::BX_ID));
+    theDCCheader.setErrors((*itEventBlock)->getDataField(DCCTBDataMapper::DCCERRORS_ID));
     theDCCheader.setSelectiveReadout( sr );
     theDCCheader.setZeroSuppression( zs );
     theDCCheader.setTestZeroSuppression( tzs );
-    theDCCheader.setSrpStatus((*itEventBlock)->getDataField("SR_CHSTATUS"));
+    theDCCheader.setSrpStatus((*itEventBlock)->getDataField(DCCTBDataMapper::SR_CHSTATUS_ID));
 
 
 
@@ -133,27 +164,27 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
     std::vector<short> theTCCs;
     for(int i=0; i<MAX_TCC_SIZE; i++){
       
-      char TCCnum[20]; sprintf(TCCnum,"TCC_CHSTATUS#%d",i+1); std::string TCCnumS(TCCnum);
-      theTCCs.push_back ((*itEventBlock)->getDataField(TCCnumS) );
+      theTCCs.push_back ((*itEventBlock)->getDataField(theParser_->mapper()->tccChStatusId(i+1)) );
     }
     theDCCheader.setTccStatus(theTCCs);
 
 
     std::vector< DCCTBTCCBlock * > tccBlocks = (*itEventBlock)->tccBlocks();
+    tpcollection.reserve(tpcollection.size() + tccBlocks.size()*theParser_->numbTTs());
     
     for(    std::vector< DCCTBTCCBlock * >::iterator itTCCBlock = tccBlocks.begin(); 
 	    itTCCBlock != tccBlocks.end(); 
 	    itTCCBlock ++)
       {
 
-	std::vector< std::pair<int,bool> > TpSamples = (* itTCCBlock) -> triggerSamples() ;
-	// std::vector of 3 bits
-	std::vector<int> TpFlags      = (* itTCCBlock) -> triggerFlags() ;
+	// Et, fine grain veto and flag (3 bits) of all the towers in one pass
+	DCCTBTriggerPrimitive * tps = &triggerPrimitives_[0];
+	uint32_t numbTPs = (* itTCCBlock) -> triggerPrimitives(tps) ;
 	
 	// there have always to be 68 primitives and flags, per FED
-	if (TpSamples.size()==68   && TpFlags.size()==68)
+	if (numbTPs==68)
 	  {
-	    for(int i=0; i<((int)TpSamples.size()); i++)	
+	    for(int i=0; i<((int)numbTPs); i++)	
 	      {
 		
 		int etaTT = (i)  / kTowersInPhi +1;
@@ -163,7 +194,7 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		phiTT=3-phiTT;
 		if(phiTT<=0)phiTT=phiTT+72;
 
-		EcalTriggerPrimitiveSample theSample(TpSamples[i].first, TpSamples[i].second, TpFlags[i]);
+		EcalTriggerPrimitiveSample theSample(tps[i].et(), tps[i].fgvb(), tps[i].ttf());
 		
 		EcalTrigTowerDetId idtt(1, EcalBarrel, etaTT, phiTT, 0);
 
@@ -175,11 +206,11 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		
 		LogDebug("EcalTBRawToDigiTpg") << "@SUBS=EcalTBDaqFormatter::interpretRawData"
 					       << "tower: " << (i+1) 
-					       << " primitive: " << TpSamples[i].first
-					       << " flag: " << TpSamples[i].second;
+					       << " primitive: " << tps[i].et()
+					       << " flag: " << tps[i].fgvb();
 
 		LogDebug("EcalTBRawToDigiTpg") << "@SUBS=EcalTBDaqFormatter::interpretRawData"<<
-		  "tower: " << (i+1) << " flag: " << TpFlags[i];
+		  "tower: " << (i+1) << " flag: " << tps[i].ttf();
 	      }// end loop on tower primitives
 	    
 	  }// end if
@@ -193,21 +224,19 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
     
     
     short TowerStatus[MAX_TT_SIZE+1];
-    char buffer[20];
-    std::vector<short> theTTstatus;
-    for(int i=1;i<MAX_TT_SIZE+1;i++)
-      { 
- 	sprintf(buffer, "FE_CHSTATUS#%d", i);
- 	std::string Tower(buffer);
- 	TowerStatus[i]= (*itEventBlock)->getDataField(Tower);
-	theTTstatus.push_back(TowerStatus[i]);
-	//std::cout << "tower " << i << " has status " <<  TowerStatus[i] << std::endl;  
-      }
+    // FE channel statuses straight from the header words (field by field if the header is not complete)
+    uint32_t * headerWords = (*itEventBlock)->headerWords();
+    if( headerWords ){ DCCTBTowerStatus::decode(headerWords, TowerStatus); }
+    else{
+      for(int i=1;i<MAX_TT_SIZE+1;i++)
+	TowerStatus[i]= (*itEventBlock)->getDataField(theParser_->mapper()->feChStatusId(i));
+    }
+    std::vector<short> theTTstatus(TowerStatus+1, TowerStatus+MAX_TT_SIZE+1);
 
     theDCCheader.setFEStatus(theTTstatus);
     
     EcalDCCTBHeaderRuntypeDecoder theRuntypeDecoder;
-    uint32_t DCCruntype = (*itEventBlock)->getDataField("RUN TYPE");
+    uint32_t DCCruntype = (*itEventBlock)->getDataField(DCCTBDataMapper::RUNTYPE_ID);
     theRuntypeDecoder.Decode(DCCruntype, &theDCCheader);
     //DCCHeader filled!
     DCCheaderCollection.push_back(theDCCheader);
@@ -218,35 +247,24 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 
 
 
-    _expTowersIndex=0;_numExpectedTowers=0;
-    for (int v=0; v<71; v++){
-      _ExpectedTowers[v]=99999;
-    }
-
     // note: these are the tower statuses handled at the moment - to be completed
     // staus==0:   tower expected;
     // staus==9:   Synk error LV1, tower expected;
     // staus==10:  Synk error BX, tower expected;
     // status==1, 2, 3, 4, 5:  tower not expected
-    for (int u=1; u< (kTriggerTowersAndMem+1); u++)
-      {
-	if(   TowerStatus[u] ==0 || TowerStatus[u] ==9 || TowerStatus[u] ==10  ) 
-	  {_ExpectedTowers[_expTowersIndex]=u;
-	    _expTowersIndex++;
-	    _numExpectedTowers++;
-	  }
-      }
+    towerStatus_.fill(TowerStatus);
+
     // resetting counter of expected towers
     _expTowersIndex=0;
       
       
     // if number of dccEventBlocks NOT same as expected stop
-    if (!      (dccTowerBlocks.size() == _numExpectedTowers)      )
+    if (!      (dccTowerBlocks.size() == towerStatus_.numbExpected())      )
       {
         // we probably always want to know if this happens
         edm::LogWarning("EcalTBRawToDigiNumTowerBlocks") << "@SUB=EcalTBDaqFormatter::interpretRawData"
 				      << "number of TowerBlocks found (" << dccTowerBlocks.size()
-				      << ") differs from expected (" << _numExpectedTowers 
+				      << ") differs from expected (" << towerStatus_.numbExpected() 
 				      << ") skipping event"; 
 	
         EBDetId idsm(1, 1);
@@ -270,18 +288,19 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
       // checking if tt in data is the same as tt expected 
       // else skip tower and increment problem counter
 	    
-      // compute eta/phi in order to have iTT = _ExpectedTowers[_expTowersIndex]
+      // compute eta/phi in order to have iTT = towerStatus_.location(_expTowersIndex)
       // for the time being consider only zside>0
 
-      EcalElectronicsId idtt(28, _ExpectedTowers[_expTowersIndex], 1, 1);
+      EcalElectronicsId idtt(28, towerStatus_.location(_expTowersIndex), 1, 1);
 
-      if (  !(tower == _ExpectedTowers[_expTowersIndex])	  )
+      if (  !(tower == towerStatus_.location(_expTowersIndex))	  )
         {	
 	  
-	  if (_ExpectedTowers[_expTowersIndex] <= 68){
-	    edm::LogWarning("EcalTBRawToDigiTowerId") << "@SUBS=EcalTBDaqFormatter::interpretRawData"
+	  if (towerStatus_.location(_expTowersIndex) <= 68){
+	    if (warnings_->report(EcalTBWarningAggregator::TOWERID, tower))
+	      edm::LogWarning("EcalTBRawToDigiTowerId") << "@SUBS=EcalTBDaqFormatter::interpretRawData"
 						      << "TTower id found (=" << tower 
-						      << ") different from expected (=" <<  _ExpectedTowers[_expTowersIndex] 
+						      << ") different from expected (=" <<  towerStatus_.location(_expTowersIndex) 
 						      << ") " << (_expTowersIndex+1) << "-th tower checked"; 
 	    
 	    //  report on failed tt_id for regular tower block
@@ -289,14 +308,15 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 	  }
 	  else
 	    {
-	      edm::LogWarning("EcalTBRawToDigiTowerId") << "@SUB=EcalTBDaqFormatter:interpretRawData"
+	      if (warnings_->report(EcalTBWarningAggregator::TOWERID, tower))
+	        edm::LogWarning("EcalTBRawToDigiTowerId") << "@SUB=EcalTBDaqFormatter:interpretRawData"
 							<< "DecodeMEM: tower " << tower  
-							<< " is not the same as expected " << ((int)_ExpectedTowers[_expTowersIndex])
+							<< " is not the same as expected " << ((int)towerStatus_.location(_expTowersIndex))
 							<< " (according to DCC header channel status)";
 	      
 	      // report on failed tt_id for mem tower block
 	      // chosing channel 1 as representative
-	      EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], 1, 1);
+	      EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), 1, 1);
 	      memttidcollection.push_back(id);
 	    }
 
@@ -319,16 +339,29 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 	  // if there is no zero suppression, tower block must have have 25 channels in it
 	  if (  (!dataIsSuppressed)   &&   (xtalDataBlocks.size() != kChannelsPerTower)   )
 	    {     
-	      edm::LogWarning("EcalTBRawToDigiTowerSize") << "EcalTBDaqFormatter::interpretRawData, no zero suppression "
+	      if (warnings_->report(EcalTBWarningAggregator::TOWERSIZE, towerStatus_.location(_expTowersIndex)))
+	        edm::LogWarning("EcalTBRawToDigiTowerSize") << "EcalTBDaqFormatter::interpretRawData, no zero suppression "
 					    << "wrong tower block size is: "  << xtalDataBlocks.size() 
-					    << " at LV1 " << (*itEventBlock)->getDataField("LV1")
-					    << " for TT " << _ExpectedTowers[_expTowersIndex];
+					    << " at LV1 " << (*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID)
+					    << " for TT " << towerStatus_.location(_expTowersIndex);
 	      // report on wrong tt block size
 	      blocksizecollection.push_back(idtt);
 
 	      ++ _expTowersIndex; 	      continue;	
 
 	    }
+
+	  // tower longer than 25 xtal blocks: the parser built only the first 25
+	  if ( (*itTowerBlock)->tooLong() )
+	    {
+	      if (warnings_->report(EcalTBWarningAggregator::TOWERSIZE, towerStatus_.location(_expTowersIndex)))
+	        edm::LogWarning("EcalTBRawToDigiTowerSize") << "EcalTBDaqFormatter::interpretRawData, tower block longer than "
+					    << kChannelsPerTower << " xtals at LV1 " << (*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID)
+					    << " for TT " << towerStatus_.location(_expTowersIndex);
+	      blocksizecollection.push_back(idtt);
+
+	      ++ _expTowersIndex; 	      continue;	
+	    }
 	  
 
 	  short cryInTower =0;
@@ -351,8 +384,8 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 	    
 	    
 	    // FIXME: waiting for geometry to do (TT, strip,chNum) <--> (SMChId)
-	    // short abscissa = (_ExpectedTowers[_expTowersIndex]-1)  /4;
-	    // short ordinate = (_ExpectedTowers[_expTowersIndex]-1)  %4;
+	    // short abscissa = (towerStatus_.location(_expTowersIndex)-1)  /4;
+	    // short ordinate = (towerStatus_.location(_expTowersIndex)-1)  %4;
 	    // temporarily choosing central crystal in trigger tower
 	    // int cryIdInSM  = 45 + ordinate*5 + abscissa * 100;
 	    
@@ -372,11 +405,12 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		      }
 		    }
 		    
-		    edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData with zero suppression, "
+		    if (warnings_->report(EcalTBWarningAggregator::CHID, tower, strip, ch))
+		      edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData with zero suppression, "
 							   << " wrong channel id, since out of range: "
 							   << "\t strip: "  << strip  << "\t channel: " << ch
-							   << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-							   << "\t at LV1 : " << (*itEventBlock)->getDataField("LV1");
+							   << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+							   << "\t at LV1 : " << (*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID);
 		    
 		    expCryInTower++;
 		    continue;
@@ -392,13 +426,14 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		// cry_id wrong because of incorrect ordering within trigger tower
 		else
 		  {
-		    edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData with zero suppression, "
+		    if (warnings_->report(EcalTBWarningAggregator::CHID, tower, strip, ch))
+		      edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData with zero suppression, "
 						  << " based on ch ordering within tt, wrong channel id: "
 						  << "\t strip: "  << strip  << "\t channel: " << ch
 						  << "\t cryInTower "  << cryInTower
 						  << "\t expCryInTower: " << expCryInTower
-						  << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-						  << "\t at LV1: " << (*itEventBlock)->getDataField("LV1");
+						  << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+						  << "\t at LV1: " << (*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID);
 		    
 		    int  sm = 1; // hardcoded because of test  beam
 		    for (int StripInTower_ =1;  StripInTower_ < 6; StripInTower_++){
@@ -430,11 +465,12 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 		  int  sm = 1; // hardcoded because of test  beam
 		  EBDetId  idExp(sm, ic,1);
 		  
-		  edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData no zero suppression "
+		  if (warnings_->report(EcalTBWarningAggregator::CHID, tower, expStripInTower, expCryInStrip))
+		    edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData no zero suppression "
 						    << " wrong channel id for channel: "  << expCryInStrip
 						    << "\t strip: " << expStripInTower
-						    << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-						    << "\t at LV1: " << (*itEventBlock)->getDataField("LV1")
+						    << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+						    << "\t at LV1: " << (*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID)
 						    << "\t   (in the data, found channel:  " << ch
 						    << "\t strip:  " << strip << " ).";
 
@@ -454,95 +490,89 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 	    
 	    
 	    // data  to be stored in EBDataFrame, identified by EBDetId
-	    int  ic = cryIc(tower, strip, ch) ;
-	    int  sm = 1;
-	    EBDetId  id(sm, ic,1);                 
+	    EBDetId  id = ebDetIds_[tower-1][strip-1][ch-1];
 	    
-            // here data frame go into the Event
-            // removed later on (with a pop_back()) if gain==0 or if forbidden-gain-switch
-            digicollection.push_back( id );
-	    EBDataFrame theFrame ( digicollection.back() );
-	    std::vector<int> xtalDataSamples = (*itXtalBlock)->xtalDataSamples();   
-	    //theFrame.setSize(xtalDataSamples.size()); // if needed, to be changed when constructing digicollection
+	    uint16_t * xtalDataSamples = &xtalSamples_[0];
+	    uint32_t   numbSamples     = (*itXtalBlock)->xtalDataSamples(xtalDataSamples);
+	    //theFrame.setSize(numbSamples); // if needed, to be changed when constructing digicollection
       
       
 
-	    // gain cannot be 0, checking for that
-	    bool        gainIsOk =true;
-	    unsigned gain_mask      = 12288;    //12th and 13th bit
-	    std::vector <int> xtalGain;
-
-	    for (unsigned short i=0; i<xtalDataSamples.size(); ++i ) {
-	      
-	      theFrame.setSample (i, xtalDataSamples[i] );
-	      
-	      if((xtalDataSamples[i] & gain_mask) == 0){gainIsOk =false;}
-	      
-	      xtalGain.push_back(0);
-	      xtalGain[i] |= (xtalDataSamples[i] >> 12);
-	    }
+	    // gain cannot be 0, checking for that and counting forbidden gain transitions in one pass
+	    bool     gainZero;
+	    uint32_t numGainWrong;
+	    DCCTBGainCheck::checkXtal(xtalDataSamples, numbSamples, gainZero, numGainWrong);
 	    
-	    if (! gainIsOk) {
+	    if (gainZero) {
 	      
-	      edm::LogWarning("EcalTBRawToDigiGainZero") << "@SUB=EcalTBDaqFormatter::interpretRawData"
+	      if (warnings_->report(EcalTBWarningAggregator::GAINZERO, tower, expStripInTower, expCryInStrip))
+	        edm::LogWarning("EcalTBRawToDigiGainZero") << "@SUB=EcalTBDaqFormatter::interpretRawData"
 					    << " gain==0 for strip: "  << expStripInTower
 					    << "\t channel: " << expCryInStrip
-					    << "\t in TT: " << _ExpectedTowers[_expTowersIndex]
-					    << "\t ic: " << ic
-					    << "\t at LV1: " << (*itEventBlock)->getDataField("LV1");
+					    << "\t in TT: " << towerStatus_.location(_expTowersIndex)
+					    << "\t ic: " << cryIc(tower, strip, ch)
+					    << "\t at LV1: " << (*itEventBlock)->getDataField(DCCTBDataMapper::LV1_ID);
 	      // report on gain==0
 	      gaincollection.push_back(id);
 	      
 	      // there has been a gain==0, dataframe not to go to the Event
-              digicollection.pop_back();
 	      continue; //	      expCryInTower already incremented
 	    }
 
 
 	    
 	    
-	    // looking for forbidden gain transitions
+	    // reporting forbidden gain transitions (gain is the sample >> 12)
 	    
 	    short firstGainWrong=-1;
-	    short numGainWrong=0;
 	    
-	    for (unsigned short i=0; i<xtalGain.size(); i++ ) {
+	    for (unsigned short i=1; numGainWrong>0 && i<numbSamples; i++ ) {
 	      
-	      if (i>0 && xtalGain[i-1]>xtalGain[i]) {
-		
-		numGainWrong++;// counting forbidden gain transitions
+	      int lastGain = xtalDataSamples[i-1] >> 12;
+	      int gain     = xtalDataSamples[i]   >> 12;
+	      
+	      if (lastGain>gain) {
 		
 		if (firstGainWrong == -1) {
 		  firstGainWrong=i;
-		  edm::LogWarning("EcalTBRawToDigiGainSwitch") << "@SUB=EcalTBDaqFormatter::interpretRawData"
+		  if (warnings_->report(EcalTBWarningAggregator::GAINSWITCH, tower, strip, ch))
+		    edm::LogWarning("EcalTBRawToDigiGainSwitch") << "@SUB=EcalTBDaqFormatter::interpretRawData"
 							  << "channelHasGainSwitchProblem: crystal eta = " 
 							  << id.ieta() << " phi = " << id.iphi();
 		}
-		edm::LogWarning("EcalTBRawToDigiGainSwitch") << "@SUB=EcalTBDaqFormatter::interpretRawData"
+		if (warnings_->report(EcalTBWarningAggregator::GAINSWITCH, tower, strip, ch))
+		  edm::LogWarning("EcalTBRawToDigiGainSwitch") << "@SUB=EcalTBDaqFormatter::interpretRawData"
 							<< "channelHasGainSwitchProblem: sample = " << (i-1) 
-							<< " gain: " << xtalGain[i-1] << " sample: " 
-							<< i << " gain: " << xtalGain[i];
+							<< " gain: " << lastGain << " sample: " 
+							<< i << " gain: " << gain;
 	      }
 	    }
 
 	    if (numGainWrong>0) {
 	      gainswitchcollection.push_back(id);
 
-	      edm::LogWarning("EcalTBRawToDigiGainSwitch") << "@SUB=EcalTBDaqFormatter:interpretRawData"
+	      if (warnings_->report(EcalTBWarningAggregator::GAINSWITCH, tower, strip, ch))
+	        edm::LogWarning("EcalTBRawToDigiGainSwitch") << "@SUB=EcalTBDaqFormatter:interpretRawData"
 							<< "channelHasGainSwitchProblem: more than 1 wrong transition";
 	
-	      for (unsigned short i1=0; i1<xtalDataSamples.size(); ++i1 ) {
+	      for (unsigned short i1=0; i1<numbSamples; ++i1 ) {
 		int countADC = 0x00000FFF;
 		countADC &= xtalDataSamples[i1];
-		LogDebug("EcalTBRawToDigi") << "Sample " << i1 << " ADC " << countADC << " Gain " << xtalGain[i1];
+		LogDebug("EcalTBRawToDigi") << "Sample " << i1 << " ADC " << countADC << " Gain " << (xtalDataSamples[i1] >> 12);
 
 	      }
 
 	      // there has been a forbidden gain transition,  dataframe not to go to the Event
-              digicollection.pop_back();
 	      continue; //	      expCryInTower already incremented
 
 	    }// END of:   'if there is a forbidden gain transition'
+
+
+            // here data frame go into the Event, once the samples are checked
+	    digicollection.push_back( id );
+	    EBDataFrame theFrame ( digicollection.back() );
+	    for (unsigned short i=0; i<numbSamples; ++i )
+	      theFrame.setSample (i, xtalDataSamples[i] );
 	    
 	  }// end loop on crystals within a tower block
 	  
@@ -582,7 +612,8 @@ void EcalTBDaqFormatter::interpretRawData(const FEDRawData & fedData ,
 
       // wrong tt id
       else  {
-        edm::LogWarning("EcalTBRawToDigiTowerId") <<"@SUB=EcalTBDaqFormatter::interpretRawData"
+        if (warnings_->report(EcalTBWarningAggregator::TOWERID, (*itTowerBlock)->towerID()))
+          edm::LogWarning("EcalTBRawToDigiTowerId") <<"@SUB=EcalTBDaqFormatter::interpretRawData"
 				      << " processing tt with ID not existing ( "
 				      <<  (*itTowerBlock)->towerID() << ")";
         ++ _expTowersIndex;continue; 
@@ -621,7 +652,8 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
   // check that tower block id corresponds to mem boxes
   if(tower_id != 69 && tower_id != 70) 
     {
-      edm::LogWarning("EcalTBRawToDigiTowerId") << "@SUB=EcalTBDaqFormatter:decodeMem"
+      if (warnings_->report(EcalTBWarningAggregator::TOWERID, tower_id))
+        edm::LogWarning("EcalTBRawToDigiTowerId") << "@SUB=EcalTBDaqFormatter:decodeMem"
 				    << "DecodeMEM: this is not a mem box tower (" << tower_id << ")";
       ++ _expTowersIndex;
       return;
@@ -639,11 +671,11 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
     {     
       LogDebug("EcalTBRawToDigiDccBlockSize") << "@SUB=EcalTBDaqFormatter:decodeMem"
 				  << " wrong dccBlock size, namely: "  << dccXtalBlocks.size() 
-				  << ", for mem " << _ExpectedTowers[_expTowersIndex];
+				  << ", for mem " << towerStatus_.location(_expTowersIndex);
 
       // reporting mem-tt block size problem
       // chosing channel 1 as representative as a dummy...
-      EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], 1, 1);
+      EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), 1, 1);
       memblocksizecollection.push_back(id);
 
       ++ _expTowersIndex;
@@ -655,8 +687,8 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
   int  cryCounter = 0;   int  strip_id  = 0;   int  xtal_id   = 0;  
 
   for ( itXtal = dccXtalBlocks.begin(); itXtal < dccXtalBlocks.end(); itXtal++ ) {
-    strip_id                     = (*itXtal) ->getDataField("STRIP ID");
-    xtal_id                      = (*itXtal) ->getDataField("XTAL ID");
+    strip_id                     = (*itXtal) ->getDataField(DCCTBDataMapper::STRIPID_ID);
+    xtal_id                      = (*itXtal) ->getDataField(DCCTBDataMapper::XTALID_ID);
     int wished_strip_id  = cryCounter/ kStripsPerTower;
     int wished_ch_id     = cryCounter% kStripsPerTower;
     
@@ -671,22 +703,16 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
 				    << "  strip " <<  strip_id << "  cry " << xtal_id;
 	
 	// report on crystal with unexpected indices
-	EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], wished_strip_id,  wished_ch_id);
+	EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), wished_strip_id,  wished_ch_id);
 	memchidcollection.push_back(id);
+	flagMemChannel(id);
       }
     
     
     // Accessing the 10 time samples per Xtal:
-    memRawSample_[wished_strip_id][wished_ch_id][1] = (*itXtal)->getDataField("ADC#1");
-    memRawSample_[wished_strip_id][wished_ch_id][2] = (*itXtal)->getDataField("ADC#2");
-    memRawSample_[wished_strip_id][wished_ch_id][3] = (*itXtal)->getDataField("ADC#3");
-    memRawSample_[wished_strip_id][wished_ch_id][4] = (*itXtal)->getDataField("ADC#4");
-    memRawSample_[wished_strip_id][wished_ch_id][5] = (*itXtal)->getDataField("ADC#5");
-    memRawSample_[wished_strip_id][wished_ch_id][6] = (*itXtal)->getDataField("ADC#6");
-    memRawSample_[wished_strip_id][wished_ch_id][7] = (*itXtal)->getDataField("ADC#7");
-    memRawSample_[wished_strip_id][wished_ch_id][8] = (*itXtal)->getDataField("ADC#8");
-    memRawSample_[wished_strip_id][wished_ch_id][9] = (*itXtal)->getDataField("ADC#9");
-    memRawSample_[wished_strip_id][wished_ch_id][10] = (*itXtal)->getDataField("ADC#10");
+    uint32_t numbSamples = (*itXtal)->xtalDataSamples(&xtalSamples_[0]);
+    for (uint32_t sample=1; sample<=10 && sample<=numbSamples; sample++)
+      memRawSample_[wished_strip_id][wished_ch_id][sample] = xtalSamples_[sample-1];
       
     cryCounter++;
   }// end loop on crystals of mem dccXtalBlock
@@ -700,13 +726,10 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
   /************************************************************
    // unpacking and 'cooking' the raw numbers to get PN sample
    ************************************************************/
-  int tempSample=0;
+  // every sample of the mem box is written below (-1 if its gain is wrong): no reset of data_MEM
   int memStoreIndex=0;
   int ipn=0;
-  for (memStoreIndex=0; memStoreIndex<500; memStoreIndex++)    {
-    data_MEM[memStoreIndex]= -1;   }
-  
-  
+
   for(int strip=0; strip<kStripsPerTower; strip++) {// loop on strips
     for(int channel=0; channel<kChannelsPerStrip; channel++) {// loop on channels
 
@@ -715,37 +738,30 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
       else 
 	{ipn=mem_id*5+4-channel;}
 
+      // 1) if strip number is even, 14 bits are reversed in order
+      bool reversed = (strip%2 == 1);
+
       for(int sample=0;sample< kSamplesPerChannel ;sample++) {
-	tempSample= memRawSample_[strip][channel][sample+1];
-
-	int new_data=0;
-	if(strip%2 == 1) {
-	  // 1) if strip number is even, 14 bits are reversed in order
-	  for(int ib=0;ib<14;ib++)
-	    { 
-	      new_data <<= 1;
-	      new_data=new_data | (tempSample&1);
-	      tempSample >>= 1;
-	    }
-	} else {
-	  new_data=tempSample;
-	}
 
 	// 2) flip 11th bit for AD9052 still there on MEM !
-	// 3) mask with 1 1111 1111 1111
-	new_data = (new_data ^ 0x800) & 0x3fff;    // (new_data  XOR 1000 0000 0000) & 11 1111 1111 1111
-	// new_data = (new_data ^ 0x800) & 0x1fff;    // (new_data  XOR 1000 0000 0000) & 1 1111 1111 1111
+	// 3) mask with 11 1111 1111 1111
+	int new_data = DCCTBPnSample::decode(memRawSample_[strip][channel][sample+1], reversed);
+	memStoreIndex= ipn*50+strip*kSamplesPerChannel+sample;
 
 	//(Bit 12) == 1 -> Gain 16;    (Bit 12) == 0 -> Gain 1	
 	// gain in mem can be 1 or 16 encoded resp. with 0 ir 1 in the 13th bit.
 	// checking and reporting if there is any sample with gain==2,3
-	short sampleGain = (new_data &0x3000)/4096;
+	short sampleGain = DCCTBPnSample::gain(new_data);
 	if (  sampleGain==2 || sampleGain==3) 
 	  {
-	    EcalElectronicsId id(1, (int)_ExpectedTowers[_expTowersIndex], strip, channel);
+	    data_MEM[memStoreIndex]= -1;
+
+	    EcalElectronicsId id(1, (int)towerStatus_.location(_expTowersIndex), strip, channel);
 	    memgaincollection.push_back(id);
+	    flagMemChannel(id);
 	    
-	    edm::LogWarning("EcalTBRawToDigiGainZero")  << "@SUB=EcalTBDaqFormatter:decodeMem"
+	    if (warnings_->report(EcalTBWarningAggregator::GAINZERO, towerblock->towerID(), strip+1, channel+1))
+	      edm::LogWarning("EcalTBRawToDigiGainZero")  << "@SUB=EcalTBDaqFormatter:decodeMem"
 					   << "in mem " <<  towerblock->towerID()
 					   << " :\t strip: "
 					   << (strip +1)  << " cry: " << (channel+1) 
@@ -755,9 +771,8 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
 	    continue;
 	  }// end 'if gain is zero'
 
-	memStoreIndex= ipn*50+strip*kSamplesPerChannel+sample;
 	// storing in data_MEM also the gain bits
-	data_MEM[memStoreIndex]= new_data & 0x3fff;
+	data_MEM[memStoreIndex]= new_data;
 
       }// loop on samples
     }// loop on strips
@@ -766,29 +781,9 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
 
 
 
-  for (int pnId=0; pnId<kPnPerTowerBlock; pnId++) pnIsOkInBlock[pnId]=true;
   // if anything was wrong with mem_tt_id or mem_tt_size: you would have already exited
   // otherwise, if any problem with ch_gain or ch_id: must not produce digis for the pertaining Pn
-
-  if (!      (memgaincollection.size()==0 && memchidcollection.size()==0)          )
-    {
-      for ( EcalElectronicsIdCollection::const_iterator idItr = memgaincollection.begin();
-	    idItr != memgaincollection.end();
-	    ++ idItr ) {
-	int ch = (*idItr).channelId();
-	ch = (ch-1)/5;
-	pnIsOkInBlock [ch] = false;
-      }
-
-      for ( EcalElectronicsIdCollection::const_iterator idItr = memchidcollection.begin();
-	    idItr != memchidcollection.end();
-	    ++ idItr ) {
-	int ch = (*idItr).channelId();
-	ch = (ch-1)/5;
-	pnIsOkInBlock [ch] = false;
-      }
-
-    }// end: if any ch_gain or ch_id problems exclude the Pn's from digi production
+  // (memChannelErrors_ has one bit per Pn with a channel in memgaincollection or memchidcollection)
 
 
 
@@ -797,7 +792,7 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
   for (int pnId = 1;  pnId <  (kPnPerTowerBlock+1); pnId++){
 
     // if present Pn has any of its 5 channels with problems, do not produce digi for it
-    if (! pnIsOkInBlock [pnId-1] ) continue;
+    if ( memChannelErrors_ & (1 << (pnId-1)) ) continue;
 
     // DccId set to 28 to be consistent with ism==1
     EcalPnDiodeDetId PnId(1, 28, pnId +  kPnPerTowerBlock*mem_id);
@@ -829,6 +824,56 @@ void EcalTBDaqFormatter::DecodeMEM( DCCTBTowerBlock *  towerblock,  EcalPnDiodeD
 
 
 
+// marks the Pn of a mem channel error: pnId-1 is (channelId-1)/5 of the channel reported
+void EcalTBDaqFormatter::flagMemChannel(const EcalElectronicsId & id)
+{
+  int pn = (id.channelId()-1)/5;
+  if (pn >= 0 && pn < kPnPerTowerBlock) memChannelErrors_ |= (1 << pn);
+}
+
+
+
+void EcalTBDaqFormatter::flagMemChannels(const EcalElectronicsIdCollection & idcollection)
+{
+  memChannelErrors_ |= memChannelBits(idcollection);
+}
+
+
+
+// memChannelErrors_ bits of the mem channel errors of a collection
+unsigned EcalTBDaqFormatter::memChannelBits(const EcalElectronicsIdCollection & idcollection)
+{
+  unsigned bits = 0;
+  for ( EcalElectronicsIdCollection::const_iterator idItr = idcollection.begin();
+	idItr != idcollection.end();
+	++ idItr ) {
+    int pn = (idItr->channelId()-1)/5;
+    if (pn >= 0 && pn < kPnPerTowerBlock) bits |= (1 << pn);
+  }
+  return bits;
+}
+
+
+
+// the Pn of a digi is pnId + kPnPerTowerBlock*mem_id (see DecodeMEM)
+void EcalTBDaqFormatter::suppressPnDigis(EcalPnDiodeDigiCollection & pndigicollection,
+					 const EcalElectronicsIdCollection & memgaincollection,
+					 const EcalElectronicsIdCollection & memchidcollection)
+{
+  unsigned errors = memChannelBits(memgaincollection) | memChannelBits(memchidcollection);
+  if (errors == 0) return;
+
+  EcalPnDiodeDigiCollection kept;
+  kept.reserve(pndigicollection.size());
+  for ( EcalPnDiodeDigiCollection::const_iterator digiItr = pndigicollection.begin();
+	digiItr != pndigicollection.end();
+	++ digiItr )
+    if ( !(errors & (1 << ((digiItr->id().iPnId()-1) % kPnPerTowerBlock))) ) kept.push_back(*digiItr);
+  pndigicollection.swap(kept);
+}
+
+
+
 std::pair<int,int>  EcalTBDaqFormatter::cellIndex(int tower_id, int strip, int ch) {
   
   int xtal= (strip-1)*5+ch-1;
@@ -866,19 +911,37 @@ int  EcalTBDaqFormatter::cryIc(int tower, int strip, int ch) {
 
   if ( strip < 1 || 5<strip || ch <1 || 5 < ch || 68<tower)
     {
-      edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData (cryIc) "
+      if (warnings_->report(EcalTBWarningAggregator::CHID, tower, strip, ch))
+        edm::LogWarning("EcalTBRawToDigiChId") << "EcalTBDaqFormatter::interpretRawData (cryIc) "
 					     << " wrong channel id, since out of range: "
 					     << "\t strip: "  << strip  << "\t channel: " << ch
 					     << "\t in TT: " << tower;
       return -1;
     }
   
+  if ( tower >= 1 ) return cryIcs_[tower-1][strip-1][ch-1];
+
   std::pair<int,int> cellInd= EcalTBDaqFormatter::cellIndex(tower, strip, ch); 
   return cellInd.second + (cellInd.first-1)*kCrystalsInPhi;
 }
 
 
 
+void EcalTBDaqFormatter::buildDetIdTables(){
+
+  int sm = 1;
+  for (int tower=1; tower<=68; tower++)
+    for (int strip=1; strip<=5; strip++)
+      for (int ch=1; ch<=5; ch++) {
+	std::pair<int,int> cellInd= EcalTBDaqFormatter::cellIndex(tower, strip, ch); 
+	int ic = cellInd.second + (cellInd.first-1)*kCrystalsInPhi;
+	cryIcs_[tower-1][strip-1][ch-1]   = ic;
+	ebDetIds_[tower-1][strip-1][ch-1] = EBDetId(sm, ic, 1);
+      }
+}
+
+
+
 bool EcalTBDaqFormatter::rightTower(int tower) const {
   
   if ((tower>12 && tower<21) || (tower>28 && tower<37) ||
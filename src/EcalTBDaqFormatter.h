@@ -13,7 +13,11 @@
 #include <DataFormats/EcalDigi/interface/EcalDigiCollections.h>
 #include <DataFormats/EcalRawData/interface/EcalRawDataCollections.h>
 #include <DataFormats/EcalDetId/interface/EcalDetIdCollections.h>
+#include <DataFormats/EcalDetId/interface/EBDetId.h>
 #include "DCCTowerBlock.h"
+#include "DCCTriggerPrimitive.h"
+#include "DCCTowerStatus.h"
+#include "EcalTBWarningAggregator.h"
 
 #include <vector> 
 #include <map>
@@ -26,12 +30,22 @@
 
 class FEDRawData;
 class DCCTBDataParser;
+class DCCTBParseContext;
 class EcalTBDaqFormatter   {
 
  public:
 
-  EcalTBDaqFormatter();
-  virtual ~EcalTBDaqFormatter(){LogDebug("EcalTBRawToDigi") << "@SUB=EcalTBDaqFormatter" << "\n"; };
+  /// parserParameters: see DCCTBDataParser (DCCTBDataParser::defaultParameters for the test beam DCC)
+  EcalTBDaqFormatter(const std::vector<uint32_t> & parserParameters);
+  /// Uses a parser shared with other formatters (not deleted by this one): the parse context,
+  /// the warning aggregator and the per-event state are owned by each formatter
+  EcalTBDaqFormatter(DCCTBDataParser * sharedParser);
+  virtual ~EcalTBDaqFormatter();
+
+  DCCTBDataParser * parser() { return theParser_; }
+
+  /// Counts the warnings of the formatter and limits the ones emitted (see EcalTBWarningAggregator)
+  EcalTBWarningAggregator * warnings() { return warnings_; }
 
   void  interpretRawData( const FEDRawData & data , EBDigiCollection& digicollection , EcalPnDiodeDigiCollection & pndigicollection ,
 			  EcalRawDataCollection& DCCheaderCollection,
@@ -42,6 +56,12 @@ class EcalTBDaqFormatter   {
 			  EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
 			  EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection,
 			  EcalTrigPrimDigiCollection &tpcollection);
+
+  /// Drops the Pn digis of the Pn with a channel in memgaincollection or memchidcollection, as
+  /// interpretRawData does with the mem errors already in its collections (FEDs unpacked apart)
+  static void suppressPnDigis(EcalPnDiodeDigiCollection & pndigicollection,
+			      const EcalElectronicsIdCollection & memgaincollection,
+			      const EcalElectronicsIdCollection & memchidcollection);
  
 
  private:
@@ -49,6 +69,9 @@ class EcalTBDaqFormatter   {
   void  DecodeMEM( DCCTBTowerBlock *  towerblock, EcalPnDiodeDigiCollection & pndigicollection ,
 		   EcalElectronicsIdCollection & memttidcollection,  EcalElectronicsIdCollection &  memblocksizecollection,
 		   EcalElectronicsIdCollection & memgaincollection,  EcalElectronicsIdCollection & memchidcollection);
+  void  flagMemChannel(const EcalElectronicsId & id);
+  void  flagMemChannels(const EcalElectronicsIdCollection & idcollection);
+  static unsigned memChannelBits(const EcalElectronicsIdCollection & idcollection);
   
   std::pair<int,int>  cellIndex(int tower_id, int strip, int xtal); 
   int            cryIc(int tower_id, int strip, int xtal); 
@@ -57,6 +80,17 @@ class EcalTBDaqFormatter   {
 
  private:
   DCCTBDataParser* theParser_;
+  DCCTBParseContext* theContext_;
+  bool ownParser_;
+  EcalTBWarningAggregator* warnings_;
+  std::vector<uint16_t> xtalSamples_;   // samples of the current crystal
+  std::vector<DCCTBTriggerPrimitive> triggerPrimitives_;   // primitives of the current TCC block
+
+  // crystal number and EBDetId of the crystals (tower 1-68, strip and channel 1-5),
+  // computed once with cellIndex
+  void buildDetIdTables();
+  int cryIcs_[68][5][5];
+  EBDetId ebDetIds_[68][5][5];
 
   enum SMGeom_t {
      kModules = 4,           // Number of modules per supermodule
@@ -82,16 +116,15 @@ class EcalTBDaqFormatter   {
     kTriggerTowersAndMem  = 70    // Number of trigger towers block including mems
   };
 
-  // index and container for expected towers (according to DCC status)
-  unsigned _numExpectedTowers;
-  unsigned _ExpectedTowers[71];
+  // expected towers (according to DCC status) and index of the next one
+  DCCTBTowerStatus towerStatus_;
   unsigned _expTowersIndex;
 
   // used for mem boxes unpacking
   int    memRawSample_[kStripsPerTower][kChannelsPerStrip][ kSamplesPerChannel+1];       // store raw data for one mem
   int    data_MEM[500];                                                                                                                  // collects unpacked data for both mems 
   bool pnAllocated;
-  bool pnIsOkInBlock[kPnPerTowerBlock];
+  unsigned memChannelErrors_;                     // one bit per Pn of the mem box with a channel error
 
 };
 #endif
@@ -0,0 +1,85 @@
+#include "EcalTBWarningAggregator.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+
+static const char * categoryNames[EcalTBWarningAggregator::NCATEGORIES] = {
+  "TowerId", "TowerSize", "TowerStatus", "ChId", "GainZero", "GainSwitch"
+};
+
+
+// tower/strip/channel of a warning in one key
+static uint32_t locationKey(int tower, int strip, int channel){
+  return ((uint32_t) (tower & 0xFFFF) << 16) | ((uint32_t) (strip & 0xFF) << 8) | (uint32_t) (channel & 0xFF);
+}
+
+static bool moreWarnings(const std::pair<uint32_t, unsigned long> & a, const std::pair<uint32_t, unsigned long> & b){
+  return a.second > b.second || (a.second == b.second && a.first < b.first);
+}
+
+
+EcalTBWarningAggregator::EcalTBWarningAggregator(const std::string & prefix, unsigned maxMessages, unsigned summaryInterval) :
+  prefix_(prefix), maxMessages_(maxMessages), summaryInterval_(summaryInterval) {
+}
+
+
+void EcalTBWarningAggregator::setLimits(unsigned maxMessages, unsigned summaryInterval){
+  maxMessages_ = maxMessages;
+  summaryInterval_ = summaryInterval;
+}
+
+
+bool EcalTBWarningAggregator::report(warningCategory category, int tower, int strip, int channel){
+
+  Category & c = categories_[category];
+  if (++c.count <= maxMessages_) return true;
+
+  ++c.locations[locationKey(tower, strip, channel)];
+  if (++c.suppressed == summaryInterval_) summary(category);
+  return false;
+}
+
+
+void EcalTBWarningAggregator::merge(const EcalTBWarningAggregator & other){
+
+  for (unsigned i = 0; i < NCATEGORIES; ++i) {
+    const Category & o = other.categories_[i];
+    Category & c = categories_[i];
+    c.count += o.count;
+    c.suppressed += o.suppressed;
+    for (std::map<uint32_t, unsigned long>::const_iterator it = o.locations.begin(); it != o.locations.end(); ++it)
+      c.locations[it->first] += it->second;
+  }
+}
+
+
+void EcalTBWarningAggregator::summary(){
+
+  for (unsigned i = 0; i < NCATEGORIES; ++i)
+    if (categories_[i].suppressed > 0) summary((warningCategory) i);
+}
+
+
+// one message with the warnings not emitted, the locations with the most warnings first
+void EcalTBWarningAggregator::summary(warningCategory c){
+
+  Category & category = categories_[c];
+
+  std::vector< std::pair<uint32_t, unsigned long> > locations(category.locations.begin(), category.locations.end());
+  std::sort(locations.begin(), locations.end(), moreWarnings);
+
+  edm::LogWarning message(prefix_ + categoryNames[c]);
+  message << "@SUB=EcalTBWarningAggregator"
+	  << category.suppressed << " more warnings (" << category.count << " in all), by tower/strip/channel:";
+  for (unsigned i = 0; i < locations.size() && i < MAXLOCATIONS; ++i)
+    message << " " << (locations[i].first >> 16) << "/" << ((locations[i].first >> 8) & 0xFF) << "/" << (locations[i].first & 0xFF)
+	    << " x" << locations[i].second;
+  if (locations.size() > MAXLOCATIONS) message << " ...";
+
+  category.suppressed = 0;
+  category.locations.clear();
+}
@@ -0,0 +1,59 @@
+#ifndef EcalTBWarningAggregator_H
+#define EcalTBWarningAggregator_H
+/** \class EcalTBWarningAggregator
+ *
+ *  Rate limit of the warnings of the DAQ formatters: the warnings are counted
+ *  per category and per tower/strip/channel, the first maxMessages of a category
+ *  are emitted in full and the others are only counted, with one summary of the
+ *  counts by tower/strip/channel every summaryInterval of them and at the end
+ *  of the job. Each formatter unpacking in parallel counts with its own
+ *  aggregator (no lock), the counts of the threads are merged at the end of the
+ *  job.
+ */
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+
+class EcalTBWarningAggregator {
+
+ public:
+
+  enum warningCategory{ TOWERID, TOWERSIZE, TOWERSTATUS, CHID, GAINZERO, GAINSWITCH, NCATEGORIES };
+
+  /// Message categories of the warnings: prefix followed by TowerId, TowerSize, TowerStatus,
+  /// ChId, GainZero or GainSwitch
+  EcalTBWarningAggregator(const std::string & prefix, unsigned maxMessages = 10, unsigned summaryInterval = 1000);
+
+  /// Limits of every category (summaryInterval 0: summaries only at the end of the job)
+  void setLimits(unsigned maxMessages, unsigned summaryInterval);
+
+  /// Counts a warning of category for tower/strip/channel: true if its message is to be emitted
+  bool report(warningCategory category, int tower, int strip = 0, int channel = 0);
+
+  /// Adds the warnings counted by other (the aggregator of another unpacking thread)
+  void merge(const EcalTBWarningAggregator & other);
+
+  /// Emits the counts of the warnings not emitted since the last summary, for every category
+  void summary();
+
+ private:
+
+  enum { MAXLOCATIONS = 20 };          // locations listed in a summary
+
+  struct Category {
+    unsigned long count;                        // warnings of the category
+    unsigned long suppressed;                   // not emitted since the last summary
+    std::map<uint32_t, unsigned long> locations; // not emitted since the last summary, by tower/strip/channel
+    Category() : count(0), suppressed(0) { }
+  };
+
+  void summary(warningCategory category);
+
+  std::string prefix_;
+  unsigned maxMessages_;
+  unsigned summaryInterval_;
+  Category categories_[NCATEGORIES];
+};
+#endif
@@ -0,0 +1,157 @@
+/** \file
+ *  Checks the SSE2 kernels of the DCC parser (gain check, BOE scan, trigger primitive
+ *  decoding) and the PN sample bit reversal against plain scalar versions, on random
+ *  input of sizes that do not fill whole steps
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "EventFilter/EcalTBRawToDigi/src/DCCGainCheck.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCBOEScan.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCTriggerPrimitive.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCPnSample.h"
+
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+
+
+class testDCCKernels : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(testDCCKernels);
+  CPPUNIT_TEST(checkGainCheck);
+  CPPUNIT_TEST(checkBOEScan);
+  CPPUNIT_TEST(checkTriggerPrimitives);
+  CPPUNIT_TEST(checkPnReverse);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+
+  void setUp() { srand(12345); }
+  void tearDown() { }
+
+  void checkGainCheck();
+  void checkBOEScan();
+  void checkTriggerPrimitives();
+  void checkPnReverse();
+
+ private:
+
+  static uint32_t random32() { return ((uint32_t) (rand() & 0xFFFF) << 16) | (uint32_t) (rand() & 0xFFFF); }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(testDCCKernels);
+
+
+// crystals of numbSamples samples: checkXtals (SSE2 up to 56 samples) against checkXtal crystal by crystal
+void testDCCKernels::checkGainCheck() {
+
+  const uint32_t sampleCounts[] = { 1, 2, 3, 5, 7, 8, 9, 10, 15, 16, 17, 31, 56, 57 };
+  const uint32_t xtalCounts[]   = { 1, 2, 3, 25, 1700 };
+
+  for (unsigned s = 0; s < sizeof(sampleCounts)/sizeof(sampleCounts[0]); ++s) {
+    for (unsigned x = 0; x < sizeof(xtalCounts)/sizeof(xtalCounts[0]); ++x) {
+      uint32_t numbSamples = sampleCounts[s];
+      uint32_t numbXtals   = xtalCounts[x];
+
+      // gain 1 to 3 with a few gain==0 samples, crystals with and without gain switches
+      std::vector<uint16_t> samples(numbXtals*numbSamples);
+      for (uint32_t c = 0; c < numbXtals; ++c) {
+	bool switches = rand() % 2;
+	uint16_t gain = 1;
+	for (uint32_t i = 0; i < numbSamples; ++i) {
+	  if (switches) gain = 1 + rand() % 3;
+	  else if (rand() % 8 == 0 && gain < 3) ++gain;
+	  uint16_t sample = (gain << DCCTBGainCheck::GAINBPOSITION) | (rand() & 0xFFF);
+	  if (rand() % 64 == 0) sample &= ~DCCTBGainCheck::GAINMASK;
+	  samples[c*numbSamples + i] = sample;
+	}
+      }
+
+      std::vector<uint8_t> gainZero(numbXtals + 1, 0xAA), gainSwitches(numbXtals + 1, 0xAA);
+      DCCTBGainCheck::checkXtals(&samples[0], numbXtals, numbSamples, &gainZero[0], &gainSwitches[0]);
+
+      for (uint32_t c = 0; c < numbXtals; ++c) {
+	bool zero;
+	uint32_t switches;
+	DCCTBGainCheck::checkXtal(&samples[c*numbSamples], numbSamples, zero, switches);
+	CPPUNIT_ASSERT_EQUAL((int) zero, (int) gainZero[c]);
+	CPPUNIT_ASSERT_EQUAL(switches, (uint32_t) gainSwitches[c]);
+      }
+      // nothing written after the last crystal
+      CPPUNIT_ASSERT_EQUAL(0xAA, (int) gainZero[numbXtals]);
+      CPPUNIT_ASSERT_EQUAL(0xAA, (int) gainSwitches[numbXtals]);
+    }
+  }
+}
+
+
+// BOE nibble in the 2nd 32 bit word of a 64 bit word only, found at any position of buffers of any length
+void testDCCKernels::checkBOEScan() {
+
+  for (uint32_t numbDWords = 0; numbDWords < 40; ++numbDWords) {
+    for (unsigned trial = 0; trial < 50; ++trial) {
+
+      std::vector<uint32_t> words(2*numbDWords + 2);
+      for (uint32_t w = 0; w < words.size(); ++w) {
+	words[w] = random32();
+	if ((words[w] >> DCCTBBOEScan::BOEBEGIN) == DCCTBBOEScan::BOE) words[w] ^= 0x80000000;
+      }
+      // BOE nibbles in the 1st 32 bit words are not markers
+      for (uint32_t w = 0; w < words.size(); w += 2)
+	if (rand() % 4 == 0) words[w] = (DCCTBBOEScan::BOE << DCCTBBOEScan::BOEBEGIN) | (words[w] & 0x0FFFFFFF);
+      if (numbDWords > 0 && trial % 5) {
+	uint32_t dw = rand() % numbDWords;
+	words[2*dw+1] = (DCCTBBOEScan::BOE << DCCTBBOEScan::BOEBEGIN) | (words[2*dw+1] & 0x0FFFFFFF);
+      }
+
+      // from every start, as resyncEvent calls it
+      for (uint32_t from = 0; from <= numbDWords; ++from) {
+	uint32_t expected = numbDWords - from;
+	for (uint32_t dw = from; dw < numbDWords; ++dw) {
+	  if ((words[2*dw+1] >> DCCTBBOEScan::BOEBEGIN) == DCCTBBOEScan::BOE) { expected = dw - from; break; }
+	}
+	CPPUNIT_ASSERT_EQUAL(expected, DCCTBBOEScan::findBOE(&words[2*from], numbDWords - from));
+      }
+    }
+  }
+}
+
+
+// two 12 bit primitives per 32 bit word from word TPWPOSITION, the first in the low half
+void testDCCKernels::checkTriggerPrimitives() {
+
+  for (uint32_t numbTTs = 0; numbTTs <= 70; ++numbTTs) {
+
+    std::vector<uint32_t> tccBlock(DCCTBTriggerPrimitive::TPWPOSITION + (numbTTs + 1)/2 + 1);
+    for (uint32_t w = 0; w < tccBlock.size(); ++w) tccBlock[w] = random32();
+
+    std::vector<DCCTBTriggerPrimitive> tps(numbTTs + 1);
+    tps[numbTTs].data = 0xBEEF;
+    DCCTBTriggerPrimitive::decode(&tccBlock[0], numbTTs, &tps[0]);
+
+    for (uint32_t tt = 0; tt < numbTTs; ++tt) {
+      uint32_t word = tccBlock[DCCTBTriggerPrimitive::TPWPOSITION + tt/2];
+      uint32_t data = (tt % 2 ? word >> 16 : word) & DCCTBTriggerPrimitive::DATAMASK;
+      CPPUNIT_ASSERT_EQUAL(data, (uint32_t) tps[tt].data);
+      CPPUNIT_ASSERT_EQUAL((int) (data & 0xFF), tps[tt].et());
+      CPPUNIT_ASSERT_EQUAL((int) ((data >> 9) & 0x7), tps[tt].ttf());
+    }
+    CPPUNIT_ASSERT_EQUAL(0xBEEF, (int) tps[numbTTs].data);
+  }
+}
+
+
+// swap network against a bit by bit reversal of the 14 bits, bits above them ignored
+void testDCCKernels::checkPnReverse() {
+
+  for (uint32_t raw = 0; raw < 0x10000; ++raw) {
+    uint32_t expected = 0;
+    for (int bit = 0; bit < 14; ++bit)
+      if (raw & (1u << bit)) expected |= 1u << (13 - bit);
+
+    CPPUNIT_ASSERT_EQUAL(expected, DCCTBPnSample::reverse(raw | (random32() & 0xFFFF0000)));
+    CPPUNIT_ASSERT_EQUAL((int) ((expected ^ 0x800) & 0x3FFF), DCCTBPnSample::decode(raw, true));
+    CPPUNIT_ASSERT_EQUAL((int) ((raw ^ 0x800) & 0x3FFF), DCCTBPnSample::decode(raw, false));
+  }
+}
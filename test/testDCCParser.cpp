@@ -0,0 +1,255 @@
+/** \file
+ *  Checks the DCC parser on synthetic events: the flat decoding (decodeToSoA) must
+ *  give the same towers, xtal ids, samples and trigger primitives as the block
+ *  objects built by parseBuffer on the same buffer, and with resync on corrupted
+ *  event lengths must be skipped the same way in buffers and in raw files
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "EventFilter/EcalTBRawToDigi/src/DCCDataParser.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCEventBlock.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCTowerBlock.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCXtalBlock.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCTCCBlock.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCEventSoA.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCParseContext.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCEventIndex.h"
+#include "EventFilter/EcalTBRawToDigi/src/DCCRawFileReader.h"
+#include "EventFilter/EcalTBRawToDigi/src/ECALParserException.h"
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+
+
+class testDCCParser : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(testDCCParser);
+  CPPUNIT_TEST(checkSoAMatchesBlocks);
+  CPPUNIT_TEST(checkResync);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+
+  void setUp() { }
+  void tearDown() { }
+
+  void checkSoAMatchesBlocks();
+  void checkResync();
+
+ private:
+
+  static void appendEvent(std::vector<uint32_t> & words, uint32_t lv1, uint32_t triggerType, bool zs, uint32_t longTower);
+  static std::vector<uint32_t> fileLV1s(DCCTBDataParser & parser, DCCTBRawFileReader & reader);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(testDCCParser);
+
+
+// one event of the test beam DCC (10 samples, 1 TCC block): 68 towers for a physics
+// trigger, 70 (with the mem boxes) for a calibration trigger, 25 xtals per tower but
+// 26 in tower longTower (0 for none)
+void testDCCParser::appendEvent(std::vector<uint32_t> & words, uint32_t lv1, uint32_t triggerType, bool zs, uint32_t longTower) {
+
+  uint32_t numbChannels = triggerType == 1 ? 68 : 70;
+  uint32_t length = 9 + 6 + 18 + numbChannels*76 + 1 + (longTower ? 3 : 0);
+
+  // DCC header: TCC1 and the SRP block enabled, TCC2..4 disabled, all the channels enabled
+  words.push_back( (1u<<3) | (2u<<4) | (7u<<8) | (123u<<20) );
+  words.push_back( (lv1&0xFFFFFF) | (triggerType<<24) | (5u<<28) );
+  words.push_back( length );
+  words.push_back( 4242u | (1u<<24) );
+  words.push_back( 0x00010203u );
+  words.push_back( 5u | (2u<<24) );
+  words.push_back( 999u );
+  words.push_back( (zs ? 0x2u : 0x0u) | (1u<<12) | (1u<<16) | (1u<<20) | (3u<<24) );
+  for(uint32_t i=0; i<5; i++){ words.push_back(0); words.push_back( (4+i)<<24 ); }
+
+  // SRP block: every tower read out
+  words.push_back( 1u | (123u<<16) ); words.push_back( (lv1&0xFFF) | (68u<<16) );
+  for(uint32_t i=0; i<10; i++){ words.push_back( (0x3FFFu) | (0x3FFFu<<16) | (4u<<29) ); }
+
+  // TCC block
+  words.push_back( 1u | (123u<<16) ); words.push_back( (lv1&0xFFF) | (68u<<16) | (1u<<23) );
+  for(uint32_t i=0; i<34; i++){ words.push_back( ((i*7+lv1)&0xFFF) | (((i*13+lv1)&0xFFF)<<16) | (3u<<29) ); }
+
+  // tower blocks
+  for(uint32_t t=1; t<=numbChannels; t++){
+    uint32_t numbXtals = t == longTower ? 26 : 25;
+    words.push_back( t | (10u<<8) | (123u<<16) ); words.push_back( ((lv1-1)&0xFFF) | ((1+numbXtals*3)<<16) );
+    for(uint32_t x=0; x<numbXtals; x++){
+      uint32_t samples[10];
+      for(uint32_t i=0; i<10; i++){ samples[i] = ((lv1+t*31+x*7+i*3)&0xFFF) | (1u<<12); }
+      words.push_back( (x%25/5+1) | ((x%5+1)<<4) | (samples[0]<<16) | (3u<<30) );
+      for(uint32_t i=1; i<9; i+=2){ words.push_back( samples[i] | (samples[i+1]<<16) | (3u<<30) ); }
+      words.push_back( samples[9] | (3u<<30) );
+    }
+  }
+
+  // trailer
+  words.push_back(0); words.push_back( length | (0xAu<<28) );
+}
+
+
+// physics and calibration events, with and without ZS, one of them with a tower of 26 xtals:
+// both decodings flatten to the same words, the long tower is flagged by both and cut at 25 xtals
+void testDCCParser::checkSoAMatchesBlocks() {
+
+  std::vector<uint32_t> buffer;
+  appendEvent(buffer, 100, 1, false, 0);
+  appendEvent(buffer, 101, 2, false, 0);
+  appendEvent(buffer, 102, 1, true,  7);
+  appendEvent(buffer, 103, 1, false, 9);
+
+  DCCTBDataParser parser(DCCTBDataParser::defaultParameters(), true, false);
+
+  std::vector<uint32_t> blockWords, soaWords;
+  std::vector<std::pair<uint32_t,uint32_t> > blockLong, soaLong;
+
+  parser.parseBuffer(&buffer[0], buffer.size()*4);
+  std::vector<DCCTBEventBlock *> & events = parser.dccEvents();
+  CPPUNIT_ASSERT_EQUAL((size_t) 4, events.size());
+
+  for(uint32_t e=0; e<events.size(); e++){
+    blockWords.push_back( events[e]->getDataField(DCCTBDataMapper::LV1_ID) );
+
+    std::vector<DCCTBTCCBlock *> & tccBlocks = events[e]->tccBlocks();
+    for(uint32_t i=0; i<tccBlocks.size(); i++){
+      std::vector< std::pair<int,bool> > samples = tccBlocks[i]->triggerSamples();
+      std::vector<int> flags = tccBlocks[i]->triggerFlags();
+      for(uint32_t tt=0; tt<samples.size(); tt++){
+        blockWords.push_back(samples[tt].first); blockWords.push_back(samples[tt].second); blockWords.push_back(flags[tt]);
+      }
+    }
+
+    std::vector<DCCTBTowerBlock *> & towers = events[e]->towerBlocks();
+    for(uint32_t t=0; t<towers.size(); t++){
+      std::vector<DCCTBXtalBlock *> & xtals = towers[t]->xtalBlocks();
+      blockWords.push_back( towers[t]->towerID() );
+      blockWords.push_back( xtals.size() );
+      if( towers[t]->tooLong() ){ blockLong.push_back( std::make_pair(e, (uint32_t) towers[t]->towerID()) ); }
+      for(uint32_t c=0; c<xtals.size(); c++){
+        std::vector<int> samples = xtals[c]->xtalDataSamples();
+        blockWords.push_back( xtals[c]->stripID() ); blockWords.push_back( xtals[c]->xtalID() );
+        blockWords.insert( blockWords.end(), samples.begin(), samples.end() );
+      }
+    }
+  }
+
+  parser.decodeToSoA(&buffer[0], buffer.size()*4);
+  std::vector<DCCTBEventSoA *> & soaEvents = parser.soaEvents();
+  CPPUNIT_ASSERT_EQUAL((size_t) 4, soaEvents.size());
+
+  for(uint32_t e=0; e<soaEvents.size(); e++){
+    DCCTBEventSoA * event = soaEvents[e];
+    soaWords.push_back( event->getDataField(DCCTBDataMapper::LV1_ID) );
+
+    for(uint32_t i=0; i<event->numbTCCBlocks(); i++){
+      for(uint32_t tt=0; tt<event->numbTTs(); tt++){
+        std::pair<int,bool> sample = event->triggerSample(i, tt);
+        soaWords.push_back(sample.first); soaWords.push_back(sample.second); soaWords.push_back( event->triggerFlag(i, tt) );
+      }
+    }
+
+    for(uint32_t t=0; t<event->numbTowers(); t++){
+      soaWords.push_back( event->towerID(t) );
+      soaWords.push_back( event->numbXtals(t) );
+      if( event->towerErrors(t) & DCCTBEventSoA::TOOLONG_ERROR ){ soaLong.push_back( std::make_pair(e, event->towerID(t)) ); }
+      for(uint32_t c=0; c<event->numbXtals(t); c++){
+        const uint16_t * samples = event->xtalDataSamples(t, c);
+        soaWords.push_back( event->stripID(t, c) ); soaWords.push_back( event->xtalID(t, c) );
+        soaWords.insert( soaWords.end(), samples, samples + event->numbXtalSamples() );
+      }
+    }
+  }
+
+  CPPUNIT_ASSERT( blockWords.size() > 4*68*25*10 );
+  CPPUNIT_ASSERT( blockWords == soaWords );
+
+  CPPUNIT_ASSERT_EQUAL((size_t) 2, blockLong.size());
+  CPPUNIT_ASSERT( blockLong[0] == std::make_pair(2u, 7u) );
+  CPPUNIT_ASSERT( blockLong[1] == std::make_pair(3u, 9u) );
+  CPPUNIT_ASSERT( blockLong == soaLong );
+}
+
+
+// lv1 of the events indexed from the file of reader
+std::vector<uint32_t> testDCCParser::fileLV1s(DCCTBDataParser & parser, DCCTBRawFileReader & reader) {
+
+  DCCTBEventIndex index;
+  index.build(parser, reader);
+
+  std::vector<uint32_t> lv1s;
+  for(uint32_t i=0; i<index.numbEvents(); i++){ lv1s.push_back( index.entry(i).lv1 ); }
+  return lv1s;
+}
+
+
+// 6 events, the 2nd with a zeroed event length and the 4th with an event length past the
+// end of the data: with resync the buffer, the binary file and the text file all give the
+// 1st, 3rd, 5th and 6th events and skip the two corrupted ones, without resync the file throws
+void testDCCParser::checkResync() {
+
+  std::vector<uint32_t> buffer;
+  std::vector<uint32_t> starts;
+  for(uint32_t e=0; e<6; e++){
+    starts.push_back( buffer.size() );
+    appendEvent(buffer, 200+e, 1, false, 0);
+  }
+  starts.push_back( buffer.size() );
+  buffer[starts[1]+2] = 0;
+  buffer[starts[3]+2] = 0xFFFFFF;
+
+  std::vector<uint32_t> expectedLV1s;
+  expectedLV1s.push_back(200); expectedLV1s.push_back(202); expectedLV1s.push_back(204); expectedLV1s.push_back(205);
+
+  DCCTBDataParser parser(DCCTBDataParser::defaultParameters(), true, false, false, true);
+
+  // buffer
+  DCCTBParseContext context;
+  parser.parseBuffer(context, &buffer[0], buffer.size()*4);
+
+  std::vector<uint32_t> bufferLV1s;
+  for(uint32_t e=0; e<context.dccEvents().size(); e++){ bufferLV1s.push_back( context.dccEvents()[e]->getDataField(DCCTBDataMapper::LV1_ID) ); }
+  CPPUNIT_ASSERT( bufferLV1s == expectedLV1s );
+
+  std::vector< std::pair<uint32_t,uint32_t> > & ranges = context.skippedRanges();
+  CPPUNIT_ASSERT_EQUAL((size_t) 2, ranges.size());
+  CPPUNIT_ASSERT( ranges[0] == std::make_pair(starts[1]*4, (starts[2]-starts[1])*4) );
+  CPPUNIT_ASSERT( ranges[1] == std::make_pair(starts[3]*4, (starts[4]-starts[3])*4) );
+
+  // binary and text files (9 bytes of text per word)
+  std::string binaryName = "testDCCParserResync.bin";
+  std::string textName   = "testDCCParserResync.txt";
+
+  FILE * binaryFile = fopen(binaryName.c_str(), "wb");
+  FILE * textFile   = fopen(textName.c_str(), "w");
+  CPPUNIT_ASSERT( binaryFile && textFile );
+  fwrite(&buffer[0], 4, buffer.size(), binaryFile);
+  for(uint32_t i=0; i<buffer.size(); i++){ fprintf(textFile, "%08x\n", buffer[i]); }
+  fclose(binaryFile);
+  fclose(textFile);
+
+  const char * names[2] = { binaryName.c_str(), textName.c_str() };
+  uint64_t bytesPerWord[2] = { 4, 9 };
+
+  for(uint32_t f=0; f<2; f++){
+    DCCTBRawFileReader reader(names[f]);
+    CPPUNIT_ASSERT( fileLV1s(parser, reader) == expectedLV1s );
+
+    std::vector< std::pair<uint64_t,uint64_t> > & fileRanges = reader.skippedRanges();
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, fileRanges.size());
+    CPPUNIT_ASSERT( fileRanges[0] == std::make_pair(starts[1]*bytesPerWord[f], (starts[2]-starts[1])*bytesPerWord[f]) );
+    CPPUNIT_ASSERT( fileRanges[1] == std::make_pair(starts[3]*bytesPerWord[f], (starts[4]-starts[3])*bytesPerWord[f]) );
+
+    DCCTBDataParser strictParser(DCCTBDataParser::defaultParameters(), true, false);
+    CPPUNIT_ASSERT_THROW( fileLV1s(strictParser, reader), ECALTBParserException );
+  }
+
+  unlink(binaryName.c_str());
+  unlink(textName.c_str());
+}